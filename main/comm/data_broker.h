@@ -27,9 +27,16 @@ namespace eobsws::comm {
         OutboundWired = (1 << 2), /**< wired outbound message */
         InboundWireless = (1 << 1), /**< wireless inbound message */
         OutboundWireless = (1 << 3), /**< wireless outbound message */
-        Event = (1 << 4) /**< event message */
+        Event = (1 << 4), /**< event message */
+        ConfigChanged = (1 << 5), /**< configuration change notification; data is the changed NVS namespace, a file path, or "*" */
+        TargetAny = 0xff00 /**< any target; bit 8+n addresses target n (e.g. OBS session n) */
     };
 
+    /** \var constexpr uint8_t MaxTargets
+     *  \brief Number of targets that can be addressed with target tags.
+     */
+    constexpr uint8_t MaxTargets = 8;
+
     /** \fn static bool operator&(MessageType & m1, MessageType & m2)
      *  \brief Boolean & operator for MessageType arguments.
      *  \param m1,m2: operands.
@@ -39,6 +46,50 @@ namespace eobsws::comm {
         return static_cast<MessageType>(static_cast<uint16_t>(m1) & static_cast<uint16_t>(m2));
     }
 
+    /** \fn static inline MessageType operator|(MessageType m1, MessageType m2)
+     *  \brief Boolean | operator for MessageType arguments.
+     *  \param m1,m2: operands.
+     *  \returns MessageType resulting from union of m1 and m2.
+     */
+    static inline MessageType operator|(MessageType m1, MessageType m2) {
+        return static_cast<MessageType>(static_cast<uint16_t>(m1) | static_cast<uint16_t>(m2));
+    }
+
+    /** \fn static inline MessageType target_tag(uint8_t target)
+     *  \brief Get tag addressing a given target.
+     *  \param target: target index (0 to MaxTargets-1).
+     *  \returns tag to combine with a channel type.
+     */
+    static inline MessageType target_tag(uint8_t target) {
+        return static_cast<MessageType>(1 << (8 + target % MaxTargets));
+    }
+
+    /** \fn static inline MessageType target_mask(uint8_t targets)
+     *  \brief Get tag addressing a set of targets.
+     *  \param targets: bit mask of targets (bit n = target n).
+     *  \returns tag to combine with a channel type.
+     */
+    static inline MessageType target_mask(uint8_t targets) {
+        return static_cast<MessageType>(static_cast<uint16_t>(targets) << 8);
+    }
+
+    /** \fn static inline bool accepts(MessageType filter, MessageType t)
+     *  \brief Tell if a node accepting messages of type filter takes a message of type t.
+     *  Channels must intersect; targets must intersect too if both sides carry target tags.
+     *  An untagged side matches any target.
+     *  \param filter: message type accepted by node.
+     *  \param t: message type.
+     *  \returns true if message is accepted, false otherwise.
+     */
+    static inline bool accepts(MessageType filter, MessageType t) {
+        constexpr uint16_t targets = static_cast<uint16_t>(MessageType::TargetAny);
+        auto f = static_cast<uint16_t>(filter);
+        auto m = static_cast<uint16_t>(t);
+        if ((f & m & ~targets) == 0) return false;
+        if ((f & targets) == 0 || (m & targets) == 0) return true;
+        return (f & m & targets) != 0;
+    }
+
     /** \class PublisherTemplate
      *  \brief Base template for publisher class.
      *  It defines a publisher issuing data in a form given
@@ -104,6 +155,22 @@ namespace eobsws::comm {
             return false;
         }
 
+        /** \fn bool broadcast(Args... args)
+         *  \brief Publish data to all registered callbacks, without stopping at the
+         *  first one accepting it. This is used to fan messages out to several targets.
+         *  \param args: arguments as defined by template specialization
+         *  \returns true if at least one callback accepted data, false otherwise.
+         */
+        bool broadcast(Args... args) {
+            bool accepted = false;
+            for (auto & cb: this->callbacks)
+                if (cb.get()!=nullptr && (*cb)(args...))
+                    accepted = true;
+            if (!accepted)
+                ESP_LOGI("DataBroker", "data not accepted by any node!");
+            return accepted;
+        }
+
     };
 
     /** \class DataBroker
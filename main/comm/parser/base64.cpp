@@ -0,0 +1,108 @@
+/** \file base64.cpp
+ *  \brief Implementation file for base64 codec.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "base64.h"
+#include <array>
+
+namespace eobsws::comm::parser::base64 {
+
+    /** \var static constexpr char Alphabet[]
+     *  \brief Base64 alphabet; character n encodes 6-bit value n.
+     */
+    static constexpr char Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    /** \var static constexpr uint8_t Invalid
+     *  \brief Decoding table entry of characters outside alphabet.
+     */
+    static constexpr uint8_t Invalid = 0xff;
+
+    /** \var static constexpr char Padding
+     *  \brief Padding character.
+     */
+    static constexpr char Padding = '=';
+
+    /** \fn static constexpr std::array<uint8_t, 256> make_decoding_table()
+     *  \brief Build table giving 6-bit value of each character, or Invalid.
+     *  \returns decoding table.
+     */
+    static constexpr std::array<uint8_t, 256> make_decoding_table() {
+        std::array<uint8_t, 256> table{};
+        for (auto & value: table) value = Invalid;
+        for (uint8_t n=0; n<64; n++)
+            table[static_cast<uint8_t>(Alphabet[n])] = n;
+        return table;
+    }
+
+    /** \var static constexpr std::array<uint8_t, 256> DecodingTable
+     *  \brief Table giving 6-bit value of each character, or Invalid.
+     */
+    static constexpr std::array<uint8_t, 256> DecodingTable = make_decoding_table();
+
+    /** \fn static inline void encode_word(uint32_t word, char * out)
+     *  \brief Encode a 24-bit word as 4 characters.
+     *  \param word: word to encode.
+     *  \param out: output buffer.
+     */
+    static inline void encode_word(uint32_t word, char * out) {
+        out[0] = Alphabet[word >> 18];
+        out[1] = Alphabet[(word >> 12) & 0x3f];
+        out[2] = Alphabet[(word >> 6) & 0x3f];
+        out[3] = Alphabet[word & 0x3f];
+    }
+
+
+    size_t encode(const uint8_t * data, size_t len, char * out) {
+        auto start = out;
+        size_t n = 0;
+        for (; n + 3 <= len; n += 3, out += 4)
+            encode_word((data[n] << 16) | (data[n+1] << 8) | data[n+2], out);
+        if (n < len) {
+            // 1 or 2 bytes left: characters beyond them are replaced with padding
+            bool two = n + 1 < len;
+            encode_word((data[n] << 16) | (two ? data[n+1] << 8 : 0), out);
+            if (!two) out[2] = Padding;
+            out[3] = Padding;
+            out += 4;
+        }
+        return out - start;
+    }
+
+    bool decode(std::string_view data, uint8_t * out, size_t & len) {
+        len = 0;
+        if (data.size() % 4) return false;
+        auto in = reinterpret_cast<const uint8_t*>(data.data());
+        auto start = out;
+        // last 4 characters are decoded apart if they hold padding
+        auto full = data.size();
+        if (full > 0 && data.back() == Padding) full -= 4;
+        for (size_t n = 0; n < full; n += 4, out += 3) {
+            auto a = DecodingTable[in[n]];
+            auto b = DecodingTable[in[n+1]];
+            auto c = DecodingTable[in[n+2]];
+            auto d = DecodingTable[in[n+3]];
+            // Invalid has its high bit set, no 6-bit value has
+            if ((a | b | c | d) & 0x80) return false;
+            uint32_t word = (a << 18) | (b << 12) | (c << 6) | d;
+            out[0] = static_cast<uint8_t>(word >> 16);
+            out[1] = static_cast<uint8_t>(word >> 8);
+            out[2] = static_cast<uint8_t>(word);
+        }
+        if (full < data.size()) {
+            // either xx== (1 byte) or xxx= (2 bytes)
+            bool two = in[full+2] != Padding;
+            auto a = DecodingTable[in[full]];
+            auto b = DecodingTable[in[full+1]];
+            auto c = two ? DecodingTable[in[full+2]] : 0;
+            if ((a | b | c) & 0x80) return false;
+            uint32_t word = (a << 18) | (b << 12) | (c << 6);
+            *out++ = static_cast<uint8_t>(word >> 16);
+            if (two) *out++ = static_cast<uint8_t>(word >> 8);
+        }
+        len = out - start;
+        return true;
+    }
+
+}
@@ -0,0 +1,54 @@
+/** \file base64.h
+ *  \brief Header file for base64 codec used by serial text transfers.
+ *  Data is processed 3 bytes (one 24-bit word, 4 characters) at a time with lookup
+ *  tables, and written to buffers provided by caller, so that large transfers can be
+ *  encoded or decoded block by block without memory allocations.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/** \namespace eobsws::comm::parser::base64
+ *  \brief Base64 codec (RFC 4648 standard alphabet, with padding).
+ */
+namespace eobsws::comm::parser::base64 {
+
+  /** \fn constexpr size_t encoded_size(size_t len)
+   *  \brief Compute length of base64 encoding of given number of bytes, padding included.
+   *  \param len: number of bytes.
+   *  \returns number of characters.
+   */
+  constexpr size_t encoded_size(size_t len) { return 4*((len + 2)/3); }
+
+  /** \fn constexpr size_t decoded_size(size_t len)
+   *  \brief Compute largest number of bytes that given number of characters can encode.
+   *  \param len: number of characters.
+   *  \returns number of bytes (less if input is padded).
+   */
+  constexpr size_t decoded_size(size_t len) { return len/4*3; }
+
+  /** \fn size_t encode(const uint8_t * data, size_t len, char * out)
+   *  \brief Encode bytes in base64.
+   *  \param data: bytes to encode.
+   *  \param len: number of bytes.
+   *  \param out: output buffer, holding at least encoded_size(len) characters; no
+   *  terminating null character is written.
+   *  \returns number of characters written.
+   */
+  size_t encode(const uint8_t * data, size_t len, char * out);
+
+  /** \fn bool decode(std::string_view data, uint8_t * out, size_t & len)
+   *  \brief Decode base64 characters. Only the last 4 characters may hold padding, so a
+   *  long input can be decoded in slices of multiples of 4 characters.
+   *  \param data: characters to decode; length must be a multiple of 4.
+   *  \param out: output buffer, holding at least decoded_size(data.size()) bytes.
+   *  \param len: number of bytes written.
+   *  \returns true if data is valid base64, false otherwise (output is then unspecified).
+   */
+  bool decode(std::string_view data, uint8_t * out, size_t & len);
+
+}
@@ -19,7 +19,7 @@ namespace eobsws::comm::parser {
   }
 
   bool OBSParser::publish_callback(MessageType t, const std::string & data) {
-    if ((t & this->in_message_type) == MessageType::NoOutlet) return false;
+    if (!accepts(this->in_message_type, t)) return false;
 
     cJSON * js = cJSON_Parse(data.c_str());
     if (js == nullptr)
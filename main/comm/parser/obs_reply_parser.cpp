@@ -17,7 +17,7 @@ namespace eobsws::comm::parser {
     }
 
     bool OBSReplyParser::publish_callback(MessageType t, const std::string & data) {
-        if ((t & this->in_message_type) == MessageType::NoOutlet) return false;
+        if (!accepts(this->in_message_type, t)) return false;
 
         // check that data is indeed JSON
         cJSON * js = cJSON_Parse(data.c_str());
@@ -57,12 +57,12 @@ namespace eobsws::comm::parser {
         stub.lock()->abort();
     }
 
-    /** \fn std::shared_ptr<ParserStub> find_stub_for_command(const std::string & cmd) const
+    /** \fn std::shared_ptr<ParserStub> find_stub_for_command(std::string_view cmd) const
      *  \brief Find stub adequate for given command, within registered parser stubs.
      *  \param cmd: command string.
      *  \returns pointer to found stub, or nullptr if none was found.
      */
-    std::shared_ptr<ParserStub> find_stub_for_command(const std::string & cmd) const {
+    std::shared_ptr<ParserStub> find_stub_for_command(std::string_view cmd) const {
       auto pred = [cmd](auto pr) -> bool { return pr.lock()->can_handle_command(cmd); };
       auto pr_it = std::find_if(std::begin(this->stubs), std::end(this->stubs), pred);
       return (pr_it == std::end(this->stubs)) ? nullptr : (*pr_it).lock();
@@ -6,6 +6,7 @@
  */
 #pragma once
 #include <memory>
+#include <string_view>
 #include "esp_log.h"
 #include "../data_broker.h"
 
@@ -66,13 +67,13 @@ namespace eobsws::comm::parser {
          */
         virtual ParserTuple parse(const std::string & data) = 0;
 
-        /** \fn virtual bool can_handle_command(const std::string & cmd)
+        /** \fn virtual bool can_handle_command(std::string_view cmd)
          *  \brief Tell if parser stub can handle command.
          *  \param cmd: command.
          *  \returns true if stub can handle command, false otherwise.
          */
-        virtual bool can_handle_command(const std::string & cmd) {
-            ESP_LOGI("ParserStub", "takes command %s, received %s", this->command.c_str(), cmd.c_str());
+        virtual bool can_handle_command(std::string_view cmd) {
+            ESP_LOGI("ParserStub", "takes command %s, received %.*s", this->command.c_str(), static_cast<int>(cmd.size()), cmd.data());
             return this->command == cmd;
         }
 
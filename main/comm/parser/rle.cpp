@@ -0,0 +1,74 @@
+/** \file rle.cpp
+ *  \brief Implementation file for run-length codec of screen snapshots.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "rle.h"
+
+namespace eobsws::comm::parser::rle {
+
+    /** \var static constexpr size_t MaxLiteral
+     *  \brief Maximum number of pixels in a literal run.
+     */
+    static constexpr size_t MaxLiteral = 128;
+
+    /** \var static constexpr size_t MaxRun
+     *  \brief Maximum number of pixels in a repeat or copy run.
+     */
+    static constexpr size_t MaxRun = 64;
+
+    /** \var static constexpr uint8_t RepeatLeft
+     *  \brief Control byte of a run repeating the pixel on the left (plus run length - 1).
+     */
+    static constexpr uint8_t RepeatLeft = 0x80;
+
+    /** \var static constexpr uint8_t CopyAbove
+     *  \brief Control byte of a run copying the row above (plus run length - 1).
+     */
+    static constexpr uint8_t CopyAbove = 0xc0;
+
+    /** \fn static inline bool same_color(uint32_t a, uint32_t b)
+     *  \brief Compare colors, ignoring alpha channel.
+     *  \param a: first color.
+     *  \param b: second color.
+     *  \returns true if colors are the same, false otherwise.
+     */
+    static inline bool same_color(uint32_t a, uint32_t b) {
+        return ((a ^ b) & 0xffffff) == 0;
+    }
+
+
+    size_t encode_row(const uint32_t * row, const uint32_t * above, size_t width, uint8_t * out) {
+        auto start = out;
+        uint8_t * literal = nullptr; // control byte of pending literal run
+        size_t x = 0;
+        while (x < width) {
+            size_t copy = 0, repeat = 0;
+            if (above != nullptr)
+                while (x + copy < width && copy < MaxRun && same_color(row[x + copy], above[x + copy])) copy++;
+            if (x > 0)
+                while (x + repeat < width && repeat < MaxRun && same_color(row[x + repeat], row[x - 1])) repeat++;
+            if (copy > 0 || repeat > 0) {
+                // a run costs 1 byte, less than any pixel in a literal run
+                literal = nullptr;
+                auto len = copy >= repeat ? copy : repeat;
+                *out++ = (copy >= repeat ? CopyAbove : RepeatLeft) | (len - 1);
+                x += len;
+                continue;
+            }
+            if (literal == nullptr || *literal == MaxLiteral - 1) {
+                literal = out++;
+                *literal = 0;
+            } else {
+                (*literal)++;
+            }
+            *out++ = static_cast<uint8_t>(row[x] >> 16);
+            *out++ = static_cast<uint8_t>(row[x] >> 8);
+            *out++ = static_cast<uint8_t>(row[x]);
+            x++;
+        }
+        return out - start;
+    }
+
+}
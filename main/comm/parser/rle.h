@@ -0,0 +1,41 @@
+/** \file rle.h
+ *  \brief Header file for run-length codec of screen snapshots.
+ *  Rows are coded one at a time against the row above, so that areas of uniform
+ *  color and areas repeating the row above (most of a user interface) shrink to a
+ *  byte per run, and a snapshot can be streamed row by row with a small buffer.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/** \namespace eobsws::comm::parser::rle
+ *  \brief Run-length codec for screen snapshots. A coded row is a sequence of runs,
+ *  each starting with a control byte c:
+ *    - 0x00-0x7f: c+1 literal pixels follow, as 3 bytes each (red, green, blue);
+ *    - 0x80-0xbf: c-0x7f pixels repeat the pixel on their left;
+ *    - 0xc0-0xff: c-0xbf pixels are the same as in the row above.
+ *  Runs don't cross rows.
+ */
+namespace eobsws::comm::parser::rle {
+
+  /** \fn constexpr size_t max_row_size(size_t width)
+   *  \brief Compute largest size of a coded row (every pixel in literal runs).
+   *  \param width: number of pixels in row.
+   *  \returns number of bytes.
+   */
+  constexpr size_t max_row_size(size_t width) { return 3*width + (width + 127)/128; }
+
+  /** \fn size_t encode_row(const uint32_t * row, const uint32_t * above, size_t width, uint8_t * out)
+   *  \brief Encode a row of pixels (XRGB8888, as lv_color32_t; alpha is dropped).
+   *  \param row: pixels to encode.
+   *  \param above: pixels of row above, or nullptr for first row.
+   *  \param width: number of pixels in row.
+   *  \param out: output buffer, holding at least max_row_size(width) bytes.
+   *  \returns number of bytes written.
+   */
+  size_t encode_row(const uint32_t * row, const uint32_t * above, size_t width, uint8_t * out);
+
+}
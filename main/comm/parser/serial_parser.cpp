@@ -10,48 +10,102 @@
 #include "util.h"
 
 #include <iostream>
+#include <string_view>
 #include "esp_log.h"
+#if CONFIG_UART_TRACE_ALLOCS
+#include "esp_heap_trace.h"
+#endif
 
 
 namespace eobsws::comm::parser {
 
+#if CONFIG_UART_TRACE_ALLOCS
+    /** \var static const size_t TraceRecordCount
+     *  \brief Number of allocations that can be recorded for a command; counts saturate there.
+     */
+    static const size_t TraceRecordCount = 64;
+
+    /** \var static heap_trace_record_t trace_records
+     *  \brief Records of allocations made while a command is processed.
+     */
+    static heap_trace_record_t trace_records[TraceRecordCount];
+#endif
+
     SerialParser::SerialParser(std::shared_ptr<DataBroker> db) : Parser(db) {
         this->in_message_type = MessageType::InboundWired;
         this->out_message_type = MessageType::OutboundWired;
+#if CONFIG_UART_TRACE_ALLOCS
+        heap_trace_init_standalone(trace_records, TraceRecordCount);
+#endif
         // subscribe callback to data broker
         this->db->subscribe(this->convert_callback<SerialParser>(this));
     }
 
     bool SerialParser::publish_callback(MessageType t, const std::string & data) {
-        if ((t & this->in_message_type) == MessageType::NoOutlet) {
+        if (!accepts(this->in_message_type, t)) {
             ESP_LOGI("SerialParser", "message of type %d rejected. Expected %d", static_cast<int>(t), static_cast<int>(this->in_message_type));
             return false;
         }
         ESP_LOGI("SerialParser", "processing message of type %d", static_cast<int>(t));
         ESP_LOGI("SerialParser", "received %s", data.c_str());
         // get command; we expect a data string starting with an AT command such as AT+PUTFILE=...
-        auto eq_pos = data.find_first_of("=");
-        auto cmd = data.substr(0, eq_pos);
-        auto content = data.substr(eq_pos+1);
+        // command and argument are views on data, which outlives this call
+        auto view = std::string_view(data);
+        auto eq_pos = view.find('=');
+        auto cmd = view.substr(0, eq_pos);
+        auto content = view.substr(eq_pos == std::string_view::npos ? 0 : eq_pos+1);
         if (cmd == serial::ATCommand::Abort) {
             ESP_LOGI("SerialParser", "%s command received.", serial::ATCommand::Abort.c_str());
             this->abort_stubs();
             this->db->publish(this->out_message_type, serial::ATReply::Ok);
             return true;
         }
+        if (cmd == serial::ATCommand::GetAllocs) {
+#if CONFIG_UART_TRACE_ALLOCS
+            this->reply.clear();
+            this->reply << serial::ATReply::Allocs << '=' << this->allocs << '\r';
+            this->db->publish(this->out_message_type, this->reply.str());
+            return true;
+#else
+            this->db->publish(this->out_message_type, serial::ATReply::Error);
+            return false;
+#endif
+        }
         // clean up parsers from dangling pointers
         this->clean_up_stubs();
         // check which parser takes command
-        ESP_LOGI("SerialParser", "searching for parser for command %s.", cmd.c_str());
+        ESP_LOGI("SerialParser", "searching for parser for command %.*s.", static_cast<int>(cmd.size()), cmd.data());
         auto stub = this->find_stub_for_command(cmd);
         if (stub != nullptr) {
             // parse data content with appropriate parser
-            ESP_LOGI("SerialParser", "found parser for command %s.", cmd.c_str());
-            ESP_LOGI("SerialParser", "argument: %s", content.c_str());
-            auto [message_type, success, result] = stub->parse(content);
-            return success & this->db->publish(message_type, result);
+            ESP_LOGI("SerialParser", "found parser for command %.*s.", static_cast<int>(cmd.size()), cmd.data());
+            ESP_LOGI("SerialParser", "argument: %.*s", static_cast<int>(content.size()), content.data());
+            auto serial_stub = dynamic_cast<serial::SerialParserStub*>(stub.get());
+            if (serial_stub == nullptr) {
+                auto [message_type, success, result] = stub->parse(std::string(content));
+                return success & this->db->publish(message_type, result);
+            }
+#if CONFIG_UART_TRACE_ALLOCS
+            // counts allocations of every task until reply is handed over to pipes
+            heap_trace_start(HEAP_TRACE_ALL);
+#endif
+            this->reply.clear();
+            bool success = serial_stub->parse(content, this->reply);
+            // stubs streaming their reply themselves (e.g. file push) leave buffer empty
+            if (!this->reply.str().empty())
+                success &= this->db->publish(this->out_message_type, this->reply.str());
+            serial_stub->reply_sent();
+#if CONFIG_UART_TRACE_ALLOCS
+            heap_trace_stop();
+            this->allocs = heap_trace_get_count();
+#endif
+            // configuration changes are announced, so that user interface follows them
+            auto change = serial_stub->take_config_change();
+            if (!change.empty())
+                this->db->broadcast(MessageType::ConfigChanged, change);
+            return success;
         }
-        ESP_LOGI("SerialParser", "no parser found for command %s.", cmd.c_str());
+        ESP_LOGI("SerialParser", "no parser found for command %.*s.", static_cast<int>(cmd.size()), cmd.data());
         this->db->publish(this->out_message_type, serial::ATReply::Unknown);
         return false;
     }
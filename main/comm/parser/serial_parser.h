@@ -30,6 +30,17 @@ namespace eobsws::comm::parser {
      */
     std::shared_ptr<storage::Partition> partition;
 
+    /** \property serial::ReplyBuffer reply
+     *  \brief Buffer in which stubs format replies; reused from one command to the next.
+     */
+    serial::ReplyBuffer reply;
+
+    /** \property size_t allocs
+     *  \brief Number of memory allocations made while processing previous command
+     *  (only counted if CONFIG_UART_TRACE_ALLOCS is set).
+     */
+    size_t allocs = 0;
+
     /** \fn bool publish_callback(MessageType t, const std::string & data)
      *  \brief Callback for publish events from data broker.
      *  \param t: message type.
@@ -5,16 +5,30 @@
  *  License: MIT
  */
 #include "serial_parser_stub.h"
+#include "base64.h"
+#include "rle.h"
 #include "storage/file.h"
 #include "storage/dir.h"
 #include "storage/nvs.h"
+#include "storage/block_cache.h"
+#include "comm/pipe/framing.h"
+#include "gui/image/image_png.h"
+#include "hardware/screen/screen_lvgl.h"
+#include "hardware/input/touch_lvgl.h"
+#include "hardware/input/input_trace.h"
+#include "hardware/analog_pin.h"
 #include "util.h"
-#include <mbedtls/base64.h>
-#include <sstream>
+#include <mbedtls/sha256.h>
+#include <charconv>
+#include <algorithm>
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "nvs_handle.hpp"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
 
 namespace eobsws::comm::parser::serial {
 
@@ -30,13 +44,34 @@ namespace eobsws::comm::parser::serial {
     const std::string ATCommand::GetFile = "AT+GETFILE";
     const std::string ATCommand::PutData = "AT+PUTDATA";
     const std::string ATCommand::GetData = "AT+GETDATA";
+    const std::string ATCommand::PutBin = "AT+PUTBIN";
+    const std::string ATCommand::GetBin = "AT+GETBIN";
+    // UART pipe publishes binary frames under this command
+    const std::string ATCommand::PutBlock = "AT+PUTBLK";
+    const std::string ATCommand::GetBlock = "AT+GETBLK";
+    const std::string ATCommand::HashFile = "AT+HASHFILE";
+    const std::string ATCommand::NextHash = "AT+NEXTHASH";
     const std::string ATCommand::ListDir = "AT+LISTDIR";
     const std::string ATCommand::NextFile = "AT+NEXTFILE";
     const std::string ATCommand::MakeDir = "AT+MAKEDIR";
     const std::string ATCommand::Delete = "AT+DELETE";
     const std::string ATCommand::SetConf = "AT+SETCONF";
+    const std::string ATCommand::SetConfBatch = "AT+SETCONFBATCH";
     const std::string ATCommand::GetConf = "AT+GETCONF";
     const std::string ATCommand::DelConf = "AT+DELCONF";
+    const std::string ATCommand::DumpConf = "AT+DUMPCONF";
+    const std::string ATCommand::LoadConf = "AT+LOADCONF";
+    const std::string ATCommand::GetStats = "AT+GETSTATS";
+    const std::string ATCommand::SetBaud = "AT+SETBAUD";
+    const std::string ATCommand::OTA = "AT+OTA";
+    const std::string ATCommand::ConfirmBaud = "AT+BAUDOK";
+    const std::string ATCommand::GetAllocs = "AT+GETALLOCS";
+    const std::string ATCommand::Screenshot = "AT+SCREENSHOT";
+    const std::string ATCommand::Reload = "AT+RELOAD";
+    const std::string ATCommand::Touch = "AT+TOUCH";
+    const std::string ATCommand::SetPot = "AT+SETPOT";
+    const std::string ATCommand::GetTrace = "AT+GETTRACE";
+    const std::string ATCommand::BenchImage = "AT+BENCHIMG";
     
     const std::string ATReply::Ok = "OK" + SerialTermination;
     const std::string ATReply::Error = "ERROR" + SerialTermination;
@@ -49,295 +84,1187 @@ namespace eobsws::comm::parser::serial {
     const std::string ATReply::Value = "VALUE";
     const std::string ATReply::BufferSize = "BUFS";
     const std::string ATReply::FirmwareVersion = "FWVER";
+    const std::string ATReply::Stats = "STATS";
+    const std::string ATReply::Hash = "HASH";
+    const std::string ATReply::Files = "FILES";
+    const std::string ATReply::Allocs = "ALLOCS";
+    const std::string ATReply::Screen = "SCREEN";
+    const std::string ATReply::Trace = "TRACE";
+    const std::string ATReply::BenchImage = "BENCHIMG";
+    const std::string ATReply::Ack = "ACK";
+    const std::string ATReply::Nak = "NAK";
 
 
-    /** \fn static inline size_t compute_b64_length(const size_t & len)
-     *  \brief Computes the equivalent length of a string encoded in base64.
-     *  \param len: length of the decoded string.
-     *  \returns the length of the base64-encoded string.
+    /** \var static constexpr size_t DecodeBlockSize
+     *  \brief Number of bytes decoded at once from base64 data before being written to
+     *  file; it's a multiple of 3, so that blocks are made of whole groups of characters.
      */
-    static inline size_t compute_b64_length(const size_t & len) {
-        return 4*(len + (3-len%3)%3)/3;
+    static constexpr size_t DecodeBlockSize = 768;
+
+
+    /** \fn static inline bool reply_ok(ReplyBuffer & reply)
+     *  \brief Format success reply.
+     *  \param reply: buffer receiving reply.
+     *  \returns true.
+     */
+    static inline bool reply_ok(ReplyBuffer & reply) {
+        reply << ATReply::Ok;
+        return true;
     }
 
-    /** \fn static std::string bytes_to_b64(const std::string & data)
-     *  \brief Encodes a byte string in byte64.
-     *  \param data: string to encode.
-     *  \returns encoded string.
+    /** \fn static inline bool reply_error(ReplyBuffer & reply)
+     *  \brief Format error reply, dropping anything formatted before.
+     *  \param reply: buffer receiving reply.
+     *  \returns false.
      */
-    static std::string bytes_to_b64(const std::string & data) {
-        auto blen = compute_b64_length(data.size()) + 1;
-        std::vector<unsigned char> encoded(blen);
-        size_t encoded_length;
-        mbedtls_base64_encode(encoded.data(), blen, &encoded_length,
-                              reinterpret_cast<const unsigned char*>(data.c_str()),
-                              data.size());
-        return std::string(reinterpret_cast<char*>(encoded.data()), encoded_length);
-    }
-
-    /** \fn static std::string b64_to_bytes(const std::string & data)
-     *  \brief Decodes a byte64-encoded string.
-     *  \param data: string to decode.
-     *  \returns decoded string.
+    static inline bool reply_error(ReplyBuffer & reply) {
+        reply.clear();
+        reply << ATReply::Error;
+        return false;
+    }
+
+
+    /** \fn static bool parse_put_options(std::string_view options, int & window, int & window_bits, int & offset)
+     *  \brief Parse options following file size in put commands: window size (number),
+     *  compression (z followed by compressor window bits) and write offset (@ followed
+     *  by position in file), separated by commas.
+     *  \param options: options string (may be empty).
+     *  \param window: window size, or 0 if absent.
+     *  \param window_bits: compressor window bits, or 0 if data isn't compressed.
+     *  \param offset: write offset, or -1 if file is rewritten from start.
+     *  \returns true if options are valid, false otherwise.
      */
-    static std::string b64_to_bytes(const std::string & data) {
-        auto blen = data.size()/4*3;
-        std::vector<unsigned char> decoded(blen);
-        size_t decoded_length;
-        mbedtls_base64_decode(decoded.data(), blen, &decoded_length,
-                              reinterpret_cast<const unsigned char*>(data.c_str()),
-                              data.size());
-        return std::string(reinterpret_cast<char*>(decoded.data()), decoded_length);
+    static bool parse_put_options(std::string_view options, int & window, int & window_bits, int & offset) {
+        window = 0;
+        window_bits = 0;
+        offset = -1;
+        auto rest = options;
+        while (!rest.empty()) {
+            auto [option, next] = split_first(rest, ",");
+            if (option.empty()) option = rest; // last option
+            if (option[0] == 'z' && option.size() > 1 && is_numeric(option.substr(1)))
+                window_bits = to_int(option.substr(1));
+            else if (option[0] == '@' && option.size() > 1 && is_numeric(option.substr(1))) {
+                offset = to_int(option.substr(1));
+                if (offset < 0) return false;
+            }
+            else if (is_numeric(option))
+                window = to_int(option);
+            else
+                return false;
+            rest = next;
+        }
+        return true;
     }
 
 
-    bool FileParserStub::open_file(const std::string & data, const char * mode) {
-        auto file_name = trim_string(data);
-        this->file = partition->open(file_name, mode);
+    bool FileParserStub::open_file(std::string_view data, const char * mode) {
+        this->file_path = trim_string(data);
+        this->file = partition->open(this->file_path, mode);
         return (this->file != nullptr);
     }
 
+    bool FileParserStub::open_file_at(std::string_view data, int offset) {
+        if (offset < 0) return this->open_file(data, "wb");
+        if (!this->open_file(data, "r+b")) return false;
+        // writing past the end would leave a hole
+        if (static_cast<size_t>(offset) > this->file->get_size() || !this->file->seek(offset, SEEK_SET)) {
+            this->file = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    bool FileParserStub::set_compression(int window_bits) {
+        // raw deflate streams have at least 512 bytes of window (zlib rejects 8 bits)
+        if (window_bits < 9 || window_bits > CONFIG_UART_INFLATE_WINDOW_BITS) return false;
+        this->inflater = std::make_unique<storage::Inflater>(window_bits);
+        return true;
+    }
+
+    bool FileParserStub::write_file(std::string_view data) {
+        if (this->inflater != nullptr)
+            return this->inflater->inflate(data, *this->file);
+        return this->file->write(data) == data.size();
+    }
 
-    ParserTuple PutFileParserStub::parse(const std::string & data) {
+    bool FileParserStub::is_write_complete() const {
+        return this->inflater == nullptr || this->inflater->is_done();
+    }
+
+
+    bool PutFileParserStub::parse(std::string_view data, ReplyBuffer & reply) {
         switch (this->phase) {
             case 0: // "open file" phase
             {
-                auto [file_name, file_len_str] = split_first(data, ",");
-                if (!this->open_file(file_name, "wb")) break;
-                if (!is_numeric(file_len_str)) break;
-                this->remaining_bytes = stoi(file_len_str);
+                auto [file_name, args] = split_first(data, ",");
+                auto [file_len_str, options] = split_first(args, ",");
+                if (file_len_str.empty()) file_len_str = args; // no options
+                int window, window_bits, offset;
+                if (file_len_str.empty() || !is_numeric(file_len_str)) break;
+                if (!parse_put_options(options, window, window_bits, offset)) break;
+                if (!this->open_file_at(file_name, offset)) break;
+                if (window_bits > 0 && !this->set_compression(window_bits)) {
+                    this->abort();
+                    break;
+                }
+                this->remaining_bytes = to_int(file_len_str);
                 this->phase = 1;
                 this->command = ATCommand::PutData;
-                return parser_message(this->parser_message_type, true, ATReply::Ok);
+                return reply_ok(reply);
                 break;
             }
             case 1: // "put data to file" phase
             {
                 if (data.size() % 4) {
                     // this is when data size won't fit in b64 decoder
-                    return parser_message(this->parser_message_type, false, ATReply::Error);
+                    return reply_error(reply);
+                }
+                // data is decoded block by block, each block being written before next one
+                uint8_t block[DecodeBlockSize];
+                bool failed = false;
+                for (size_t pos = 0; pos < data.size() && !failed; pos += base64::encoded_size(DecodeBlockSize)) {
+                    size_t len;
+                    failed = !base64::decode(data.substr(pos, base64::encoded_size(DecodeBlockSize)), block, len)
+                             || len > this->remaining_bytes
+                             || !this->write_file(std::string_view(reinterpret_cast<char*>(block), len));
+                    if (!failed) this->remaining_bytes -= len;
                 }
-                auto decoded = b64_to_bytes(data);
-                size_t written = this->file->write(decoded);
-                this->remaining_bytes -= data.size();
-                if (written != decoded.size()) {
-                    this->abort(); // cannot write required amount, aborting.
+                if (failed) {
+                    this->abort(); // invalid data, or cannot write required amount, aborting.
                     break;
                 }
-                if (this->remaining_bytes <= 0)
+                if (this->remaining_bytes == 0) {
+                    bool complete = this->is_write_complete();
                     this->abort(); // this closes file
+                    if (!complete) break;
+                    this->config_change = this->file_path;
+                }
 
-                return parser_message(this->parser_message_type, true, ATReply::Ok);
+                return reply_ok(reply);
                 break;
             }
         }
-        return parser_message(this->parser_message_type, false, ATReply::Error);
+        return reply_error(reply);
+    }
+
+    /** \var static constexpr uint32_t PushTaskStackSize
+     *  \brief Stack size of file push task.
+     */
+    static constexpr uint32_t PushTaskStackSize = 4096;
+
+    /** \var static constexpr UBaseType_t PushTaskPriority
+     *  \brief Priority of file push task, below UART tasks, so that commands (AT+ABORT
+     *  in particular) are still received while it waits for room in transmit queue.
+     */
+    static constexpr UBaseType_t PushTaskPriority = 5;
+
+    bool GetFileParserStub::start_push() {
+        this->stop_requested = false;
+        this->pushing = true;
+        auto fpush = [](void* arg) {
+            reinterpret_cast<GetFileParserStub*>(arg)->push_task();
+        };
+        if (xTaskCreate(fpush, "file_push_task", PushTaskStackSize, this, PushTaskPriority, nullptr) != pdPASS) {
+            this->pushing = false;
+            ESP_LOGE("GetFileParserStub", "cannot create push task.");
+            return false;
+        }
+        return true;
     }
 
-    ParserTuple GetFileParserStub::parse(const std::string & data) {
+    void GetFileParserStub::push_task() {
+        const TickType_t timeout = CONFIG_UART_BINARY_TIMEOUT / portTICK_PERIOD_MS;
+        ReplyBuffer header(32);
+        header << ATReply::Size << '=' << this->remaining_bytes << SerialTermination;
+        bool sent = this->uart_pipe->write_bytes(header.str(), timeout) > 0;
+
+        // Double buffering: while a frame waits for room in transmit queue, the next
+        // chunk has already been read from file into the other buffer.
+        std::string frame;
+        if (this->read_buffer.size() < pipe::framing::MaxPayload)
+            this->read_buffer.resize(pipe::framing::MaxPayload);
+        size_t chunk_size = 0;
+        auto read_chunk = [this, &chunk_size]() {
+            auto nbytes = std::min(this->remaining_bytes, pipe::framing::MaxPayload);
+            chunk_size = nbytes > 0 ? this->file->read_into(this->read_buffer.data(), nbytes) : 0;
+            if (chunk_size == static_cast<size_t>(-1)) chunk_size = 0;
+            // a short read is followed by another one for what's left
+            this->remaining_bytes -= chunk_size;
+        };
+        read_chunk();
+        while (sent && chunk_size > 0 && !this->stop_requested) {
+            pipe::framing::encode(std::string_view(reinterpret_cast<const char*>(this->read_buffer.data()), chunk_size), frame);
+            read_chunk();
+            sent = this->uart_pipe->write_bytes(frame, timeout) > 0;
+        }
+        // reading stops short of file end only if file can't be read
+        bool read_failed = sent && !this->stop_requested && this->remaining_bytes > 0;
+        if (!sent)
+            ESP_LOGE("GetFileParserStub", "link stalled; file push abandoned.");
+        else if (read_failed)
+            ESP_LOGE("GetFileParserStub", "cannot read file; %u bytes left unsent.", this->remaining_bytes);
+        // stream always ends with an empty frame, whether file ended or not;
+        // a read error is then reported, so that stream isn't taken for a complete file
+        pipe::framing::encode({}, frame);
+        this->uart_pipe->write_bytes(frame, timeout);
+        if (read_failed)
+            this->uart_pipe->write_bytes(ATReply::Error, timeout);
+        // file is closed before next command can see push is over
+        this->file = nullptr;
+        this->phase = 0;
+        this->pushing = false;
+        vTaskDelete(nullptr);
+    }
+
+    void GetFileParserStub::stop_push() {
+        this->stop_requested = true;
+        // push task checks flag before each frame; it ends within a transmit timeout
+        while (this->pushing) vTaskDelay(1);
+    }
+
+    bool GetFileParserStub::parse(std::string_view data, ReplyBuffer & reply) {
         switch (this->phase) {
             case 0: // "open file" phase
             {
-                auto file_name = trim_string(data);
-                if (!this->open_file(file_name, "rb")) break;
-                this->remaining_bytes = compute_b64_length(this->file->get_size());
+                // optional push argument comes after last comma
+                bool push = false;
+                auto comma = data.rfind(',');
+                if (comma != std::string_view::npos && trim_string(data.substr(comma + 1)) == "push") {
+                    push = true;
+                    data = data.substr(0, comma);
+                }
+                if (push && this->uart_pipe == nullptr) break;
+                if (!this->open_file(data, "rb")) break;
+                if (push) {
+                    this->remaining_bytes = this->file->get_size();
+                    this->phase = 2;
+                    if (!this->start_push()) {
+                        this->abort();
+                        break;
+                    }
+                    return true; // push task sends SIZE reply ahead of frames
+                }
+                this->remaining_bytes = base64::encoded_size(this->file->get_size());
                 this->phase = 1;
                 this->command = ATCommand::GetData;
-                return parser_message(this->parser_message_type, true,
-                                      ATReply::Size + "="
-                                      + std::to_string(this->remaining_bytes)
-                                      + SerialTermination);
+                reply << ATReply::Size << '=' << this->remaining_bytes << SerialTermination;
+                return true;
                 break;
             }
             case 1: // "get data from file" phase
             {
                 if (!is_numeric(data)) break;
                 // requested size, up to remaining number of bytes
-                auto nb64 = std::min(static_cast<size_t>(stoi(data)), this->remaining_bytes);
+                auto nb64 = std::min(to_int<size_t>(data), this->remaining_bytes);
                 // number of b64 bytes must be divisible by 4
                 if (nb64 % 4) break;
-                auto nbytes = nb64/4*3; // number of raw bytes
-                auto bytes = bytes_to_b64(this->file->read(nbytes));
-                this->remaining_bytes -= nb64;
-                if (bytes.size() != nb64) {
+                auto nbytes = base64::decoded_size(nb64); // number of raw bytes
+                if (nb64 == this->remaining_bytes) {
+                    // last chunk holds what's left of file, which may be less because of padding
+                    auto file_size = this->file->get_size();
+                    nbytes = file_size - base64::decoded_size(base64::encoded_size(file_size) - nb64);
+                }
+                if (this->read_buffer.size() < nbytes)
+                    this->read_buffer.resize(nbytes);
+                if (this->file->read_into(this->read_buffer.data(), nbytes) != nbytes) {
                     this->abort(); // cannot read required amount, aborting.
                     break;
                 }
-                if (this->remaining_bytes <= 0)
+                this->remaining_bytes -= nb64;
+                if (this->remaining_bytes == 0)
                     this->abort(); // this closes file
-                
-                return parser_message(this->parser_message_type, true,
-                                      ATReply::Data + "=" + bytes + SerialTermination);
+
+                reply << ATReply::Data << '=';
+                base64::encode(this->read_buffer.data(), nbytes, reply.extend(nb64));
+                reply << SerialTermination;
+                return true;
                 break;
             }
+            case 2: // "push file" phase
+            {
+                if (this->pushing) {
+                    reply << ATReply::Busy;
+                    return false;
+                }
+                // push has ended: command is handled as a new one
+                this->abort();
+                return this->parse(data, reply);
+            }
         }
-        return parser_message(this->parser_message_type, false, ATReply::Error);
+        return reply_error(reply);
+    }
+
+
+    /** \fn static inline uint16_t get_seq(std::string_view data)
+     *  \brief Read sequence number at the start of a frame payload.
+     *  \param data: frame payload (at least 2 bytes).
+     *  \returns sequence number.
+     */
+    static inline uint16_t get_seq(std::string_view data) {
+        return static_cast<uint8_t>(data[0]) | (static_cast<uint8_t>(data[1]) << 8);
+    }
+
+    /** \fn static inline std::string put_seq(uint16_t seq)
+     *  \brief Encode sequence number for a frame payload.
+     *  \param seq: sequence number.
+     *  \returns encoded sequence number.
+     */
+    static inline std::string put_seq(uint16_t seq) {
+        return {static_cast<char>(seq & 0xff), static_cast<char>(seq >> 8)};
     }
 
+    /** \fn static uint8_t parse_window(std::string_view data)
+     *  \brief Parse optional window size argument.
+     *  \param data: argument (empty if omitted).
+     *  \returns window size, capped at CONFIG_UART_MAX_WINDOW, or 0 if omitted or invalid.
+     */
+    static uint8_t parse_window(std::string_view data) {
+        if (data.empty() || !is_numeric(data)) return 0;
+        return std::clamp(to_int(data), 0, CONFIG_UART_MAX_WINDOW);
+    }
 
-    ParserTuple ListDirParserStub::parse(const std::string & data) {
+
+    bool PutBinParserStub::write_block(std::string_view bytes) {
+        if (bytes.size() > this->remaining_bytes || !this->write_file(bytes)) {
+            // close file, but stay in this phase until host ends transfer with an empty frame
+            this->file = nullptr;
+            this->write_failed = true;
+            return false;
+        }
+        this->remaining_bytes -= bytes.size();
+        return true;
+    }
+
+    bool PutBinParserStub::parse_sequenced(std::string_view data, ReplyBuffer & reply) {
+        auto ack = [this, &reply](const std::string & prefix) {
+            reply << prefix << '=' << this->next_seq << SerialTermination;
+            return true;
+        };
+        if (data.size() < 2) return ack(ATReply::Nak);
+        auto seq = get_seq(data);
+        uint16_t ahead = seq - this->next_seq;
+        if (ahead >= this->window) {
+            // already written (duplicate), or beyond window
+            return ack(ATReply::Ack);
+        }
+        if (ahead > 0) {
+            this->pending.emplace(seq, data.substr(2));
+            if (this->gap_reported) return ack(ATReply::Ack);
+            this->gap_reported = true;
+            return ack(ATReply::Nak);
+        }
+        if (!this->write_block(data.substr(2)))
+            return reply_error(reply);
+        this->next_seq++;
+        this->gap_reported = false;
+        // frames held back can now be written
+        for (auto it = this->pending.find(this->next_seq); it != this->pending.end();
+             it = this->pending.find(this->next_seq)) {
+            if (!this->write_block(it->second))
+                return reply_error(reply);
+            this->pending.erase(it);
+            this->next_seq++;
+        }
+        return ack(ATReply::Ack);
+    }
+
+    bool PutBinParserStub::start_transfer(size_t size, int window, ReplyBuffer & reply) {
+        this->remaining_bytes = size;
+        this->window = std::clamp(window, 0, CONFIG_UART_MAX_WINDOW);
+        this->phase = 1;
+        this->command = ATCommand::PutBlock;
+        // this reply switches UART pipe to binary mode
+        reply << pipe::framing::BinaryModeReply;
+        if (this->window > 0)
+            reply << '=' << this->window;
+        reply << SerialTermination;
+        return true;
+    }
+
+    bool PutBinParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        switch (this->phase) {
+            case 0: // "open file" phase
+            {
+                auto [file_name, args] = split_first(data, ",");
+                auto [file_len_str, options] = split_first(args, ",");
+                if (file_len_str.empty()) file_len_str = args; // no options
+                int window, window_bits, offset;
+                if (file_len_str.empty() || !is_numeric(file_len_str)) break;
+                if (!parse_put_options(options, window, window_bits, offset)) break;
+                if (!this->open_file_at(file_name, offset)) break;
+                if (window_bits > 0 && !this->set_compression(window_bits)) {
+                    this->abort();
+                    break;
+                }
+                return this->start_transfer(to_int<size_t>(file_len_str), window, reply);
+                break;
+            }
+            case 1: // "put frame payload to file" phase
+            {
+                if (data.empty()) {
+                    // end of transfer
+                    bool complete = !this->write_failed && this->remaining_bytes == 0 && this->finish_transfer();
+                    this->abort(); // this closes file
+                    if (complete) {
+                        // firmware updates and configuration blobs don't go to a file
+                        if (!this->file_path.empty())
+                            this->config_change = this->file_path;
+                        return reply_ok(reply);
+                    }
+                    break;
+                }
+                if (this->write_failed) break; // a previous block failed
+                if (this->window > 0)
+                    return this->parse_sequenced(data, reply);
+                if (!this->write_block(data)) break;
+                return reply_ok(reply);
+                break;
+            }
+        }
+        return reply_error(reply);
+    }
+
+    bool OTAParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        // once update started, frames are handled as file blocks
+        if (this->phase != 0) return PutBinParserStub::parse(data, reply);
+        auto [size_str, args] = split_first(data, ",");
+        auto [hash, window_str] = split_first(args, ",");
+        if (hash.empty()) hash = args; // no window argument
+        if (size_str.empty() || !is_numeric(size_str) || !this->updater.begin(to_int<size_t>(size_str), hash))
+            return reply_error(reply);
+        return this->start_transfer(to_int<size_t>(size_str), parse_window(window_str), reply);
+    }
+
+    bool OTAParserStub::finish_transfer() {
+        if (!this->updater.finish()) return false;
+        // reply goes out before restart
+        storage::OTAUpdater::restart(1000);
+        return true;
+    }
+
+    bool GetBinParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        switch (this->phase) {
+            case 0: // "open file" phase
+            {
+                auto [file_name, window_str] = split_first(data, ",");
+                if (file_name.empty()) file_name = data; // no window argument
+                if (!this->open_file(file_name, "rb")) break;
+                this->remaining_bytes = this->file->get_size();
+                this->window = parse_window(window_str);
+                this->phase = 1;
+                this->command = ATCommand::GetBlock;
+                reply << ATReply::Size << '=' << this->remaining_bytes << SerialTermination;
+                return true;
+                break;
+            }
+            case 1: // "get frame from file" phase
+            {
+                if (data == "R" && !this->history.empty()) {
+                    reply << this->history.back();
+                    return true;
+                }
+                if (data.compare(0, 2, "R,") == 0) {
+                    // frame payload starts after frame header
+                    auto seq = to_int<uint16_t>(data.substr(2));
+                    auto it = std::find_if(this->history.begin(), this->history.end(), [seq](auto & frame) {
+                        return get_seq(std::string_view(frame).substr(pipe::framing::HeaderSize, 2)) == seq;
+                    });
+                    if (it == this->history.end()) break;
+                    reply << *it;
+                    return true;
+                }
+                if (data.empty() || !is_numeric(data)) break;
+                auto nbytes = to_int<size_t>(data);
+                if (nbytes == 0) {
+                    this->abort(); // this closes file
+                    return reply_ok(reply);
+                }
+                // requested size, up to remaining number of bytes and frame capacity
+                std::string payload;
+                if (this->window > 0)
+                    payload = put_seq(this->next_seq++);
+                nbytes = std::min({nbytes, this->remaining_bytes, pipe::framing::MaxPayload - payload.size()});
+                // file data is read right after sequence number
+                auto head = payload.size();
+                payload.resize(head + nbytes);
+                if (this->file->read_into(payload.data() + head, nbytes) != nbytes) {
+                    this->abort(); // cannot read required amount, aborting.
+                    break;
+                }
+                this->remaining_bytes -= nbytes;
+                this->history.push_back(pipe::framing::encode(payload));
+                if (this->history.size() > std::max<size_t>(this->window, 1))
+                    this->history.pop_front();
+                reply << this->history.back();
+                return true;
+                break;
+            }
+        }
+        return reply_error(reply);
+    }
+
+    /** \fn static std::string to_hex(const unsigned char * bytes, size_t len)
+     *  \brief Encodes bytes as lowercase hexadecimal string.
+     *  \param bytes: bytes to encode.
+     *  \param len: number of bytes.
+     *  \returns encoded string.
+     */
+    static std::string to_hex(const unsigned char * bytes, size_t len) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex(2*len, '\0');
+        for (size_t n=0; n<len; n++) {
+            hex[2*n] = digits[bytes[n] >> 4];
+            hex[2*n+1] = digits[bytes[n] & 0xf];
+        }
+        return hex;
+    }
+
+    /** \var static constexpr size_t MinHashBlockSize
+     *  \brief Smallest block size accepted by HashFile; each block hash is kept in memory
+     *  until sent, so that small blocks would take more memory than file itself.
+     */
+    static constexpr size_t MinHashBlockSize = 512;
+
+    /** \var static constexpr size_t MaxHashBlocks
+     *  \brief Largest number of block hashes computed by HashFile.
+     */
+    static constexpr size_t MaxHashBlocks = 1024;
+
+    bool HashFileParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        switch (this->phase) {
+            case 0: // "hash file" phase
+            {
+                auto [file_name, block_size_str] = split_first(data, ",");
+                if (file_name.empty()) file_name = data; // no block size
+                size_t block_size = 0;
+                if (!block_size_str.empty()) {
+                    if (!is_numeric(block_size_str) || to_int(block_size_str) < static_cast<int>(MinHashBlockSize)) break;
+                    block_size = to_int(block_size_str);
+                }
+                if (!this->open_file(file_name, "rb")) break;
+                auto file_size = this->file->get_size();
+                if (block_size > 0 && (file_size + block_size - 1) / block_size > MaxHashBlocks) {
+                    ESP_LOGE("HashFileParserStub", "too many blocks of %d bytes.", block_size);
+                    this->file = nullptr;
+                    break;
+                }
+                unsigned char digest[32];
+                mbedtls_sha256_context file_ctx, block_ctx;
+                mbedtls_sha256_init(&file_ctx);
+                mbedtls_sha256_init(&block_ctx);
+                mbedtls_sha256_starts_ret(&file_ctx, 0);
+                // file is read in chunks of serial buffer size, whatever the block size
+                size_t pos = 0;
+                bool failed = false;
+                std::vector<unsigned char> buffer(std::min<size_t>(file_size, CONFIG_UART_BUF_SIZE));
+                while (pos < file_size && !failed) {
+                    auto nbytes = std::min<size_t>(file_size - pos, CONFIG_UART_BUF_SIZE);
+                    if (block_size > 0) {
+                        if (pos % block_size == 0) mbedtls_sha256_starts_ret(&block_ctx, 0);
+                        nbytes = std::min(nbytes, block_size - pos % block_size);
+                    }
+                    failed = this->file->read_into(buffer.data(), nbytes) != nbytes;
+                    auto ubytes = buffer.data();
+                    mbedtls_sha256_update_ret(&file_ctx, ubytes, nbytes);
+                    pos += nbytes;
+                    if (block_size > 0) {
+                        mbedtls_sha256_update_ret(&block_ctx, ubytes, nbytes);
+                        if (pos % block_size == 0 || pos == file_size) {
+                            mbedtls_sha256_finish_ret(&block_ctx, digest);
+                            this->block_hashes.push_back(to_hex(digest, sizeof(digest)));
+                        }
+                    }
+                }
+                mbedtls_sha256_finish_ret(&file_ctx, digest);
+                mbedtls_sha256_free(&file_ctx);
+                mbedtls_sha256_free(&block_ctx);
+                this->file = nullptr; // block hashes are kept in memory
+                if (failed) {
+                    ESP_LOGE("HashFileParserStub", "cannot read file.");
+                    this->abort();
+                    break;
+                }
+                reply << ATReply::Hash << '=' << file_size << ',' << to_hex(digest, sizeof(digest));
+                if (block_size > 0) {
+                    reply << ',' << this->block_hashes.size();
+                    if (!this->block_hashes.empty()) {
+                        this->phase = 1;
+                        this->command = ATCommand::NextHash;
+                    }
+                }
+                reply << SerialTermination;
+                return true;
+                break;
+            }
+            case 1: // "get block hashes" phase
+            {
+                // number of requested hashes, 1 by default
+                size_t count = (!data.empty() && is_numeric(data)) ? std::max(to_int(data), 1) : 1;
+                count = std::min(count, this->block_hashes.size() - this->next_block);
+                reply << ATReply::Hash << '=';
+                for (size_t n=0; n<count; n++) {
+                    if (n > 0) reply << ',';
+                    reply << this->block_hashes[this->next_block++];
+                }
+                reply << SerialTermination;
+                if (this->next_block == this->block_hashes.size())
+                    this->abort();
+                return true;
+                break;
+            }
+        }
+        return reply_error(reply);
+    }
+
+    /** \fn template<typename T> static size_t decimal_length(T value)
+     *  \brief Computes the number of characters of an integer in decimal form.
+     *  \param value: integer.
+     *  \returns number of characters.
+     */
+    template<typename T> static size_t decimal_length(T value) {
+        char digits[24];
+        return std::to_chars(digits, digits + sizeof(digits), value).ptr - digits;
+    }
+
+    void ListDirParserStub::get_page(ReplyBuffer & reply) {
+        // page is cut so that reply fits in serial buffer, but holds at least one entry;
+        // entries are measured first, as number of remaining entries comes before them
+        auto end = std::min(this->next_entry + this->page_size, this->entries.size());
+        auto last = this->next_entry;
+        size_t page_length = 0;
+        for (; last < end; last++) {
+            auto & entry = this->entries[last];
+            auto item_length = 4 + decimal_length(entry.type) + decimal_length(entry.size)
+                               + decimal_length(static_cast<long long>(entry.mtime)) + entry.name.size();
+            if (page_length > 0 && page_length + item_length + 16 > CONFIG_UART_BUF_SIZE) break;
+            page_length += item_length;
+        }
+        auto remaining = this->entries.size() - last;
+        reply << ATReply::Files << '=' << remaining;
+        for (; this->next_entry < last; this->next_entry++) {
+            auto & entry = this->entries[this->next_entry];
+            reply << '/' << entry.type << ',' << entry.size
+                  << ',' << static_cast<long long>(entry.mtime) << ',' << entry.name;
+        }
+        reply << SerialTermination;
+        if (remaining == 0)
+            this->abort();
+    }
+
+    bool ListDirParserStub::parse(std::string_view data, ReplyBuffer & reply) {
         switch (this->phase) {
             {
             case 0: // "open dir" phase
+                // optional page size follows last comma
                 auto dir_name = trim_string(data);
-                this->dir = this->partition->opendir(dir_name);
-                if (this->dir == nullptr) break;
-                this->remaining_files = this->dir->get_num_files();
+                auto p = dir_name.rfind(',');
+                if (p != std::string_view::npos && p + 1 < dir_name.size() && is_numeric(dir_name.substr(p+1))) {
+                    this->page_size = std::max(to_int(dir_name.substr(p+1)), 1);
+                    dir_name = dir_name.substr(0, p);
+                }
+                auto dir = this->partition->opendir(std::string(dir_name));
+                if (dir == nullptr) {
+                    this->abort();
+                    break;
+                }
+                this->entries = dir->list_files(); // directory is closed after this
                 this->phase = 1;
                 this->command = ATCommand::NextFile;
-                return parser_message(this->parser_message_type, true,
-                                      ATReply::NumFiles + "="
-                                      + std::to_string(this->remaining_files)
-                                      + SerialTermination);
+                if (this->page_size > 0) {
+                    this->get_page(reply);
+                    return true;
+                }
+                reply << ATReply::NumFiles << '=' << this->entries.size() << SerialTermination;
+                if (this->entries.empty())
+                    this->abort();
+                return true;
                 break;
             }
             case 1: // "get next file name" phase
             {
-                uint8_t file_type;
-                std::string file_name;
-                this->dir->get_file_info(-1, file_name, file_type);
-                this->remaining_files--;
-                if (this->remaining_files == 0)
-                    this->abort(); // this closes dir
-                return parser_message(this->parser_message_type, true,
-                                      ATReply::File + "="
-                                      + file_name + ","
-                                      + std::to_string(file_type)
-                                      + SerialTermination);
+                if (this->page_size > 0) {
+                    this->get_page(reply);
+                    return true;
+                }
+                auto & entry = this->entries[this->next_entry++];
+                reply << ATReply::File << '=' << entry.name << ',' << entry.type << SerialTermination;
+                if (this->next_entry == this->entries.size())
+                    this->abort();
+                return true;
                 break;
             }
         }
-        return parser_message(this->parser_message_type, false, ATReply::Error);
+        return reply_error(reply);
     }
 
-    ParserTuple DeleteFileParserStub::parse(const std::string & data) {
-        auto file_name = trim_string(data);
-        if (this->partition->remove(file_name))
-            return {this->parser_message_type, true, ATReply::Ok};
-        return parser_message(this->parser_message_type, false, ATReply::Error);
+    bool DeleteFileParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        std::string path(trim_string(data));
+        if (!this->partition->remove(path))
+            return reply_error(reply);
+        this->config_change = std::move(path);
+        return reply_ok(reply);
     }
 
-    ParserTuple MakedirParserStub::parse(const std::string & data) {
-        auto dir_name = trim_string(data);
-        if (this->partition->makedir(dir_name))
-            return {this->parser_message_type, true, ATReply::Ok};
-        return parser_message(this->parser_message_type, false, ATReply::Error);
+    bool MakedirParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        if (this->partition->makedir(std::string(trim_string(data))))
+            return reply_ok(reply);
+        return reply_error(reply);
     }
 
-    ParserTuple SetConfigParserStub::parse(const std::string & data) {
-        std::string ns, key, rdata, rrdata, type_str, value_str;
-        std::tie(ns, rdata) = split_first(data, ",");
-        std::tie(key, rrdata) = split_first(rdata, ",");
-        std::tie(type_str, value_str) = split_first(rrdata, ",");
-        auto err = parser_message(this->parser_message_type, false, ATReply::Error);
-        //ESP_LOGE("SetConfigParserStub", "split values: %s, %s, %s, %s", ns.c_str(), key.c_str(), );
+    bool SetConfigParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        auto [ns_str, rdata] = split_first(data, ",");
+        auto [key_str, rrdata] = split_first(rdata, ",");
+        auto [type_str, value_str] = split_first(rrdata, ",");
 
-        if (ns == "" || key == "" || type_str == "" || value_str == "") {
+        if (ns_str.empty() || key_str.empty() || type_str.empty() || value_str.empty()) {
             ESP_LOGE("SetConfigParserStub", "one of the parameters is missing.");
-            return err;
+            return reply_error(reply);
         }
-        
+
         if (!is_numeric(type_str)) {
             ESP_LOGE("SetConfigParserStub", "type parameter must be numeric.");
-            return err;
+            return reply_error(reply);
         }
 
-        int type = stoi(type_str);
+        // namespace and key names fit in small string buffer (15 characters at most)
+        std::string ns(ns_str), key(key_str);
+        int type = to_int(type_str);
         if (auto stored_type = static_cast<int>(this->partition->get_type(ns, key));
             stored_type != NVS_TYPE_ANY && type != stored_type) {
                 ESP_LOGE("SetConfigParserStub", "provided type differs from stored type.");
-                return err;
+                return reply_error(reply);
             }
 
         if (type == NVS_TYPE_STR || type == NVS_TYPE_BLOB) {
-            if (this->partition->set_string(ns, key, value_str))
-                return parser_message(this->parser_message_type, false, ATReply::Ok);
-            return err;
+            if (!this->partition->set_string(ns, key, std::string(value_str)))
+                return reply_error(reply);
+            this->config_change = std::move(ns);
+            return reply_ok(reply);
         }
 
         // numeric type
-        if (this->partition->set_item(ns, key, value_str, static_cast<storage::ItemType>(type)))
-            return parser_message(this->parser_message_type, true, ATReply::Ok);
-        
+        if (this->partition->set_item(ns, key, std::string(value_str), static_cast<storage::ItemType>(type))) {
+            this->config_change = std::move(ns);
+            return reply_ok(reply);
+        }
+
         ESP_LOGE("SetConfigParserStub", "cannot assign value to key.");
-        return err;
+        return reply_error(reply);
     }
 
-    ParserTuple GetConfigParserStub::parse(const std::string & data) {
-        auto [ns, key] = split_first(data, ",");
-        ParserTuple err = parser_message(this->parser_message_type, false, ATReply::Error);
-        if (key == "" || ns == "")
-            return err;
-        
+    bool SetConfigBatchParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        if (data == "BEGIN") {
+            this->abort(); // drops unfinished batch
+            this->started = true;
+            return reply_ok(reply);
+        }
+        if (!this->started) {
+            ESP_LOGE("SetConfigBatchParserStub", "batch wasn't started.");
+            return reply_error(reply);
+        }
+        if (data == "COMMIT") {
+            bool success = true;
+            for (auto & [ns, ns_records]: this->records)
+                success &= this->partition->set_items(ns, ns_records);
+            // batches usually span several namespaces
+            if (!this->records.empty())
+                this->config_change = this->records.size() == 1 ? this->records.begin()->first : "*";
+            this->abort();
+            return success ? reply_ok(reply) : reply_error(reply);
+        }
+
+        auto [ns_str, rdata] = split_first(data, ",");
+        auto [key_str, rrdata] = split_first(rdata, ",");
+        auto [type_str, value_str] = split_first(rrdata, ",");
+        if (ns_str.empty() || key_str.empty() || type_str.empty() || value_str.empty()) {
+            ESP_LOGE("SetConfigBatchParserStub", "one of the parameters is missing.");
+            return reply_error(reply);
+        }
+        if (!is_numeric(type_str)) {
+            ESP_LOGE("SetConfigBatchParserStub", "type parameter must be numeric.");
+            return reply_error(reply);
+        }
+        auto type = static_cast<storage::ItemType>(to_int(type_str));
+        bool is_string = type == storage::ItemType::SZ || type == storage::ItemType::BLOB;
+        if (!is_string && !is_numeric(value_str)) {
+            ESP_LOGE("SetConfigBatchParserStub", "numeric type but value is not numeric.");
+            return reply_error(reply);
+        }
+        // namespace is scanned once, then keys are looked up in memory
+        std::string ns(ns_str), key(key_str);
+        auto ns_types = this->types.find(ns);
+        if (ns_types == this->types.end())
+            ns_types = this->types.emplace(ns, this->partition->get_types(ns)).first;
+        auto & known = ns_types->second;
+        if (auto stored = known.find(key); stored != known.end() && stored->second != type) {
+            ESP_LOGE("SetConfigBatchParserStub", "provided type differs from stored type.");
+            return reply_error(reply);
+        }
+        known[key] = type; // later records for same key must match
+        this->records[ns].push_back({key, type, std::string(value_str)});
+        return reply_ok(reply);
+    }
+
+    bool GetConfigParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        auto [ns_str, key_str] = split_first(data, ",");
+        if (key_str.empty() || ns_str.empty())
+            return reply_error(reply);
+
+        std::string ns(ns_str), key(key_str);
         auto type = this->partition->get_type(ns, key);
-        std::ostringstream result;
-        result << ATReply::Value << "=" << static_cast<int>(type) << ",";
-        
+        reply << ATReply::Value << '=' << static_cast<int>(type) << ',';
+
         if (type == storage::ItemType::SZ
             || type == storage::ItemType::BLOB
             || type == storage::ItemType::BLOB_DATA) {
-            result << this->partition->get_string(ns, key);
+            reply << this->partition->get_string(ns, key);
         } else {
             switch (type) {
             case storage::ItemType::U8:
-                result << this->partition->get_item<uint8_t>(ns, key);
+                reply << this->partition->get_item<uint8_t>(ns, key);
                 break;
             case storage::ItemType::I8:
-                result << this->partition->get_item<int8_t>(ns, key);
+                reply << this->partition->get_item<int8_t>(ns, key);
                 break;
             case storage::ItemType::U16:
-                result << this->partition->get_item<uint16_t>(ns, key);
+                reply << this->partition->get_item<uint16_t>(ns, key);
                 break;
             case storage::ItemType::I16:
-                result << this->partition->get_item<int16_t>(ns, key);
+                reply << this->partition->get_item<int16_t>(ns, key);
                 break;
             case storage::ItemType::U32:
-                result << this->partition->get_item<uint32_t>(ns, key);
+                reply << this->partition->get_item<uint32_t>(ns, key);
                 break;
             case storage::ItemType::I32:
-                result << this->partition->get_item<int32_t>(ns, key);
+                reply << this->partition->get_item<int32_t>(ns, key);
                 break;
             case storage::ItemType::U64:
-                result << this->partition->get_item<uint64_t>(ns, key);
+                reply << this->partition->get_item<uint64_t>(ns, key);
                 break;
             case storage::ItemType::I64:
-                result << this->partition->get_item<int64_t>(ns, key);
+                reply << this->partition->get_item<int64_t>(ns, key);
                 break;
             default:
                 break;
             }
         }
-        result << SerialTermination;
-        return parser_message(this->parser_message_type, true, result.str());
+        reply << SerialTermination;
+        return true;
     }
 
-    ParserTuple DelConfigParserStub::parse(const std::string & data) {
+    bool DelConfigParserStub::parse(std::string_view data, ReplyBuffer & reply) {
         auto [ns, key] = split_first(data, ",");
-        auto err = parser_message(this->parser_message_type, false, ATReply::Error);
-        if (key == "" || ns == "")
-            return err;
-        
-        if (this->partition->erase_item(ns, key)) {
-            return parser_message(this->parser_message_type, true, ATReply::Ok);
+        if (key.empty() || ns.empty())
+            return reply_error(reply);
+
+        if (!this->partition->erase_item(std::string(ns), std::string(key)))
+            return reply_error(reply);
+        this->config_change = ns;
+        return reply_ok(reply);
+    }
+
+
+    /** \var static constexpr size_t MaxConfigSize
+     *  \brief Largest configuration blob accepted by LoadConf, kept in memory until complete.
+     *  DumpConf doesn't export larger blobs, which couldn't be loaded back.
+     */
+    static constexpr size_t MaxConfigSize = 0x10000;
+
+    bool DumpConfigParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        std::string blob;
+        if (!this->partition->dump(blob) || blob.size() > MaxConfigSize)
+            return reply_error(reply);
+        // size and frames are queued as room is made, so that link paces them
+        const TickType_t timeout = CONFIG_UART_BINARY_TIMEOUT / portTICK_PERIOD_MS;
+        ReplyBuffer header(32);
+        header << ATReply::Size << '=' << blob.size() << SerialTermination;
+        bool sent = this->uart_pipe->write_bytes(header.str(), timeout) > 0;
+        std::string frame;
+        for (size_t pos = 0; pos < blob.size() && sent; pos += pipe::framing::MaxPayload) {
+            pipe::framing::encode(std::string_view(blob).substr(pos, pipe::framing::MaxPayload), frame);
+            sent = this->uart_pipe->write_bytes(frame, timeout) > 0;
+        }
+        // stream always ends with an empty frame, whether blob is complete or not
+        pipe::framing::encode({}, frame);
+        this->uart_pipe->write_bytes(frame, timeout);
+        return sent; // reply was streamed, buffer stays empty
+    }
+
+    bool LoadConfigParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        // once transfer started, frames are handled as file blocks
+        if (this->phase != 0) return PutBinParserStub::parse(data, reply);
+        auto [size_str, window_str] = split_first(data, ",");
+        if (size_str.empty()) size_str = data; // no window argument
+        if (size_str.empty() || !is_numeric(size_str) || to_int<size_t>(size_str) > MaxConfigSize)
+            return reply_error(reply);
+        this->blob.reserve(to_int<size_t>(size_str));
+        return this->start_transfer(to_int<size_t>(size_str), parse_window(window_str), reply);
+    }
+
+
+    bool GetBufSizeParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        reply << ATReply::BufferSize << '=' << CONFIG_UART_BUF_SIZE << SerialTermination;
+        return true;
+    }
+
+
+    bool GetFirmwareVersionParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        reply << ATReply::FirmwareVersion << '=' << CONFIG_ECTRL_FIRMWARE_VERSION << SerialTermination;
+        return true;
+    }
+
+
+
+    bool GetLinkStatsParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        // without argument, parser passes command itself
+        size_t idx = (!data.empty() && isdigit(data[0])) ? to_int<size_t>(data) : 0;
+        // tunneled connections have no WebSocket pipe, hence no statistics
+        auto it = std::find_if(this->ws_pipes.begin(), this->ws_pipes.end(),
+                               [idx](auto & p) { return p->get_target() == idx; });
+        if (it == this->ws_pipes.end())
+            return reply_error(reply);
+        auto & ws_pipe = *it;
+        auto stats = ws_pipe->get_link_stats();
+        reply << ATReply::Stats << '='
+              << ws_pipe->get_rssi() << ','
+              << stats.srtt << ','
+              << stats.rttvar << ','
+              << stats.last_rtt << ','
+              << stats.probes_sent << ','
+              << stats.probes_lost << ','
+              << stats.reconnects << ','
+              << stats.handshake
+              << SerialTermination;
+        return true;
+    }
+
+
+    bool SetBaudRateParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        auto [rate_str, flow_str] = split_first(data, ",");
+        if (rate_str.empty()) rate_str = data; // no flow control argument
+        if (rate_str.empty() || !is_numeric(rate_str))
+            return reply_error(reply);
+        if (!this->uart_pipe->request_baud_rate(to_int(rate_str), flow_str == "1"))
+            return reply_error(reply);
+        // pipe switches rate once this reply is queued (see reply_sent)
+        return reply_ok(reply);
+    }
+
+
+    bool ConfirmBaudRateParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        if (!this->uart_pipe->confirm_baud_rate())
+            return reply_error(reply);
+        return reply_ok(reply);
+    }
+
+
+
+    /** \var static constexpr uint32_t CaptureTimeout
+     *  \brief Time given to display task to draw captured frame, in milliseconds.
+     */
+    static constexpr uint32_t CaptureTimeout = 1000;
+
+    bool ScreenshotParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        if (this->running) {
+            reply << ATReply::Busy;
+            return false;
+        }
+        size_t npixels = this->screen->screen->get_screen_width()*this->screen->screen->get_screen_height();
+        this->buffer = static_cast<uint32_t*>(heap_caps_malloc(npixels*sizeof(uint32_t), MALLOC_CAP_SPIRAM));
+        if (this->buffer == nullptr) {
+            ESP_LOGE("ScreenshotParserStub", "cannot allocate snapshot buffer.");
+            return reply_error(reply);
+        }
+        if (!this->screen->start_capture(this->buffer)) {
+            heap_caps_free(this->buffer);
+            this->buffer = nullptr;
+            return reply_error(reply);
+        }
+        this->stop_requested = false;
+        this->running = true;
+        auto fcapture = [](void* arg) {
+            reinterpret_cast<ScreenshotParserStub*>(arg)->capture_task();
+        };
+        if (xTaskCreate(fcapture, "screenshot_task", PushTaskStackSize, this, PushTaskPriority, nullptr) != pdPASS) {
+            ESP_LOGE("ScreenshotParserStub", "cannot create capture task.");
+            this->screen->stop_capture();
+            heap_caps_free(this->buffer);
+            this->buffer = nullptr;
+            this->running = false;
+            return reply_error(reply);
+        }
+        return true; // capture task replies once frame is captured
+    }
+
+    void ScreenshotParserStub::capture_task() {
+        const TickType_t timeout = CONFIG_UART_BINARY_TIMEOUT / portTICK_PERIOD_MS;
+        // display task copies next frame while drawing it
+        auto deadline = xTaskGetTickCount() + CaptureTimeout / portTICK_PERIOD_MS;
+        while (!this->screen->is_capture_complete() && !this->stop_requested
+               && static_cast<int32_t>(deadline - xTaskGetTickCount()) > 0)
+            vTaskDelay(10 / portTICK_PERIOD_MS);
+        bool complete = this->screen->is_capture_complete();
+        this->screen->stop_capture();
+
+        if (complete) {
+            size_t width = this->screen->screen->get_screen_width();
+            size_t height = this->screen->screen->get_screen_height();
+            ReplyBuffer header(32);
+            header << ATReply::Screen << '=' << width << ',' << height << SerialTermination;
+            bool sent = this->uart_pipe->write_bytes(header.str(), timeout) > 0;
+            // rows are coded one at a time after pending data, which goes out by full frames
+            std::string payload, frame;
+            payload.reserve(pipe::framing::MaxPayload + rle::max_row_size(width));
+            for (size_t y = 0; y < height && sent && !this->stop_requested; y++) {
+                auto row = this->buffer + y*width;
+                auto pos = payload.size();
+                payload.resize(pos + rle::max_row_size(width));
+                auto len = rle::encode_row(row, y > 0 ? row - width : nullptr, width,
+                                           reinterpret_cast<uint8_t*>(payload.data() + pos));
+                payload.resize(pos + len);
+                while (sent && payload.size() >= pipe::framing::MaxPayload) {
+                    pipe::framing::encode(std::string_view(payload).substr(0, pipe::framing::MaxPayload), frame);
+                    payload.erase(0, pipe::framing::MaxPayload);
+                    sent = this->uart_pipe->write_bytes(frame, timeout) > 0;
+                }
+            }
+            if (sent && !payload.empty() && !this->stop_requested) {
+                pipe::framing::encode(payload, frame);
+                this->uart_pipe->write_bytes(frame, timeout);
+            }
+            // stream always ends with an empty frame, whether snapshot is complete or not
+            pipe::framing::encode({}, frame);
+            this->uart_pipe->write_bytes(frame, timeout);
         } else {
-            return err;
+            ESP_LOGE("ScreenshotParserStub", "frame wasn't captured in time.");
+            this->uart_pipe->write_bytes(ATReply::Error, timeout);
+        }
+        heap_caps_free(this->buffer);
+        this->buffer = nullptr;
+        this->running = false;
+        vTaskDelete(nullptr);
+    }
+
+    void ScreenshotParserStub::abort() {
+        this->stop_requested = true;
+        // capture task checks flag before each frame; it ends within a transmit timeout
+        while (this->running) vTaskDelay(1);
+    }
+
+
+
+    /** \var static constexpr uint32_t DefaultTouchDuration
+     *  \brief Press duration of injected touch events if none is given, in milliseconds.
+     */
+    static constexpr uint32_t DefaultTouchDuration = 100;
+
+    /** \var static constexpr uint32_t MaxTouchDuration
+     *  \brief Longest press duration of injected touch events, in milliseconds.
+     */
+    static constexpr uint32_t MaxTouchDuration = 10000;
+
+    bool TouchParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        auto [x_str, rest] = split_first(data, ",");
+        auto [y_str, duration_str] = split_first(rest, ",");
+        if (y_str.empty()) y_str = rest; // no duration argument
+        if (x_str.empty() || y_str.empty() || !is_numeric(x_str) || !is_numeric(y_str)
+            || !is_numeric(duration_str))
+            return reply_error(reply);
+        auto x = to_int(x_str), y = to_int(y_str);
+        auto duration = duration_str.empty() ? DefaultTouchDuration : to_int<uint32_t>(duration_str);
+        if (x < 0 || y < 0 || x > UINT16_MAX || y > UINT16_MAX || duration == 0 || duration > MaxTouchDuration)
+            return reply_error(reply);
+        hardware::input::trace::start();
+        this->touch->inject(x, y, duration);
+        return reply_ok(reply);
+    }
+
+
+    bool SetPotParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        auto [idx_str, value_str] = split_first(data, ",");
+        if (idx_str.empty()) idx_str = data; // no value: back to measurements
+        if (idx_str.empty() || !is_numeric(idx_str) || !is_numeric(value_str))
+            return reply_error(reply);
+        auto idx = to_int<size_t>(idx_str);
+        if (idx >= this->pins.size())
+            return reply_error(reply);
+        if (value_str.empty()) {
+            this->pins[idx]->force_value(-1);
+            return reply_ok(reply);
+        }
+        auto value = to_int(value_str);
+        if (value < 0 || value > UINT16_MAX)
+            return reply_error(reply);
+        hardware::input::trace::start();
+        this->pins[idx]->force_value(value);
+        return reply_ok(reply);
+    }
+
+
+    bool GetTraceParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        int32_t delays[static_cast<size_t>(hardware::input::trace::Stage::Count) - 1];
+        if (!hardware::input::trace::get_delays(delays))
+            return reply_error(reply);
+        reply << ATReply::Trace << '=';
+        for (size_t n=0; n<std::size(delays); n++) {
+            if (n > 0) reply << ',';
+            reply << delays[n];
         }
+        reply << SerialTermination;
+        return true;
     }
 
 
-    ParserTuple GetBufSizeParserStub::parse(const std::string & data) {
-        return parser_message(this->parser_message_type, true,
-                              ATReply::BufferSize + "="
-                              + std::to_string(CONFIG_UART_BUF_SIZE)
-                              + SerialTermination);
+
+    bool BenchImageParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        auto [path, mode_str] = split_first(data, ",");
+        if (path.empty()) path = data; // mode is optional
+        path = trim_string(path);
+        mode_str = trim_string(mode_str);
+        if (path.empty() || !is_numeric(mode_str))
+            return reply_error(reply);
+        storage::BlockCache::Stats stats;
+#if CONFIG_FILE_READ_CACHE
+        // by default, image is read through emptied cache if there is one
+        auto & cache = storage::BlockCache::shared();
+        auto enabled = cache.is_enabled();
+        auto mode = mode_str.empty() ? (enabled ? 1 : 0) : to_int(mode_str);
+        if (mode < 0 || mode > 2 || (mode > 0 && !enabled))
+            return reply_error(reply);
+        cache.set_enabled(mode > 0);
+        if (mode == 1) cache.clear();
+        cache.reset_stats();
+#else
+        // without cache, files can only be read directly
+        if (!mode_str.empty() && to_int(mode_str) != 0)
+            return reply_error(reply);
+#endif
+        uint32_t count0, bytes0, count1, bytes1;
+        storage::File::get_read_stats(count0, bytes0);
+        auto t0 = esp_timer_get_time();
+        gui::image::ImagePNG image;
+        auto err = image.from_file(this->partition, std::string(path));
+        auto t1 = esp_timer_get_time();
+        storage::File::get_read_stats(count1, bytes1);
+#if CONFIG_FILE_READ_CACHE
+        stats = cache.get_stats();
+        cache.set_enabled(enabled);
+#endif
+        if (err != ESP_OK)
+            return reply_error(reply);
+        reply << ATReply::BenchImage << '=' << static_cast<int32_t>(t1 - t0) << ','
+              << count1 - count0 << ',' << bytes1 - bytes0 << ','
+              << stats.hits << ',' << stats.misses << SerialTermination;
+        return true;
     }
 
 
-    ParserTuple GetFirmwareVersionParserStub::parse(const std::string & data) {
-        return parser_message(this->parser_message_type, true,
-                              ATReply::FirmwareVersion + "="
-                              + CONFIG_ECTRL_FIRMWARE_VERSION
-                              + SerialTermination);
+
+    bool ReloadConfigParserStub::parse(std::string_view data, ReplyBuffer & reply) {
+        // whole configuration gets compared with the live one
+        this->config_change = "*";
+        return reply_ok(reply);
     }
-    
+
 }
@@ -7,7 +7,31 @@
 #pragma once
 #include "parser_stub.h"
 #include "storage/partition.h"
+#include "storage/dir.h"
 #include "storage/nvs.h"
+#include "storage/inflater.h"
+#include "storage/ota.h"
+#include "comm/pipe/websocket_pipe.h"
+#include "comm/pipe/uart_pipe.h"
+#include <atomic>
+#include <map>
+#include <deque>
+#include <string_view>
+#include <charconv>
+#include <type_traits>
+#include <utility>
+
+namespace eobsws::hardware {
+  class AnalogPin;
+}
+
+namespace eobsws::hardware::input {
+  class TouchpadLVGL;
+}
+
+namespace eobsws::hardware::screen {
+  class ScreenLVGL;
+}
 
 /** \namespace eobsws::comm::parser::serial
  *  \brief Serial command parser stubs.
@@ -26,14 +50,34 @@ namespace eobsws::comm::parser::serial {
     GetFile, ///< initiate get file command
     PutData, ///< write data into file opened with PutFile
     GetData, ///< read data from file opened with GetFile
+    PutBin, ///< initiate put file command with binary frames
+    GetBin, ///< initiate get file command with binary frames
+    PutBlock, ///< write frame payload into file opened with PutBin
+    GetBlock, ///< read frame from file opened with GetBin
+    HashFile, ///< compute file hash
+    NextHash, ///< request next block hashes from file hashed with HashFile
     ListDir, ///< start listing directory content
     NextFile, ///< request next file from directory opened with ListDir
     MakeDir, ///< create directory
     Delete, ///< delete file or directory
     SetConf, ///< set configuration key in non-volatile storage
+    SetConfBatch, ///< set several configuration keys, committed together
     GetConf, ///< get configuration key from non-volatile storage
     DelConf, ///< delete configuration key from non-volatile storage
-    GetFirmwareVersion; ///< get firmware version
+    DumpConf, ///< export all configuration keys as a blob
+    LoadConf, ///< import configuration keys from a blob sent as binary frames
+    GetFirmwareVersion, ///< get firmware version
+    GetStats, ///< get link statistics
+    SetBaud, ///< switch to another baud rate
+    OTA, ///< initiate firmware update with binary frames
+    GetAllocs, ///< get number of memory allocations made by previous command
+    Screenshot, ///< capture screen content
+    Reload, ///< apply configuration changes made by other means (e.g. HTTP uploads)
+    Touch, ///< inject a touch event
+    SetPot, ///< force potentiometer value
+    GetTrace, ///< get stage delays of last injected input event
+    BenchImage, ///< decode a PNG image and report load time and file system reads
+    ConfirmBaud; ///< confirm baud rate switch (sent at new rate)
   };
 
   /** \class ATReply
@@ -51,13 +95,143 @@ namespace eobsws::comm::parser::serial {
     File, ///< prefix for file info
     Value, ///< prefix for configuration key value
     BufferSize, ///< prefix for buffer size
-    FirmwareVersion; ///< prefix for firmware version
+    FirmwareVersion, ///< prefix for firmware version
+    Stats, ///< prefix for link statistics
+    Hash, ///< prefix for file or block hashes
+    Files, ///< prefix for a page of directory entries
+    Allocs, ///< prefix for number of memory allocations
+    Screen, ///< prefix for screen snapshot size
+    Trace, ///< prefix for stage delays of injected input event
+    BenchImage, ///< prefix for image load benchmark results
+    Ack, ///< prefix for next expected frame in windowed binary transfers
+    Nak; ///< prefix for missing frame in windowed binary transfers
+  };
+
+  /** \class ReplyBuffer
+   *  \brief Buffer in which serial parser stubs format replies. Capacity is reserved
+   *  once, and numbers are formatted in place, so that a reply doesn't allocate memory
+   *  unless it is larger than any previous one.
+   */
+  class ReplyBuffer {
+  private:
+    /** \property std::string buffer
+     *  \brief Reply content.
+     */
+    std::string buffer;
+
+  public:
+    /** \fn ReplyBuffer(size_t capacity)
+     *  \brief Constructor.
+     *  \param capacity: number of bytes to reserve.
+     */
+    ReplyBuffer(size_t capacity = 2*CONFIG_UART_BUF_SIZE) { this->buffer.reserve(capacity); }
+
+    /** \fn void clear()
+     *  \brief Drop content, keeping capacity.
+     */
+    void clear() { this->buffer.clear(); }
+
+    /** \fn ReplyBuffer & operator<<(std::string_view text)
+     *  \brief Append text.
+     *  \param text: text to append.
+     *  \returns reference to buffer.
+     */
+    ReplyBuffer & operator<<(std::string_view text) {
+      this->buffer.append(text);
+      return *this;
+    }
+
+    /** \fn ReplyBuffer & operator<<(char c)
+     *  \brief Append a character.
+     *  \param c: character to append.
+     *  \returns reference to buffer.
+     */
+    ReplyBuffer & operator<<(char c) {
+      this->buffer.push_back(c);
+      return *this;
+    }
+
+    /** \fn template<typename T> ReplyBuffer & operator<<(T value)
+     *  \brief Append an integer in decimal form (8-bit integers included).
+     *  \param value: integer to append.
+     *  \returns reference to buffer.
+     */
+    template<typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+    ReplyBuffer & operator<<(T value) {
+      char digits[24];
+      auto result = std::to_chars(digits, digits + sizeof(digits), value);
+      this->buffer.append(digits, result.ptr - digits);
+      return *this;
+    }
+
+    /** \fn char * extend(size_t len)
+     *  \brief Extend content with characters to be written by caller.
+     *  \param len: number of characters.
+     *  \returns pointer to first added character.
+     */
+    char * extend(size_t len) {
+      auto size = this->buffer.size();
+      this->buffer.resize(size + len);
+      return this->buffer.data() + size;
+    }
+
+    /** \fn const std::string & str() const
+     *  \brief Get content.
+     *  \returns reply.
+     */
+    const std::string & str() const { return this->buffer; }
+  };
+
+  /** \class SerialParserStub
+   *  \brief Base class for serial command parser stubs. Arguments are read in place
+   *  and replies are formatted into a buffer provided by caller (one per pipe), so that
+   *  a command is processed without memory allocations.
+   */
+  class SerialParserStub : public ParserStub {
+  protected:
+    /** \property std::string config_change
+     *  \brief What last command changed in configuration: NVS namespace, file path,
+     *  or "*" for anything; empty if nothing changed.
+     */
+    std::string config_change;
+
+  public:
+    /** \fn virtual bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse; it must remain valid during the call only.
+     *  \param reply: empty buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    virtual bool parse(std::string_view data, ReplyBuffer & reply) = 0;
+
+    /** \fn ParserTuple parse(const std::string & data)
+     *  \brief Parse given data and return result, with reply in a buffer of its own.
+     *  \param data: data to parse.
+     *  \returns result compiled as ParserTuple.
+     */
+    ParserTuple parse(const std::string & data) override {
+      ReplyBuffer reply;
+      bool success = this->parse(std::string_view(data), reply);
+      return parser_message(this->parser_message_type, success, reply.str());
+    }
+
+    /** \fn std::string take_config_change()
+     *  \brief Get what last command changed in configuration, and reset it.
+     *  \returns NVS namespace, file path, or "*" for anything; empty if nothing changed.
+     */
+    std::string take_config_change() { return std::exchange(this->config_change, std::string()); }
+
+    /** \fn virtual void reply_sent()
+     *  \brief Called by parser once reply was handed over to pipes, for stubs acting on
+     *  link after their reply (e.g. baud rate switch).
+     */
+    virtual void reply_sent() {}
   };
 
   /** \class PartitionParserStub
    *  \brief Base class for parser stubs requiring access to a storage partition.
    */
-  class PartitionParserStub : public ParserStub {
+  class PartitionParserStub : public SerialParserStub {
   protected:
     /** \property std::shared_ptr<storage::Partition> partition
      *  \brief Pointer to a partition handler.
@@ -87,6 +261,11 @@ namespace eobsws::comm::parser::serial {
      */
     std::unique_ptr<storage::File> file;
 
+    /** \property std::string file_path
+     *  \brief Path of last opened file.
+     */
+    std::string file_path;
+
     /** \property uint8_t phase
      *  \brief Parser phase (0=open file, 1=read or write)
      */
@@ -97,13 +276,47 @@ namespace eobsws::comm::parser::serial {
      */
     std::size_t remaining_bytes;
 
-    /** \fn bool open_file(const std::string & data, const char * mode)
+    /** \fn bool open_file(std::string_view data, const char * mode)
      *  \brief Open a file.
      *  \param data: file name.
      *  \param mode: access mode.
      *  \returns true if file could be opened, false otherwise.
      */
-    bool open_file(const std::string & data, const char * mode);
+    bool open_file(std::string_view data, const char * mode);
+
+    /** \fn bool open_file_at(std::string_view data, int offset)
+     *  \brief Open a file for writing at given offset. With an offset (0 included),
+     *  existing content is kept; offset must not exceed file size.
+     *  \param data: file name.
+     *  \param offset: position of first written byte, or -1 to replace file.
+     *  \returns true if file could be opened, false otherwise.
+     */
+    bool open_file_at(std::string_view data, int offset);
+
+    /** \property std::unique_ptr<storage::Inflater> inflater
+     *  \brief Decompressor for compressed uploads (nullptr if data isn't compressed).
+     */
+    std::unique_ptr<storage::Inflater> inflater;
+
+    /** \fn bool set_compression(int window_bits)
+     *  \brief Expect uploaded data as raw deflate stream.
+     *  \param window_bits: base-2 logarithm of compressor window size.
+     *  \returns true if window fits in CONFIG_UART_INFLATE_WINDOW_BITS, false otherwise.
+     */
+    bool set_compression(int window_bits);
+
+    /** \fn bool write_file(std::string_view data)
+     *  \brief Write uploaded data to file, decompressing it if needed.
+     *  \param data: uploaded data.
+     *  \returns true if data could be written, false otherwise.
+     */
+    virtual bool write_file(std::string_view data);
+
+    /** \fn bool is_write_complete() const
+     *  \brief Tell if uploaded data was complete (always true without compression).
+     *  \returns true if compressed stream was complete or data wasn't compressed, false otherwise.
+     */
+    bool is_write_complete() const;
 
   public:
     /** \fn FileParserStub(std::shared_ptr<storage::Partition> partition)
@@ -117,6 +330,7 @@ namespace eobsws::comm::parser::serial {
      */
     void abort() override {
       this->file = nullptr;
+      this->inflater = nullptr;
       this->phase = 0;
     }
   };
@@ -139,12 +353,13 @@ namespace eobsws::comm::parser::serial {
     PutFileParserStub(std::shared_ptr<storage::Partition> partition) : FileParserStub(partition)
       { this->command = this->default_command; }
 
-    /** \fn ParserTuple parse(const std::string & data)
-     *  \brief Parse given data and return result.
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
      *  \param data: data to parse.
-     *  \returns result compiled as ParserTuple.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
      */
-    ParserTuple parse(const std::string & data) override;
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
 
     /** \fn void abort()
      *  \brief Abort current command chain.
@@ -156,7 +371,10 @@ namespace eobsws::comm::parser::serial {
   };
 
   /** \class GetFileParserStub
-   *  \brief Class to get data from file with serial AT commands.
+   *  \brief Class to get data from file with serial AT commands. In push mode
+   *  (AT+GETFILE=fpath,push), a task streams the whole file as binary frames instead,
+   *  paced by the room left in UART transmit queue; the stream ends with an empty frame,
+   *  when file ends or host sends AT+ABORT.
    */
   class GetFileParserStub : public FileParserStub {
   private:
@@ -165,39 +383,371 @@ namespace eobsws::comm::parser::serial {
      */
     const std::string default_command = ATCommand::GetFile;
 
+    /** \property std::shared_ptr<pipe::UARTPipe> uart_pipe
+     *  \brief UART pipe receiving pushed frames (push mode is disabled if nullptr).
+     */
+    std::shared_ptr<pipe::UARTPipe> uart_pipe;
+
+    /** \property std::atomic<bool> pushing
+     *  \brief Tell if push task is running.
+     */
+    std::atomic<bool> pushing = false;
+
+    /** \property std::atomic<bool> stop_requested
+     *  \brief Tell push task to end stream after current frame.
+     */
+    std::atomic<bool> stop_requested = false;
+
+    /** \property std::vector<uint8_t> read_buffer
+     *  \brief Bytes read from file, before encoding; reused from one chunk to the next.
+     */
+    std::vector<uint8_t> read_buffer;
+
+    /** \fn bool start_push()
+     *  \brief Start task pushing open file.
+     *  \returns true if task could be started, false otherwise.
+     */
+    bool start_push();
+
+    /** \fn void push_task()
+     *  \brief Push task. It sends file size, then file content as binary frames, and
+     *  an empty frame to end stream.
+     */
+    void push_task();
+
+    /** \fn void stop_push()
+     *  \brief Stop push task if it runs, and wait until it has ended.
+     */
+    void stop_push();
+
   public:
-    /** \fn GetFileParserStub(std::shared_ptr<storage::Partition> partition)
+    /** \fn GetFileParserStub(std::shared_ptr<storage::Partition> partition, std::shared_ptr<pipe::UARTPipe> uart_pipe)
      *  \brief Constructor.
      *  \param partition: pointer to a partition handler.
+     *  \param uart_pipe: UART pipe receiving pushed frames (optional).
      */
-    GetFileParserStub(std::shared_ptr<storage::Partition> partition) : FileParserStub(partition)
+    GetFileParserStub(std::shared_ptr<storage::Partition> partition,
+                      std::shared_ptr<pipe::UARTPipe> uart_pipe = nullptr)
+      : FileParserStub(partition), uart_pipe(uart_pipe)
       { this->command = this->default_command; }
 
-    /** \fn ParserTuple parse(const std::string & data)
-     *  \brief Parse given data and return result.
+    /** \fn ~GetFileParserStub()
+     *  \brief Destructor. It stops push task, which refers to this object.
+     */
+    ~GetFileParserStub() { this->stop_push(); }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
      *  \param data: data to parse.
-     *  \returns result compiled as ParserTuple.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
      */
-    ParserTuple parse(const std::string & data) override;
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
     
+    /** \fn void abort()
+     *  \brief Abort current command chain. A running push is stopped first.
+     */
+    void abort() override {
+      this->stop_push();
+      FileParserStub::abort();
+      this->command = this->default_command;
+    }
+  };
+  
+  /** \class PutBinParserStub
+   *  \brief Class to store data to file from binary frames. Once file is open,
+   *  UART pipe switches to binary mode and publishes each frame payload as PutBlock
+   *  command; an empty payload ends transfer.
+   *  If a window size is given, frame payloads start with a 16-bit little-endian
+   *  sequence number, and host may send up to that many frames without waiting
+   *  for replies. Frames received out of order are held until the missing ones
+   *  come; each frame is acknowledged with the next expected sequence number
+   *  (ACK=n), and the first frame after a gap requests the missing one (NAK=n).
+   */
+  class PutBinParserStub : public FileParserStub {
+  private:
+    /** \property inline static const std::string default_command
+     *  \brief Default parser command (this is the command for phase 0).
+     */
+    const std::string default_command = ATCommand::PutBin;
+
+  protected:
+    /** \property uint8_t window
+     *  \brief Number of frames host may send ahead (0 = one frame at a time, without sequence number).
+     */
+    uint8_t window = 0;
+
+    /** \property uint16_t next_seq
+     *  \brief Sequence number of next frame to write.
+     */
+    uint16_t next_seq = 0;
+
+    /** \property std::map<uint16_t, std::string> pending
+     *  \brief Frames received ahead of next_seq, by sequence number.
+     */
+    std::map<uint16_t, std::string> pending;
+
+    /** \property bool gap_reported
+     *  \brief Tell if missing frame was already requested.
+     */
+    bool gap_reported = false;
+
+    /** \property bool write_failed
+     *  \brief Tell if a block couldn't be written; transfer then fails when host ends it.
+     */
+    bool write_failed = false;
+
+    /** \fn bool write_block(std::string_view bytes)
+     *  \brief Write block to file. On failure, file is closed and transfer will fail.
+     *  \param bytes: data to write.
+     *  \returns true if block could be written, false otherwise.
+     */
+    bool write_block(std::string_view bytes);
+
+    /** \fn bool parse_sequenced(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse frame payload starting with a sequence number.
+     *  \param data: frame payload.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if frame was processed, false otherwise.
+     */
+    bool parse_sequenced(std::string_view data, ReplyBuffer & reply);
+
+    /** \fn bool start_transfer(size_t size, int window, ReplyBuffer & reply)
+     *  \brief Enter binary transfer phase.
+     *  \param size: number of bytes to receive.
+     *  \param window: requested window size (capped at CONFIG_UART_MAX_WINDOW).
+     *  \param reply: buffer receiving reply switching UART pipe to binary mode.
+     *  \returns true.
+     */
+    bool start_transfer(size_t size, int window, ReplyBuffer & reply);
+
+    /** \fn bool finish_transfer()
+     *  \brief Complete transfer once all data was received.
+     *  \returns true if written data is complete, false otherwise.
+     */
+    virtual bool finish_transfer() { return this->is_write_complete(); }
+
+  public:
+    /** \fn PutBinParserStub(std::shared_ptr<storage::Partition> partition)
+     *  \brief Constructor.
+     *  \param partition: pointer to a partition handler.
+     */
+    PutBinParserStub(std::shared_ptr<storage::Partition> partition) : FileParserStub(partition)
+      { this->command = this->default_command; }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {
+      FileParserStub::abort();
+      this->window = 0;
+      this->next_seq = 0;
+      this->pending.clear();
+      this->gap_reported = false;
+      this->write_failed = false;
+      this->command = this->default_command;
+    }
+  };
+
+  /** \class OTAParserStub
+   *  \brief Class to update firmware with binary frames, as with PutBinParserStub.
+   *  Image goes straight to inactive app partition; once it is complete and its hash
+   *  matches, it becomes the boot partition and device restarts.
+   */
+  class OTAParserStub : public PutBinParserStub {
+  private:
+    /** \property inline static const std::string default_command
+     *  \brief Default parser command (this is the command for phase 0).
+     */
+    const std::string default_command = ATCommand::OTA;
+
+    /** \property storage::OTAUpdater updater
+     *  \brief Firmware updater.
+     */
+    storage::OTAUpdater updater;
+
+  protected:
+    /** \fn bool write_file(std::string_view data)
+     *  \brief Write image chunk to app partition.
+     *  \param data: image chunk.
+     *  \returns true if chunk could be written, false otherwise.
+     */
+    bool write_file(std::string_view data) override { return this->updater.write(data); }
+
+    /** \fn bool finish_transfer()
+     *  \brief Check image, switch boot partition and schedule restart.
+     *  \returns true if image is valid, false otherwise.
+     */
+    bool finish_transfer() override;
+
+  public:
+    /** \fn OTAParserStub()
+     *  \brief Constructor.
+     */
+    OTAParserStub() : PutBinParserStub(nullptr)
+      { this->command = this->default_command; }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {
+      PutBinParserStub::abort();
+      this->updater.abort();
+      this->command = this->default_command;
+    }
+  };
+
+  /** \class GetBinParserStub
+   *  \brief Class to get data from file as binary frames. Each GetBlock command
+   *  returns a frame with requested number of bytes; argument R resends last frame,
+   *  and 0 ends transfer.
+   *  If a window size is given, frame payloads start with a 16-bit little-endian
+   *  sequence number, host may send requests ahead, and the last frames are
+   *  kept so that any of them can be sent again (argument R,n).
+   */
+  class GetBinParserStub : public FileParserStub {
+  private:
+    /** \property inline static const std::string default_command
+     *  \brief Default parser command (this is the command for phase 0).
+     */
+    const std::string default_command = ATCommand::GetBin;
+
+    /** \property uint8_t window
+     *  \brief Number of requests host may send ahead (0 = one at a time, without sequence number).
+     */
+    uint8_t window = 0;
+
+    /** \property uint16_t next_seq
+     *  \brief Sequence number of next frame.
+     */
+    uint16_t next_seq = 0;
+
+    /** \property std::deque<std::string> history
+     *  \brief Last frames sent, kept for retransmission.
+     */
+    std::deque<std::string> history;
+
+  public:
+    /** \fn GetBinParserStub(std::shared_ptr<storage::Partition> partition)
+     *  \brief Constructor.
+     *  \param partition: pointer to a partition handler.
+     */
+    GetBinParserStub(std::shared_ptr<storage::Partition> partition) : FileParserStub(partition)
+      { this->command = this->default_command; }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+
     /** \fn void abort()
      *  \brief Abort current command chain.
      */
     void abort() override {
       FileParserStub::abort();
+      this->window = 0;
+      this->next_seq = 0;
+      this->history.clear();
       this->command = this->default_command;
     }
   };
   
+  /** \class HashFileParserStub
+   *  \brief Class to compute SHA-256 hash of a file with serial AT commands.
+   *  If a block size is given, hashes of each block are computed in the same pass
+   *  and can then be read with NextHash commands.
+   */
+  class HashFileParserStub : public FileParserStub {
+  private:
+    /** \property inline static const std::string default_command
+     *  \brief Default parser command (this is the command for phase 0).
+     */
+    const std::string default_command = ATCommand::HashFile;
+
+    /** \property std::vector<std::string> block_hashes
+     *  \brief Hashes of file blocks, in hexadecimal form.
+     */
+    std::vector<std::string> block_hashes;
+
+    /** \property std::size_t next_block
+     *  \brief Index of next block hash to send.
+     */
+    std::size_t next_block = 0;
+
+  public:
+    /** \fn HashFileParserStub(std::shared_ptr<storage::Partition> partition)
+     *  \brief Constructor.
+     *  \param partition: pointer to a partition handler.
+     */
+    HashFileParserStub(std::shared_ptr<storage::Partition> partition) : FileParserStub(partition)
+      { this->command = this->default_command; }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {
+      FileParserStub::abort();
+      this->block_hashes.clear();
+      this->next_block = 0;
+      this->command = this->default_command;
+    }
+  };
+
   /** \class ListDirParserStub
-   *  \brief Class to read a directory with serial AT commands.
+   *  \brief Class to read a directory with serial AT commands. Directory is read in
+   *  one pass when opened; entries are then sent one by one, or by pages if a page
+   *  size is given.
    */
   class ListDirParserStub : public PartitionParserStub {
   private:
-    /** \property std::unique_ptr<storage::Directory> dir
-     *  \brief Pointer to a directory handler.
+    /** \property std::vector<storage::FileInfo> entries
+     *  \brief Directory entries.
+     */
+    std::vector<storage::FileInfo> entries;
+
+    /** \property std::size_t next_entry
+     *  \brief Index of next entry to send.
      */
-    std::unique_ptr<storage::Directory> dir;
+    std::size_t next_entry = 0;
+
+    /** \property std::size_t page_size
+     *  \brief Maximum number of entries per reply (0 = one entry per NextFile command, without metadata).
+     */
+    std::size_t page_size = 0;
+
+    /** \fn void get_page(ReplyBuffer & reply)
+     *  \brief Compile next page of entries.
+     *  \param reply: buffer receiving number of remaining entries after this page, and
+     *  entries as type,size,mtime,name separated by '/'.
+     */
+    void get_page(ReplyBuffer & reply);
 
     /** \property uint8_t phase
      *  \brief Parser phase (0=open directory, 1=read file info)
@@ -209,11 +759,6 @@ namespace eobsws::comm::parser::serial {
      */
     const std::string default_command = ATCommand::ListDir;
 
-    /** \property std::size_t remaining_files
-     *  \brief Remaining number of files to be listed.
-     */
-    std::size_t remaining_files;
-
   public:
     /** \fn ListDirParserStub(std::shared_ptr<storage::Partition> partition)
      *  \brief Constructor.
@@ -222,18 +767,21 @@ namespace eobsws::comm::parser::serial {
     ListDirParserStub(std::shared_ptr<storage::Partition> partition) : PartitionParserStub(partition)
       { this->command = this->default_command; }
 
-    /** \fn ParserTuple parse(const std::string & data)
-     *  \brief Parse given data and return result.
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
      *  \param data: data to parse.
-     *  \returns result compiled as ParserTuple.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
      */
-    ParserTuple parse(const std::string & data) override;
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
 
     /** \fn void abort()
      *  \brief Abort current command chain.
      */
     void abort() override {
-      this->dir = nullptr;
+      this->entries.clear();
+      this->next_entry = 0;
+      this->page_size = 0;
       this->phase = 0;
       this->command = this->default_command;
     }
@@ -252,12 +800,13 @@ namespace eobsws::comm::parser::serial {
     DeleteFileParserStub(std::shared_ptr<storage::Partition> partition) : PartitionParserStub(partition)
       { this->command = ATCommand::Delete; }
 
-    /** \fn ParserTuple parse(const std::string & data)
-     *  \brief Parse given data and return result.
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
      *  \param data: data to parse.
-     *  \returns result compiled as ParserTuple.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
      */
-    ParserTuple parse(const std::string & file_name) override;
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
     
   };
 
@@ -273,18 +822,19 @@ namespace eobsws::comm::parser::serial {
     MakedirParserStub(std::shared_ptr<storage::Partition> partition) : PartitionParserStub(partition)
       { this->command = ATCommand::MakeDir; }
 
-    /** \fn ParserTuple parse(const std::string & data)
-     *  \brief Parse given data and return result.
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
      *  \param data: data to parse.
-     *  \returns result compiled as ParserTuple.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
      */
-    ParserTuple parse(const std::string & dir_name) override;
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
   };
 
   /** \class NVSParserStub
    *  \brief Base class used to access a non-volatile storage partition.
    */
-  class NVSParserStub : public ParserStub {
+  class NVSParserStub : public SerialParserStub {
   protected:
     /** \property std::shared_ptr<storage::NVStorage> partition
      *  \brief Pointer to a non-volatile storage partition handler.
@@ -316,12 +866,62 @@ namespace eobsws::comm::parser::serial {
     SetConfigParserStub(std::shared_ptr<storage::NVStorage> partition) : NVSParserStub(partition)
       { this->command = ATCommand::SetConf; }
 
-    /** \fn ParserTuple parse(const std::string & data)
-     *  \brief Parse given data and return result.
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
      *  \param data: data to parse.
-     *  \returns result compiled as ParserTuple.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
      */
-    ParserTuple parse(const std::string & data) override;
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+  };
+
+  /** \class SetConfigBatchParserStub
+   *  \brief Class to set many configuration items at once. A batch starts with
+   *  argument BEGIN, continues with records in the same format as SetConf, and
+   *  ends with COMMIT. Records are checked against stored key types when received,
+   *  and written on commit, with one flash commit per namespace.
+   */
+  class SetConfigBatchParserStub : public NVSParserStub {
+  private:
+    /** \property bool started
+     *  \brief Tell if a batch was started.
+     */
+    bool started = false;
+
+    /** \property std::map< std::string, std::vector<storage::NVSRecord> > records
+     *  \brief Records received, by namespace.
+     */
+    std::map< std::string, std::vector<storage::NVSRecord> > records;
+
+    /** \property std::map< std::string, std::map<std::string, storage::ItemType> > types
+     *  \brief Stored key types, by namespace (loaded on first record for namespace).
+     */
+    std::map< std::string, std::map<std::string, storage::ItemType> > types;
+
+  public:
+    /** \fn SetConfigBatchParserStub(std::shared_ptr<storage::Partition> partition)
+     *  \brief Constructor.
+     *  \param partition: pointer to a non-volatile storage partition handler.
+     */
+    SetConfigBatchParserStub(std::shared_ptr<storage::NVStorage> partition) : NVSParserStub(partition)
+      { this->command = ATCommand::SetConfBatch; }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {
+      this->started = false;
+      this->records.clear();
+      this->types.clear();
+    }
   };
 
   /** \class GetConfigParserStub
@@ -336,12 +936,13 @@ namespace eobsws::comm::parser::serial {
     GetConfigParserStub(std::shared_ptr<storage::NVStorage> partition) : NVSParserStub(partition)
       { this->command = ATCommand::GetConf; }
 
-    /** \fn ParserTuple parse(const std::string & data)
-     *  \brief Parse given data and return result.
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
      *  \param data: data to parse.
-     *  \returns result compiled as ParserTuple.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
      */
-    ParserTuple parse(const std::string & data) override;
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
   };
 
   /** \class DelConfigParserStub
@@ -356,30 +957,132 @@ namespace eobsws::comm::parser::serial {
     DelConfigParserStub(std::shared_ptr<storage::NVStorage> partition) : NVSParserStub(partition)
       { this->command = ATCommand::DelConf; }
 
-    /** \fn ParserTuple parse(const std::string & data)
-     *  \brief Parse given data and return result.
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
      *  \param data: data to parse.
-     *  \returns result compiled as ParserTuple.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+  };
+
+  /** \class DumpConfigParserStub
+   *  \brief Class to export all configuration items with a serial AT command. Reply
+   *  gives blob size, then blob (see NVStorage::dump) as binary frames, ending with
+   *  an empty frame; they are written to UART pipe directly, paced by link. Reply is
+   *  an error if a key can't be exported, or if blob is too large to be loaded back.
+   */
+  class DumpConfigParserStub : public NVSParserStub {
+  private:
+    /** \property std::shared_ptr<pipe::UARTPipe> uart_pipe
+     *  \brief UART pipe receiving frames.
+     */
+    std::shared_ptr<pipe::UARTPipe> uart_pipe;
+
+  public:
+    /** \fn DumpConfigParserStub(std::shared_ptr<storage::NVStorage> partition, std::shared_ptr<pipe::UARTPipe> uart_pipe)
+     *  \brief Constructor.
+     *  \param partition: pointer to a non-volatile storage partition handler.
+     *  \param uart_pipe: UART pipe receiving frames.
+     */
+    DumpConfigParserStub(std::shared_ptr<storage::NVStorage> partition,
+                         std::shared_ptr<pipe::UARTPipe> uart_pipe) : NVSParserStub(partition), uart_pipe(uart_pipe)
+      { this->command = ATCommand::DumpConf; }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+  };
+
+  /** \class LoadConfigParserStub
+   *  \brief Class to import configuration items from a blob made by DumpConf. Blob is
+   *  sent as binary frames, as with PutBinParserStub, and imported once complete.
+   */
+  class LoadConfigParserStub : public PutBinParserStub {
+  private:
+    /** \property inline static const std::string default_command
+     *  \brief Default parser command (this is the command for phase 0).
+     */
+    const std::string default_command = ATCommand::LoadConf;
+
+    /** \property std::shared_ptr<storage::NVStorage> nvs
+     *  \brief Pointer to a non-volatile storage partition handler.
+     */
+    std::shared_ptr<storage::NVStorage> nvs;
+
+    /** \property std::string blob
+     *  \brief Blob received so far.
+     */
+    std::string blob;
+
+  protected:
+    /** \fn bool write_file(std::string_view data)
+     *  \brief Append chunk to received blob.
+     *  \param data: blob chunk.
+     *  \returns true.
+     */
+    bool write_file(std::string_view data) override {
+      this->blob.append(data);
+      return true;
+    }
+
+    /** \fn bool finish_transfer()
+     *  \brief Import received blob.
+     *  \returns true if all keys could be written, false otherwise.
+     */
+    bool finish_transfer() override {
+      if (!this->nvs->load(this->blob)) return false;
+      this->config_change = "*";
+      return true;
+    }
+
+  public:
+    /** \fn LoadConfigParserStub(std::shared_ptr<storage::NVStorage> nvs)
+     *  \brief Constructor.
+     *  \param nvs: pointer to a non-volatile storage partition handler.
+     */
+    LoadConfigParserStub(std::shared_ptr<storage::NVStorage> nvs) : PutBinParserStub(nullptr), nvs(nvs)
+      { this->command = this->default_command; }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
      */
-    ParserTuple parse(const std::string & data) override;
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {
+      PutBinParserStub::abort();
+      std::string().swap(this->blob); // releases memory
+      this->command = this->default_command;
+    }
   };
 
   /** \class GetBufSizeParserStub
    *  \brief Class to retrieve the serial buffer size with a serial AT command.
    */
-  class GetBufSizeParserStub : public ParserStub {
+  class GetBufSizeParserStub : public SerialParserStub {
   public:
     /** \fn GetBufSizeParserStub()
      *  \brief Constructor.
      */
     GetBufSizeParserStub() { this->command = ATCommand::GetBufferSize; }
 
-    /** \fn ParserTuple parse(const std::string & data)
-     *  \brief Parse given data and return result.
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
      *  \param data: data to parse.
-     *  \returns result compiled as ParserTuple.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
      */
-    ParserTuple parse(const std::string & dir_name) override;
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
         
     /** \fn void abort()
      *  \brief Abort current command chain.
@@ -390,19 +1093,353 @@ namespace eobsws::comm::parser::serial {
   /** \class GetFirmwareVersionParserStub
    *  \brief Class to retrieve the firmware version.
    */
-  class GetFirmwareVersionParserStub : public ParserStub {
+  class GetFirmwareVersionParserStub : public SerialParserStub {
   public:
     /** \fn GetFirmwareVersionParserStub()
      *  \brief Constructor.
      */
     GetFirmwareVersionParserStub() { this->command = ATCommand::GetFirmwareVersion; }
 
-    /** \fn ParserTuple parse(const std::string & data)
-     *  \brief Parse given data and return result.
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
      *  \param data: data to parse.
-     *  \returns result compiled as ParserTuple.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+        
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {};
+  };
+
+  /** \class GetLinkStatsParserStub
+   *  \brief Class to retrieve obs-websocket link statistics. Argument is the
+   *  connection index (0 if omitted).
+   */
+  class GetLinkStatsParserStub : public SerialParserStub {
+  private:
+    /** \property std::vector< std::shared_ptr<pipe::WebSocketPipe> > ws_pipes
+     *  \brief WebSocket pipes from which statistics are read.
+     */
+    std::vector< std::shared_ptr<pipe::WebSocketPipe> > ws_pipes;
+
+  public:
+    /** \fn GetLinkStatsParserStub(const std::vector< std::shared_ptr<pipe::WebSocketPipe> > & ws_pipes)
+     *  \brief Constructor.
+     *  \param ws_pipes: WebSocket pipes from which statistics are read.
+     */
+    GetLinkStatsParserStub(const std::vector< std::shared_ptr<pipe::WebSocketPipe> > & ws_pipes) : ws_pipes(ws_pipes) {
+      this->command = ATCommand::GetStats;
+    }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+        
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {};
+  };
+
+  /** \class SetBaudRateParserStub
+   *  \brief Class to switch UART link to another baud rate. Argument is the baud rate,
+   *  optionally followed by 1 to enable RTS/CTS flow control. Reply is sent at
+   *  current rate, after which host must confirm at new rate with ConfirmBaud.
+   *  Rate is switched right after this reply, so that other messages sent in between
+   *  don't trigger it.
+   */
+  class SetBaudRateParserStub : public SerialParserStub {
+  private:
+    /** \property std::shared_ptr<pipe::UARTPipe> uart_pipe
+     *  \brief UART pipe to reconfigure.
+     */
+    std::shared_ptr<pipe::UARTPipe> uart_pipe;
+
+  public:
+    /** \fn SetBaudRateParserStub(std::shared_ptr<pipe::UARTPipe> uart_pipe)
+     *  \brief Constructor.
+     *  \param uart_pipe: UART pipe to reconfigure.
+     */
+    SetBaudRateParserStub(std::shared_ptr<pipe::UARTPipe> uart_pipe) : uart_pipe(uart_pipe) {
+      this->command = ATCommand::SetBaud;
+    }
+
+    /** \fn void reply_sent()
+     *  \brief Switch baud rate once reply was queued at current rate.
+     */
+    void reply_sent() override { this->uart_pipe->switch_baud_rate(); }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+        
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {};
+  };
+
+  /** \class ConfirmBaudRateParserStub
+   *  \brief Class to confirm a baud rate switch requested with SetBaud.
+   */
+  class ConfirmBaudRateParserStub : public SerialParserStub {
+  private:
+    /** \property std::shared_ptr<pipe::UARTPipe> uart_pipe
+     *  \brief UART pipe that switched baud rate.
+     */
+    std::shared_ptr<pipe::UARTPipe> uart_pipe;
+
+  public:
+    /** \fn ConfirmBaudRateParserStub(std::shared_ptr<pipe::UARTPipe> uart_pipe)
+     *  \brief Constructor.
+     *  \param uart_pipe: UART pipe that switched baud rate.
+     */
+    ConfirmBaudRateParserStub(std::shared_ptr<pipe::UARTPipe> uart_pipe) : uart_pipe(uart_pipe) {
+      this->command = ATCommand::ConfirmBaud;
+    }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+        
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {};
+  };
+
+  /** \class ScreenshotParserStub
+   *  \brief Class to capture screen content with a serial AT command. Next frame drawn
+   *  is copied to a snapshot buffer (in PSRAM) by display task; a task then replies
+   *  with screen size (SCREEN=width,height), and streams the snapshot as binary frames
+   *  coded row by row (see rle namespace), paced by room in UART transmit queue. An
+   *  empty frame ends the stream, when snapshot was sent or host sends AT+ABORT.
+   */
+  class ScreenshotParserStub : public SerialParserStub {
+  private:
+    /** \property std::shared_ptr<hardware::screen::ScreenLVGL> screen
+     *  \brief Display to capture.
+     */
+    std::shared_ptr<hardware::screen::ScreenLVGL> screen;
+
+    /** \property std::shared_ptr<pipe::UARTPipe> uart_pipe
+     *  \brief UART pipe receiving snapshot.
+     */
+    std::shared_ptr<pipe::UARTPipe> uart_pipe;
+
+    /** \property uint32_t * buffer
+     *  \brief Snapshot buffer (allocated while a capture runs).
+     */
+    uint32_t * buffer = nullptr;
+
+    /** \property std::atomic<bool> running
+     *  \brief Tell if capture task is running.
+     */
+    std::atomic<bool> running = false;
+
+    /** \property std::atomic<bool> stop_requested
+     *  \brief Tell capture task to end stream after current frame.
+     */
+    std::atomic<bool> stop_requested = false;
+
+    /** \fn void capture_task()
+     *  \brief Capture task. It waits until frame was captured, then sends it.
+     */
+    void capture_task();
+
+  public:
+    /** \fn ScreenshotParserStub(std::shared_ptr<hardware::screen::ScreenLVGL> screen, std::shared_ptr<pipe::UARTPipe> uart_pipe)
+     *  \brief Constructor.
+     *  \param screen: display to capture.
+     *  \param uart_pipe: UART pipe receiving snapshot.
+     */
+    ScreenshotParserStub(std::shared_ptr<hardware::screen::ScreenLVGL> screen,
+                         std::shared_ptr<pipe::UARTPipe> uart_pipe) : screen(screen), uart_pipe(uart_pipe) {
+      this->command = ATCommand::Screenshot;
+    }
+
+    /** \fn ~ScreenshotParserStub()
+     *  \brief Destructor. It stops capture task, which refers to this object.
+     */
+    ~ScreenshotParserStub() { this->abort(); }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+        
+    /** \fn void abort()
+     *  \brief Abort current command chain. A running capture is stopped, and
+     *  waited for.
+     */
+    void abort() override;
+  };
+
+
+  /** \class TouchParserStub
+   *  \brief Class to inject a touch event with a serial AT command, as if it came from
+   *  touch panel. Arguments are X and Y positions in screen coordinates, and optionally
+   *  press duration in milliseconds (DefaultTouchDuration if omitted). Event is traced
+   *  (see GetTraceParserStub).
+   */
+  class TouchParserStub : public SerialParserStub {
+  private:
+    /** \property std::shared_ptr<hardware::input::TouchpadLVGL> touch
+     *  \brief LVGL touchpad receiving events.
+     */
+    std::shared_ptr<hardware::input::TouchpadLVGL> touch;
+
+  public:
+    /** \fn TouchParserStub(std::shared_ptr<hardware::input::TouchpadLVGL> touch)
+     *  \brief Constructor.
+     *  \param touch: LVGL touchpad receiving events.
+     */
+    TouchParserStub(std::shared_ptr<hardware::input::TouchpadLVGL> touch) : touch(touch) {
+      this->command = ATCommand::Touch;
+    }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+        
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {};
+  };
+
+  /** \class SetPotParserStub
+   *  \brief Class to force the value of a potentiometer pin with a serial AT command, as if
+   *  pin read it. Arguments are pin index and raw value; without value, pin goes back
+   *  to measurements. Value change is traced (see GetTraceParserStub).
+   */
+  class SetPotParserStub : public SerialParserStub {
+  private:
+    /** \property std::vector< std::shared_ptr<hardware::AnalogPin> > pins
+     *  \brief Potentiometer pins that can be forced.
+     */
+    std::vector< std::shared_ptr<hardware::AnalogPin> > pins;
+
+  public:
+    /** \fn SetPotParserStub(const std::vector< std::shared_ptr<hardware::AnalogPin> > & pins)
+     *  \brief Constructor.
+     *  \param pins: potentiometer pins that can be forced (battery monitor excluded).
+     */
+    SetPotParserStub(const std::vector< std::shared_ptr<hardware::AnalogPin> > & pins) : pins(pins) {
+      this->command = ATCommand::SetPot;
+    }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+        
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {};
+  };
+
+  /** \class GetTraceParserStub
+   *  \brief Class to retrieve stages reached by last injected input event. Reply gives
+   *  delays between injection and input driver read, WebSocket queueing and WebSocket
+   *  send, in microseconds (-1 for stages not reached yet).
+   */
+  class GetTraceParserStub : public SerialParserStub {
+  public:
+    /** \fn GetTraceParserStub()
+     *  \brief Constructor.
+     */
+    GetTraceParserStub() { this->command = ATCommand::GetTrace; }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+        
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {};
+  };
+
+
+  /** \class BenchImageParserStub
+   *  \brief Class to measure PNG image load time, with or without file block cache.
+   *  Command takes a file path and a mode: 0 reads file directly, 1 reads it through
+   *  an emptied cache, 2 through cache as it is. Reply gives load time in microseconds,
+   *  number of file system reads, bytes read from file system, cache hits and misses.
+   */
+  class BenchImageParserStub : public PartitionParserStub {
+  public:
+    /** \fn BenchImageParserStub(std::shared_ptr<storage::Partition> partition)
+     *  \brief Constructor.
+     *  \param partition: partition holding images.
+     */
+    BenchImageParserStub(std::shared_ptr<storage::Partition> partition) : PartitionParserStub(partition)
+      { this->command = ATCommand::BenchImage; }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
+     */
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
+        
+    /** \fn void abort()
+     *  \brief Abort current command chain.
+     */
+    void abort() override {};
+  };
+
+
+  /** \class ReloadConfigParserStub
+   *  \brief Class to tell that configuration may have changed by other means than serial
+   *  commands (which announce their changes themselves), so that it is applied.
+   */
+  class ReloadConfigParserStub : public SerialParserStub {
+  public:
+    /** \fn ReloadConfigParserStub()
+     *  \brief Constructor.
+     */
+    ReloadConfigParserStub() { this->command = ATCommand::Reload; }
+
+    /** \fn bool parse(std::string_view data, ReplyBuffer & reply)
+     *  \brief Parse given data and format reply.
+     *  \param data: data to parse.
+     *  \param reply: buffer receiving reply.
+     *  \returns true if command succeeded, false otherwise.
      */
-    ParserTuple parse(const std::string & dir_name) override;
+    bool parse(std::string_view data, ReplyBuffer & reply) override;
         
     /** \fn void abort()
      *  \brief Abort current command chain.
@@ -0,0 +1,116 @@
+/** \file framing.cpp
+ *  \brief Implementation file for binary frames exchanged on the serial link.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "framing.h"
+#include "esp_rom_crc.h"
+#include <string.h>
+#include <algorithm>
+
+namespace eobsws::comm::pipe::framing {
+
+  const std::string BinaryModeReply = "BINMODE";
+  const std::string CrcErrorReply = "CRCERR\r";
+  const std::string BlockCommand = "AT+PUTBLK=";
+
+  /** \fn static inline uint32_t get_le(const std::string & data, size_t pos, size_t len)
+   *  \brief Read a little-endian integer from a string.
+   *  \param data: string to read from.
+   *  \param pos: position of first byte.
+   *  \param len: number of bytes.
+   *  \returns integer value.
+   */
+  static inline uint32_t get_le(const std::string & data, size_t pos, size_t len) {
+    uint32_t value = 0;
+    for (size_t n=0; n<len; n++)
+      value |= static_cast<uint32_t>(static_cast<uint8_t>(data[pos+n])) << (8*n);
+    return value;
+  }
+
+  /** \fn static inline void put_le(std::string & data, uint32_t value, size_t len)
+   *  \brief Append a little-endian integer to a string.
+   *  \param data: string to append to.
+   *  \param value: integer value.
+   *  \param len: number of bytes.
+   */
+  static inline void put_le(std::string & data, uint32_t value, size_t len) {
+    for (size_t n=0; n<len; n++)
+      data.push_back(static_cast<char>((value >> (8*n)) & 0xff));
+  }
+
+
+  uint32_t crc32(std::string_view data) {
+    return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+  }
+
+
+  std::string encode(const std::string & payload) {
+    std::string frame;
+    encode(payload, frame);
+    return frame;
+  }
+
+  void encode(std::string_view payload, std::string & frame) {
+    frame.clear();
+    frame.reserve(HeaderSize + payload.size() + CrcSize);
+    frame.push_back(StartByte);
+    put_le(frame, payload.size(), 2);
+    frame.append(payload);
+    put_le(frame, crc32(payload), CrcSize);
+  }
+
+
+  size_t FrameDecoder::feed(const char * bytes, size_t len, FrameStatus & status) {
+    status = FrameStatus::Incomplete;
+    size_t pos = 0;
+    if (!this->in_frame) {
+      // skip anything up to start byte
+      auto start = static_cast<const char*>(memchr(bytes, StartByte, len));
+      if (start == nullptr) return len;
+      pos = start - bytes + 1;
+      this->frame.clear();
+      this->in_frame = true;
+    }
+    // frame holds length, payload and CRC; length is needed to know the rest
+    auto lsize = HeaderSize - 1;
+    size_t expected = lsize;
+    if (this->frame.size() < lsize) {
+      auto n = std::min(len - pos, lsize - this->frame.size());
+      this->frame.append(bytes + pos, n);
+      pos += n;
+      if (this->frame.size() < lsize) return pos;
+    }
+    auto payload_size = get_le(this->frame, 0, lsize);
+    if (payload_size > MaxPayload) {
+      this->reset();
+      status = FrameStatus::Corrupted;
+      return pos;
+    }
+    expected += payload_size + CrcSize;
+    auto n = std::min(len - pos, expected - this->frame.size());
+    this->frame.append(bytes + pos, n);
+    pos += n;
+    if (this->frame.size() < expected) return pos;
+
+    this->in_frame = false;
+    auto crc = get_le(this->frame, lsize + payload_size, CrcSize);
+    status = (crc == crc32(this->get_payload())) ? FrameStatus::Complete : FrameStatus::Corrupted;
+    return pos;
+  }
+
+
+  std::string_view FrameDecoder::get_payload() const {
+    auto lsize = HeaderSize - 1;
+    if (this->frame.size() < lsize + CrcSize) return {};
+    return std::string_view(this->frame).substr(lsize, this->frame.size() - lsize - CrcSize);
+  }
+
+
+  void FrameDecoder::reset() {
+    this->frame.clear();
+    this->in_frame = false;
+  }
+
+}
@@ -0,0 +1,124 @@
+/** \file framing.h
+ *  \brief Header file for binary frames exchanged on the serial link.
+ *  A frame is made of a start byte (STX), a 16-bit little-endian payload length,
+ *  the payload and a little-endian CRC32 of the payload. A frame with empty payload
+ *  ends a binary transfer.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#pragma once
+#include "sdkconfig.h"
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+/** \namespace eobsws::comm::pipe::framing
+ *  \brief Binary framing for serial link.
+ */
+namespace eobsws::comm::pipe::framing {
+
+  /** \var constexpr char StartByte
+   *  \brief Start of frame marker.
+   */
+  constexpr char StartByte = 0x02;
+
+  /** \var constexpr size_t HeaderSize
+   *  \brief Size of frame header (start byte and length).
+   */
+  constexpr size_t HeaderSize = 3;
+
+  /** \var constexpr size_t CrcSize
+   *  \brief Size of frame trailer (CRC32).
+   */
+  constexpr size_t CrcSize = 4;
+
+  /** \var constexpr size_t MaxPayload
+   *  \brief Maximum payload size. Larger frames are rejected.
+   */
+  constexpr size_t MaxPayload = CONFIG_UART_BUF_SIZE;
+
+  /** \var const std::string BinaryModeReply
+   *  \brief Prefix of reply after which UART pipe expects binary frames.
+   */
+  extern const std::string BinaryModeReply;
+
+  /** \var const std::string CrcErrorReply
+   *  \brief Reply sent when a received frame is corrupted.
+   */
+  extern const std::string CrcErrorReply;
+
+  /** \var const std::string BlockCommand
+   *  \brief Command under which frame payloads are published.
+   */
+  extern const std::string BlockCommand;
+
+  /** \fn uint32_t crc32(std::string_view data)
+   *  \brief Compute CRC32 (IEEE 802.3, as zlib) of given data.
+   *  \param data: data to process.
+   *  \returns CRC value.
+   */
+  uint32_t crc32(std::string_view data);
+
+  /** \fn std::string encode(const std::string & payload)
+   *  \brief Pack payload into a frame.
+   *  \param payload: frame payload (up to MaxPayload bytes).
+   *  \returns encoded frame.
+   */
+  std::string encode(const std::string & payload);
+
+  /** \fn void encode(std::string_view payload, std::string & frame)
+   *  \brief Encode payload into a frame, reusing given string, so that a sequence of
+   *  frames is encoded without memory allocations.
+   *  \param payload: frame payload (up to MaxPayload bytes).
+   *  \param frame: string receiving encoded frame; previous content is replaced.
+   */
+  void encode(std::string_view payload, std::string & frame);
+
+  /** \enum FrameStatus
+   *  \brief Decoder status after feeding data.
+   */
+  enum class FrameStatus {
+    Incomplete, ///< more data is needed
+    Complete, ///< a valid frame was received
+    Corrupted ///< a frame was received, but its CRC doesn't match
+  };
+
+  /** \class FrameDecoder
+   *  \brief Incremental frame decoder. Bytes outside frames are skipped.
+   */
+  class FrameDecoder {
+  private:
+    /** \property std::string frame
+     *  \brief Frame being assembled, without start byte.
+     */
+    std::string frame;
+
+    /** \property bool in_frame
+     *  \brief Tell if start byte was found.
+     */
+    bool in_frame = false;
+
+  public:
+    /** \fn size_t feed(const char * bytes, size_t len, FrameStatus & status)
+     *  \brief Feed received bytes to decoder. It stops consuming bytes at frame end.
+     *  \param bytes: received bytes.
+     *  \param len: number of bytes.
+     *  \param status: decoder status.
+     *  \returns number of bytes consumed.
+     */
+    size_t feed(const char * bytes, size_t len, FrameStatus & status);
+
+    /** \fn std::string_view get_payload() const
+     *  \brief Get payload of last frame.
+     *  \returns payload, valid until next call to feed.
+     */
+    std::string_view get_payload() const;
+
+    /** \fn void reset()
+     *  \brief Drop frame being assembled.
+     */
+    void reset();
+  };
+
+}
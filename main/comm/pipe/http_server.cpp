@@ -0,0 +1,386 @@
+/** \file http_server.cpp
+ *  \brief Implementation file for HTTP file and configuration server.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "http_server.h"
+#include "framing.h"
+#include "comm/parser/serial_parser_stub.h"
+#include "util.h"
+#include "esp_log.h"
+#include <cstring>
+#include <string_view>
+#include <algorithm>
+
+namespace eobsws::comm::pipe {
+
+  using namespace eobsws::comm::parser;
+
+  /** \var static const std::string FilesPrefix
+   *  \brief URI prefix of file endpoints.
+   */
+  static const std::string FilesPrefix = "/files/";
+
+  /** \var static const std::string DirPrefix
+   *  \brief URI prefix of directory endpoint.
+   */
+  static const std::string DirPrefix = "/dir/";
+
+  /** \var static constexpr size_t ListPageSize
+   *  \brief Number of directory entries requested from parser stub at once.
+   */
+  static constexpr size_t ListPageSize = 64;
+
+  /** \fn static std::string get_path(httpd_req_t * req, const std::string & prefix)
+   *  \brief Extract percent-decoded path following prefix in request URI.
+   *  \param req: request.
+   *  \param prefix: URI prefix.
+   *  \returns path, without query string.
+   */
+  static std::string get_path(httpd_req_t * req, const std::string & prefix) {
+    std::string uri(req->uri);
+    uri = uri.substr(0, uri.find('?'));
+    uri.erase(0, std::min(prefix.size(), uri.size()));
+    std::string path;
+    path.reserve(uri.size());
+    for (size_t n=0; n<uri.size(); n++) {
+      if (uri[n] == '%' && n + 2 < uri.size() && isxdigit(uri[n+1]) && isxdigit(uri[n+2])) {
+        path.push_back(static_cast<char>(strtoul(uri.substr(n+1, 2).c_str(), nullptr, 16)));
+        n += 2;
+      } else {
+        path.push_back(uri[n]);
+      }
+    }
+    return path;
+  }
+
+  /** \fn static bool is_safe_path(const std::string & path)
+   *  \brief Tell if a decoded path can be handed to parser stubs: none of its segments
+   *  is "..", so that it stays within partition, and it holds no comma (argument separator)
+   *  or control character (line terminator).
+   *  \param path: percent-decoded path.
+   *  \returns true if path is safe, false otherwise.
+   */
+  static bool is_safe_path(const std::string & path) {
+    for (auto c: path)
+      if (c == ',' || iscntrl(static_cast<unsigned char>(c))) return false;
+    for (size_t start = 0; start <= path.size(); ) {
+      auto end = std::min(path.find('/', start), path.size());
+      if (path.compare(start, end - start, "..") == 0) return false;
+      start = end + 1;
+    }
+    return true;
+  }
+
+  /** \fn static bool equals_constant_time(std::string_view value, std::string_view expected)
+   *  \brief Compare strings in a time that doesn't depend on where they differ, so that
+   *  response time doesn't tell how much of a secret was guessed.
+   *  \param value: string to check.
+   *  \param expected: secret string.
+   *  \returns true if strings are equal, false otherwise.
+   */
+  static bool equals_constant_time(std::string_view value, std::string_view expected) {
+    uint8_t diff = value.size() != expected.size();
+    for (size_t n=0; n<expected.size(); n++)
+      diff |= static_cast<uint8_t>((n < value.size() ? value[n] : 0) ^ expected[n]);
+    return diff == 0;
+  }
+
+  /** \fn static std::string get_query_value(httpd_req_t * req, const char * key)
+   *  \brief Get value of query string parameter.
+   *  \param req: request.
+   *  \param key: parameter name.
+   *  \returns parameter value, or empty string if absent.
+   */
+  static std::string get_query_value(httpd_req_t * req, const char * key) {
+    auto len = httpd_req_get_url_query_len(req);
+    if (len == 0) return "";
+    std::string query(len + 1, '\0');
+    char value[16] = {};
+    if (httpd_req_get_url_query_str(req, query.data(), query.size()) != ESP_OK
+        || httpd_query_key_value(query.c_str(), key, value, sizeof(value)) != ESP_OK)
+      return "";
+    return value;
+  }
+
+  /** \fn static std::string strip_line(const std::string & line)
+   *  \brief Remove carriage return ending a line or a parser stub reply.
+   *  \param line: line to strip.
+   *  \returns stripped line.
+   */
+  static std::string strip_line(const std::string & line) {
+    if (!line.empty() && line.back() == '\r') return line.substr(0, line.size() - 1);
+    return line;
+  }
+
+  /** \fn static bool run_stub(serial::SerialParserStub & stub, std::string_view data, serial::ReplyBuffer & reply)
+   *  \brief Pass data to parser stub, replacing previous reply.
+   *  \param stub: parser stub.
+   *  \param data: data to parse.
+   *  \param reply: buffer receiving reply.
+   *  \returns true if parser stub succeeded, false otherwise.
+   */
+  static inline bool run_stub(serial::SerialParserStub & stub, std::string_view data, serial::ReplyBuffer & reply) {
+    reply.clear();
+    return stub.parse(data, reply);
+  }
+
+  /** \fn static void notify_change(std::shared_ptr<DataBroker> db, serial::SerialParserStub & stub)
+   *  \brief Announce configuration change made by parser stub, if any.
+   *  \param db: data broker receiving notification.
+   *  \param stub: parser stub.
+   */
+  static void notify_change(std::shared_ptr<DataBroker> db, serial::SerialParserStub & stub) {
+    auto change = stub.take_config_change();
+    if (!change.empty())
+      db->broadcast(MessageType::ConfigChanged, change);
+  }
+
+
+  HTTPServer::HTTPServer(std::shared_ptr<storage::Partition> partition,
+                         std::shared_ptr<storage::NVStorage> nvs,
+                         std::shared_ptr<DataBroker> db,
+                         const std::string & token) : partition(partition), nvs(nvs), db(db), token(token) {}
+
+  HTTPServer::~HTTPServer() {
+    if (this->ip_handler != nullptr)
+      esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, this->ip_handler);
+    if (this->server != nullptr)
+      httpd_stop(this->server);
+  }
+
+
+  void HTTPServer::enable() {
+    auto fip = [](void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+      reinterpret_cast<HTTPServer*>(arg)->start();
+    };
+    esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, fip,
+                                        static_cast<void*>(this), &this->ip_handler);
+  }
+
+
+  void HTTPServer::start() {
+    // server keeps running across WiFi reconnections
+    if (this->server != nullptr) return;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_HTTP_SERVER_PORT;
+    config.stack_size = CONFIG_HTTP_SERVER_STACK_SIZE;
+    config.uri_match_fn = httpd_uri_match_wildcard;
+    config.lru_purge_enable = true;
+    if (httpd_start(&this->server, &config) != ESP_OK) {
+      ESP_LOGE("HTTPServer", "cannot start server.");
+      this->server = nullptr;
+      return;
+    }
+    const httpd_uri_t uris[] = {
+      {"/files/*", HTTP_PUT, call_handler<&HTTPServer::put_file>, this},
+      {"/files/*", HTTP_GET, call_handler<&HTTPServer::get_file>, this},
+      {"/dir/*", HTTP_GET, call_handler<&HTTPServer::list_dir>, this},
+      {"/config", HTTP_POST, call_handler<&HTTPServer::set_config>, this},
+      {"/config/get", HTTP_POST, call_handler<&HTTPServer::get_config>, this}
+    };
+    for (auto & uri: uris)
+      httpd_register_uri_handler(this->server, &uri);
+    ESP_LOGI("HTTPServer", "server listening on port %d.", CONFIG_HTTP_SERVER_PORT);
+  }
+
+
+  bool HTTPServer::authorize(httpd_req_t * req) const {
+    auto len = httpd_req_get_hdr_value_len(req, "Authorization");
+    if (len == 0) return false;
+    std::string value(len + 1, '\0');
+    if (httpd_req_get_hdr_value_str(req, "Authorization", value.data(), value.size()) != ESP_OK)
+      return false;
+    value.resize(len);
+    return equals_constant_time(value, "Bearer " + this->token);
+  }
+
+
+  template<esp_err_t (HTTPServer::*handler)(httpd_req_t*)>
+  esp_err_t HTTPServer::call_handler(httpd_req_t * req) {
+    auto obj = reinterpret_cast<HTTPServer*>(req->user_ctx);
+    if (!obj->authorize(req))
+      return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "invalid token");
+    return (obj->*handler)(req);
+  }
+
+
+  bool HTTPServer::read_lines(httpd_req_t * req, const std::function<bool(const std::string &)> & callback) {
+    std::string buffer(CONFIG_HTTP_SERVER_BUF_SIZE, '\0');
+    size_t len = 0; // number of bytes in buffer
+    size_t remaining = req->content_len;
+    while (remaining > 0 || len > 0) {
+      if (remaining > 0) {
+        auto n = httpd_req_recv(req, buffer.data() + len, std::min(remaining, buffer.size() - len));
+        if (n == HTTPD_SOCK_ERR_TIMEOUT) continue;
+        if (n <= 0) return false;
+        len += n;
+        remaining -= n;
+      }
+      // complete lines are processed; last line doesn't need a terminator
+      size_t start = 0;
+      for (auto end = static_cast<const char*>(memchr(buffer.data(), '\n', len)); end != nullptr;
+           end = static_cast<const char*>(memchr(buffer.data() + start, '\n', len - start))) {
+        auto line = strip_line(buffer.substr(start, end - buffer.data() - start));
+        start = end - buffer.data() + 1;
+        if (!line.empty() && !callback(line)) return false;
+      }
+      if (remaining == 0 && start < len) {
+        auto line = strip_line(buffer.substr(start, len - start));
+        if (!line.empty() && !callback(line)) return false;
+        start = len;
+      }
+      if (start == 0 && len == buffer.size()) {
+        ESP_LOGE("HTTPServer", "line too long.");
+        return false;
+      }
+      memmove(buffer.data(), buffer.data() + start, len - start);
+      len -= start;
+    }
+    return true;
+  }
+
+
+  esp_err_t HTTPServer::put_file(httpd_req_t * req) {
+    auto path = get_path(req, FilesPrefix);
+    if (!is_safe_path(path))
+      return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "invalid path");
+    // arguments are those of AT+PUTBIN, and options go through the same parser
+    auto command = path + "," + std::to_string(req->content_len);
+    if (auto offset = get_query_value(req, "offset"); !offset.empty())
+      command += ",@" + offset;
+    if (auto window_bits = get_query_value(req, "z"); !window_bits.empty())
+      command += ",z" + window_bits;
+    serial::PutBinParserStub stub(this->partition);
+    serial::ReplyBuffer reply;
+    if (path.empty() || !run_stub(stub, command, reply))
+      return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "cannot open file");
+    // body goes to parser stub as frame payloads, in chunks of buffer size
+    std::string chunk;
+    chunk.reserve(CONFIG_HTTP_SERVER_BUF_SIZE);
+    size_t remaining = req->content_len;
+    while (remaining > 0) {
+      chunk.resize(std::min<size_t>(remaining, CONFIG_HTTP_SERVER_BUF_SIZE));
+      auto n = httpd_req_recv(req, chunk.data(), chunk.size());
+      if (n == HTTPD_SOCK_ERR_TIMEOUT) continue;
+      if (n <= 0) {
+        stub.abort();
+        return ESP_FAIL;
+      }
+      chunk.resize(n);
+      remaining -= n;
+      if (!run_stub(stub, chunk, reply)) {
+        stub.abort();
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "cannot write file");
+      }
+    }
+    // empty payload ends transfer
+    if (!run_stub(stub, "", reply))
+      return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "incomplete file");
+    notify_change(this->db, stub);
+    return httpd_resp_sendstr(req, "OK");
+  }
+
+
+  esp_err_t HTTPServer::get_file(httpd_req_t * req) {
+    auto path = get_path(req, FilesPrefix);
+    if (!is_safe_path(path))
+      return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "invalid path");
+    serial::GetBinParserStub stub(this->partition);
+    serial::ReplyBuffer reply;
+    if (path.empty() || !run_stub(stub, path, reply))
+      return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "file not found");
+    httpd_resp_set_type(req, "application/octet-stream");
+    // parser stub replies with frames of requested size; body is made of their payloads
+    auto block_size = std::to_string(framing::MaxPayload);
+    for (;;) {
+      if (!run_stub(stub, block_size, reply)) {
+        // headers are gone already; dropping connection tells client that body is incomplete
+        stub.abort();
+        return ESP_FAIL;
+      }
+      auto & frame = reply.str();
+      auto payload_size = frame.size() - framing::HeaderSize - framing::CrcSize;
+      if (payload_size == 0) break;
+      if (httpd_resp_send_chunk(req, frame.data() + framing::HeaderSize, payload_size) != ESP_OK) {
+        stub.abort();
+        return ESP_FAIL;
+      }
+    }
+    run_stub(stub, "0", reply); // this closes file
+    return httpd_resp_send_chunk(req, nullptr, 0);
+  }
+
+
+  esp_err_t HTTPServer::list_dir(httpd_req_t * req) {
+    auto path = get_path(req, DirPrefix);
+    if (!is_safe_path(path))
+      return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "invalid path");
+    serial::ListDirParserStub stub(this->partition);
+    serial::ReplyBuffer reply;
+    if (!run_stub(stub, path + "," + std::to_string(ListPageSize), reply))
+      return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "directory not found");
+    httpd_resp_set_type(req, "text/plain");
+    // pages read FILES=remaining/type,size,mtime,name/...; each entry becomes a line
+    for (;;) {
+      auto page = strip_line(reply.str());
+      auto eq = page.find('=');
+      auto first = page.find('/');
+      auto remaining = page.substr(eq + 1, first - eq - 1);
+      std::string lines;
+      for (auto p = first; p != std::string::npos; ) {
+        auto next = page.find('/', p + 1);
+        lines += page.substr(p + 1, next == std::string::npos ? std::string::npos : next - p - 1) + "\n";
+        p = next;
+      }
+      if (!lines.empty() && httpd_resp_send_chunk(req, lines.data(), lines.size()) != ESP_OK) {
+        stub.abort();
+        return ESP_FAIL;
+      }
+      if (remaining.empty() || !is_numeric(remaining) || stoi(remaining) == 0) break;
+      run_stub(stub, "", reply);
+    }
+    return httpd_resp_send_chunk(req, nullptr, 0);
+  }
+
+
+  esp_err_t HTTPServer::set_config(httpd_req_t * req) {
+    serial::SetConfigBatchParserStub stub(this->nvs);
+    serial::ReplyBuffer reply;
+    run_stub(stub, "BEGIN", reply);
+    size_t line_count = 0;
+    // a line without separator would be taken as a batch command
+    bool success = this->read_lines(req, [&stub, &reply, &line_count](const std::string & line) {
+      line_count++;
+      return line.find(',') != std::string::npos && run_stub(stub, line, reply);
+    });
+    if (!success) {
+      stub.abort(); // nothing gets written
+      auto reason = "invalid key at line " + std::to_string(line_count);
+      return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, reason.c_str());
+    }
+    if (!run_stub(stub, "COMMIT", reply))
+      return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "cannot write keys");
+    notify_change(this->db, stub);
+    return httpd_resp_sendstr(req, "OK");
+  }
+
+
+  esp_err_t HTTPServer::get_config(httpd_req_t * req) {
+    serial::GetConfigParserStub stub(this->nvs);
+    serial::ReplyBuffer value;
+    std::string reply;
+    // replies read VALUE=type,value; request line is put in front
+    bool success = this->read_lines(req, [&stub, &value, &reply](const std::string & line) {
+      if (!run_stub(stub, line, value)) return false;
+      reply += line + "," + strip_line(value.str().substr(value.str().find('=') + 1)) + "\n";
+      return true;
+    });
+    if (!success)
+      return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "invalid key");
+    httpd_resp_set_type(req, "text/plain");
+    return httpd_resp_send(req, reply.data(), reply.size());
+  }
+
+}
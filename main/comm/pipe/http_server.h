@@ -0,0 +1,158 @@
+/** \file http_server.h
+ *  \brief Header file for HTTP file and configuration server.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#pragma once
+#include "sdkconfig.h"
+
+#include "esp_http_server.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "storage/partition.h"
+#include "storage/nvs.h"
+#include "comm/data_broker.h"
+#include <memory>
+#include <string>
+#include <functional>
+
+namespace eobsws::comm::pipe {
+
+  /** \class HTTPServer
+   *  \brief Serves files and configuration keys over WiFi, for bulk uploads faster than
+   *  the serial link allows. Requests are carried out by the serial parser stubs, each
+   *  request with its own stub instances; bodies are streamed through them chunk by chunk.
+   *  Endpoints:
+   *    - PUT /files/path[?offset=n&z=bits]: write request body to file;
+   *    - GET /files/path: read file;
+   *    - GET /dir/path: list directory, one "type,size,mtime,name" line per entry;
+   *    - POST /config: set "ns,key,type,value" lines, committed together;
+   *    - POST /config/get: get "ns,key" lines, replied as "ns,key,type,value" lines.
+   *  Every request must carry an "Authorization: Bearer token" header.
+   *  Unlike pipes, server replies to requests itself: data broker only receives notifications
+   *  of changed files and keys.
+   */
+  class HTTPServer {
+  private:
+    /** \property std::shared_ptr<storage::Partition> partition
+     *  \brief Flash storage partition holding files.
+     */
+    std::shared_ptr<storage::Partition> partition;
+
+    /** \property std::shared_ptr<storage::NVStorage> nvs
+     *  \brief Non-volatile storage holding configuration keys.
+     */
+    std::shared_ptr<storage::NVStorage> nvs;
+
+    /** \property std::shared_ptr<DataBroker> db
+     *  \brief Data broker receiving configuration change notifications.
+     */
+    std::shared_ptr<DataBroker> db;
+
+    /** \property std::string token
+     *  \brief Token expected in Authorization header.
+     */
+    std::string token;
+
+    /** \property httpd_handle_t server
+     *  \brief Server handle; nullptr until server is started.
+     */
+    httpd_handle_t server = nullptr;
+
+    /** \property esp_event_handler_instance_t ip_handler
+     *  \brief Handler for IP events, starting server.
+     */
+    esp_event_handler_instance_t ip_handler = nullptr;
+
+    /** \fn void start()
+     *  \brief Start server and register endpoints, if not running yet.
+     */
+    void start();
+
+    /** \fn bool authorize(httpd_req_t * req) const
+     *  \brief Check request token.
+     *  \param req: request.
+     *  \returns true if request carries expected token, false otherwise.
+     */
+    bool authorize(httpd_req_t * req) const;
+
+    /** \fn bool read_lines(httpd_req_t * req, const std::function<bool(const std::string &)> & callback)
+     *  \brief Stream request body line by line; empty lines are skipped.
+     *  \param req: request.
+     *  \param callback: function called for each line; returns false to stop.
+     *  \returns true if whole body was read and accepted, false otherwise.
+     */
+    bool read_lines(httpd_req_t * req, const std::function<bool(const std::string &)> & callback);
+
+    /** \fn template<esp_err_t (HTTPServer::*handler)(httpd_req_t*)> static esp_err_t call_handler(httpd_req_t * req)
+     *  \brief Check request token and forward request to server instance.
+     *  \param req: request; user context holds server instance.
+     *  \returns ESP_OK if reply could be sent, an error code otherwise.
+     */
+    template<esp_err_t (HTTPServer::*handler)(httpd_req_t*)>
+    static esp_err_t call_handler(httpd_req_t * req);
+
+    /** \fn esp_err_t put_file(httpd_req_t * req)
+     *  \brief Write request body to file, as with AT+PUTBIN.
+     *  \param req: request.
+     *  \returns ESP_OK if reply could be sent, an error code otherwise.
+     */
+    esp_err_t put_file(httpd_req_t * req);
+
+    /** \fn esp_err_t get_file(httpd_req_t * req)
+     *  \brief Send file content, as with AT+GETBIN.
+     *  \param req: request.
+     *  \returns ESP_OK if reply could be sent, an error code otherwise.
+     */
+    esp_err_t get_file(httpd_req_t * req);
+
+    /** \fn esp_err_t list_dir(httpd_req_t * req)
+     *  \brief Send directory content, as with AT+LISTDIR.
+     *  \param req: request.
+     *  \returns ESP_OK if reply could be sent, an error code otherwise.
+     */
+    esp_err_t list_dir(httpd_req_t * req);
+
+    /** \fn esp_err_t set_config(httpd_req_t * req)
+     *  \brief Set configuration keys listed in request body, as with AT+SETCONFBATCH.
+     *  \param req: request.
+     *  \returns ESP_OK if reply could be sent, an error code otherwise.
+     */
+    esp_err_t set_config(httpd_req_t * req);
+
+    /** \fn esp_err_t get_config(httpd_req_t * req)
+     *  \brief Send configuration keys listed in request body, as with AT+GETCONF.
+     *  \param req: request.
+     *  \returns ESP_OK if reply could be sent, an error code otherwise.
+     */
+    esp_err_t get_config(httpd_req_t * req);
+
+  public:
+    /** \fn HTTPServer(std::shared_ptr<storage::Partition> partition,
+     *                 std::shared_ptr<storage::NVStorage> nvs,
+     *                 std::shared_ptr<DataBroker> db,
+     *                 const std::string & token)
+     *  \brief Constructor.
+     *  \param partition: pointer to flash storage partition holding files.
+     *  \param nvs: pointer to a non-volatile storage accessor.
+     *  \param db: pointer to data broker receiving configuration change notifications.
+     *  \param token: token expected in Authorization header.
+     */
+    HTTPServer(std::shared_ptr<storage::Partition> partition,
+               std::shared_ptr<storage::NVStorage> nvs,
+               std::shared_ptr<DataBroker> db,
+               const std::string & token);
+
+    /** \fn ~HTTPServer()
+     *  \brief Destructor.
+     */
+    ~HTTPServer();
+
+    /** \fn void enable()
+     *  \brief Start server as soon as WiFi station gets an IP address.
+     */
+    void enable();
+  };
+
+}
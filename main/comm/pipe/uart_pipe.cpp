@@ -7,6 +7,8 @@
 #include "uart_pipe.h"
 #include "esp_log.h"
 #include <string.h>
+#include <algorithm>
+#include <charconv>
 
 namespace eobsws::comm::pipe {
 
@@ -15,6 +17,34 @@ namespace eobsws::comm::pipe {
     */
   static const char SerialTermination = '\r';
 
+  /** \var static const char TunnelPrefix[]
+    *  \brief Prefix of lines carrying obs-websocket messages.
+    */
+  static const char TunnelPrefix[] = "+OBS:";
+
+  /** \var static const int MinBaudRate
+    *  \brief Lowest baud rate accepted from host.
+    */
+  static const int MinBaudRate = 9600;
+
+  /** \var static const int MaxBaudRate
+    *  \brief Highest baud rate accepted from host (ESP32 UART limit).
+    */
+  static const int MaxBaudRate = 5000000;
+
+  /** \var static const size_t MaxRxBufferSize
+    *  \brief Size up to which receive buffer grows: two command lines and a window of
+    *  binary frames. A longer line is dropped, so that a noisy line or a host that never
+    *  sends a terminator can't take all memory.
+    */
+  static const size_t MaxRxBufferSize = 2*CONFIG_UART_BUF_SIZE
+    + (CONFIG_UART_MAX_WINDOW+1)*(framing::MaxPayload + framing::HeaderSize + framing::CrcSize);
+
+  /** \var static const char OverflowReply[]
+    *  \brief Reply sent when a line is dropped because it doesn't fit in receive buffer.
+    */
+  static const char OverflowReply[] = "ERROR\r";
+
   UARTPipe::UARTPipe(
     std::shared_ptr<DataBroker> db,
     uart_port_t uart_port /* = UART_NUM_0 */,
@@ -44,14 +74,25 @@ namespace eobsws::comm::pipe {
     uart_intr_config(uart_port, &intr_conf);*/
 
     this->port = uart_port;
+    this->baud_rate = baud_rate;
+    this->rx_buffer.resize(2*CONFIG_UART_BUF_SIZE);
+    this->rx_message.reserve(framing::BlockCommand.size() + framing::MaxPayload);
+    this->previous_baud_rate = baud_rate;
 
     // setup UART driver
     ESP_LOGI("UARTPipe", "installing driver.");
-    uart_driver_install(uart_port, 2*CONFIG_UART_BUF_SIZE, 2*CONFIG_UART_BUF_SIZE, 20, &(this->queue), 0);
+    // receive buffer must hold a full window of binary frames while a block is being written to flash
+    const int rx_buf_size = std::max(2*CONFIG_UART_BUF_SIZE,
+      (CONFIG_UART_MAX_WINDOW+1)*static_cast<int>(framing::MaxPayload + framing::HeaderSize + framing::CrcSize));
+    uart_driver_install(uart_port, rx_buf_size, 2*CONFIG_UART_BUF_SIZE, 20, &(this->queue), 0);
     uart_param_config(uart_port, &uart_config);
     uart_set_pin(uart_port, tx_io_num, rx_io_num, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
     ESP_LOGI("UARTPipe", "setting up event queue.");
     uart_pattern_queue_reset(uart_port, 20); // reset queue with 20 positions
+    // outbound queue must hold at least a full binary frame
+    const int tx_ring_size = std::max(CONFIG_UART_TX_BUF_SIZE,
+      2*static_cast<int>(framing::MaxPayload + framing::HeaderSize + framing::CrcSize));
+    this->tx_ring = xRingbufferCreate(tx_ring_size, RINGBUF_TYPE_BYTEBUF);
     
     // set event loop
     this->loop_running = true;
@@ -61,6 +102,11 @@ namespace eobsws::comm::pipe {
     };
     // Stack size for event task has to be adapted to what is run by the task
     xTaskCreate(fevent, "uart_event_task", CONFIG_UART_EVENT_STACK_SIZE, static_cast<void*>(this), 10,  nullptr);
+    auto ftx = [](void* arg) {
+      auto obj = reinterpret_cast<UARTPipe*>(arg);
+      obj->tx_task();
+    };
+    xTaskCreate(ftx, "uart_tx_task", 2048, static_cast<void*>(this), 10, nullptr);
     
     this->in_message_type = MessageType::OutboundWired;
     this->out_message_type = MessageType::InboundWired;
@@ -75,42 +121,300 @@ namespace eobsws::comm::pipe {
 
 
   int UARTPipe::write_bytes(const std::string & bytes) {
-    return uart_write_bytes(this->port, bytes.c_str(), bytes.length());
+    if (bytes.empty()) return 0;
+    std::lock_guard<std::mutex> lock(this->tx_mtx);
+    auto max_size = xRingbufferGetMaxItemSize(this->tx_ring);
+    this->tx_queued += bytes.size();
+    if (bytes.size() <= max_size) {
+      // publisher isn't held up by a slow or stalled link: it gets a failure instead
+      if (xRingbufferSend(this->tx_ring, bytes.data(), bytes.size(), 0) != pdTRUE) {
+        this->tx_queued -= bytes.size();
+        ESP_LOGE("UARTPipe", "transmit queue is full; %d bytes dropped.", bytes.size());
+        return -1;
+      }
+      return bytes.size();
+    }
+    // too large to ever fit: goes in pieces, as room is made; wait is bounded, so that
+    // a stalled link doesn't hold other publishers forever behind lock
+    const TickType_t timeout = CONFIG_UART_BINARY_TIMEOUT / portTICK_RATE_MS;
+    for (size_t pos = 0; pos < bytes.size(); pos += max_size) {
+      auto len = std::min(max_size, bytes.size() - pos);
+      if (xRingbufferSend(this->tx_ring, bytes.data() + pos, len, timeout) != pdTRUE) {
+        this->tx_queued -= bytes.size() - pos;
+        ESP_LOGE("UARTPipe", "transmit queue stayed full; %d of %d bytes dropped.", bytes.size() - pos, bytes.size());
+        return -1;
+      }
+    }
+    return bytes.size();
+  }
+
+
+  int UARTPipe::write_bytes(std::string_view bytes, TickType_t timeout) {
+    if (bytes.empty()) return 0;
+    if (bytes.size() > xRingbufferGetMaxItemSize(this->tx_ring)) return -1;
+    auto deadline = xTaskGetTickCount() + timeout;
+    while (true) {
+      {
+        // lock is only held while queuing, so that other publishers aren't held up while this one waits
+        std::lock_guard<std::mutex> lock(this->tx_mtx);
+        this->tx_queued += bytes.size();
+        if (xRingbufferSend(this->tx_ring, bytes.data(), bytes.size(), 0) == pdTRUE)
+          return bytes.size();
+        this->tx_queued -= bytes.size();
+      }
+      if (static_cast<int32_t>(deadline - xTaskGetTickCount()) <= 0) break;
+      vTaskDelay(1);
+    }
+    ESP_LOGE("UARTPipe", "transmit queue stayed full; %d bytes dropped.", bytes.size());
+    return -1;
+  }
+
+
+  void UARTPipe::tx_task() {
+    ESP_LOGI("UARTPipe", "created transmit task.");
+    while (this->loop_running) {
+      size_t len = 0;
+      // byte ring returns everything queued (up to its wrap point), so small replies are coalesced
+      auto data = xRingbufferReceiveUpTo(this->tx_ring, &len, 100 / portTICK_RATE_MS, SIZE_MAX);
+      if (data == nullptr) continue;
+      uart_write_bytes(this->port, data, len);
+      vRingbufferReturnItem(this->tx_ring, data);
+      this->tx_queued -= len;
+    }
+    vTaskDelete(nullptr);
+  }
+
+
+  bool UARTPipe::wait_tx_done(TickType_t timeout) {
+    auto deadline = xTaskGetTickCount() + timeout;
+    while (this->tx_queued > 0) {
+      if (static_cast<int32_t>(deadline - xTaskGetTickCount()) <= 0) return false;
+      vTaskDelay(1);
+    }
+    // driver signals when last byte left shift register
+    auto left = static_cast<int32_t>(deadline - xTaskGetTickCount());
+    return uart_wait_tx_done(this->port, left > 0 ? left : 0) == ESP_OK;
+  }
+
+
+  void UARTPipe::set_tunnel_targets(uint8_t targets) {
+    this->tunnel_targets = targets;
+    this->in_message_type = MessageType::OutboundWired;
+    if (targets != 0)
+      this->in_message_type = MessageType::OutboundWired | MessageType::OutboundWireless | target_mask(targets);
+  }
+
+
+  void UARTPipe::set_flow_control_pins(int rts_io_num, int cts_io_num) {
+    if (rts_io_num < 0 || cts_io_num < 0) return;
+    uart_set_pin(this->port, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, rts_io_num, cts_io_num);
+    this->flow_control_wired = true;
+  }
+
+
+  bool UARTPipe::request_baud_rate(int baud_rate, bool flow_control) {
+    if (baud_rate < MinBaudRate || baud_rate > MaxBaudRate) return false;
+    if (flow_control && !this->flow_control_wired) return false;
+    this->requested_baud_rate = baud_rate;
+    this->requested_flow_control = flow_control;
+    return true;
+  }
+
+
+  void UARTPipe::switch_baud_rate() {
+    if (this->requested_baud_rate == 0) return;
+    ESP_LOGI("UARTPipe", "switching to %d baud.", this->requested_baud_rate);
+    if (!this->baud_rate_probing) {
+      this->previous_baud_rate = this->baud_rate;
+      this->previous_flow_control = this->flow_control;
+    }
+    this->apply_baud_rate(this->requested_baud_rate, this->requested_flow_control);
+    this->requested_baud_rate = 0;
+    this->baud_rate_probing = true;
+    this->probe_deadline = xTaskGetTickCount() + CONFIG_UART_BAUD_TIMEOUT / portTICK_RATE_MS;
+  }
+
+
+  bool UARTPipe::confirm_baud_rate() {
+    if (!this->baud_rate_probing) return false;
+    ESP_LOGI("UARTPipe", "baud rate %d confirmed.", this->baud_rate);
+    this->baud_rate_probing = false;
+    return true;
+  }
+
+
+  void UARTPipe::apply_baud_rate(int baud_rate, bool flow_control) {
+    // reply must leave at the rate host expects
+    this->wait_tx_done(CONFIG_UART_BAUD_TIMEOUT / portTICK_RATE_MS);
+    uart_set_baudrate(this->port, baud_rate);
+    // RTS is asserted when RX FIFO holds more than 100 bytes (FIFO is 128 bytes deep)
+    uart_set_hw_flow_ctrl(this->port, flow_control ? UART_HW_FLOWCTRL_CTS_RTS : UART_HW_FLOWCTRL_DISABLE, 100);
+    // anything received during switch is garbage
+    uart_flush_input(this->port);
+    this->clear_receiver();
+    this->baud_rate = baud_rate;
+    this->flow_control = flow_control;
+  }
+
+
+  void UARTPipe::clear_receiver() {
+    this->rx_len = 0;
+    this->rx_scanned = 0;
+    this->rx_dropping = false;
+    this->decoder.reset();
+  }
+
+
+  void UARTPipe::process_line(std::string_view line) {
+    // published string is the only copy of received bytes
+    if (this->tunnel_targets == 0 || line.compare(0, sizeof(TunnelPrefix)-1, TunnelPrefix) != 0) {
+      this->rx_message.assign(line);
+      this->db->publish(this->out_message_type, this->rx_message);
+      return;
+    }
+    // tunnel frame: +OBS:n,message
+    auto comma = line.find(',', sizeof(TunnelPrefix)-1);
+    if (comma == std::string_view::npos) return;
+    // index must be a plain number taking all room up to comma
+    int target = -1;
+    auto res = std::from_chars(line.data() + sizeof(TunnelPrefix) - 1, line.data() + comma, target);
+    if (res.ec != std::errc() || res.ptr != line.data() + comma) {
+      ESP_LOGI("UARTPipe", "dropping frame with malformed connection index.");
+      return;
+    }
+    if (target < 0 || target >= MaxTargets || !(this->tunnel_targets & (1 << target))) {
+      ESP_LOGI("UARTPipe", "dropping frame for connection %d, which isn't tunneled.", target);
+      return;
+    }
+    this->rx_message.assign(line.substr(comma+1));
+    this->db->publish(MessageType::InboundWireless | target_tag(target), this->rx_message);
+  }
+
+
+  void UARTPipe::process_buffer() {
+    auto data = this->rx_buffer.data();
+    size_t pos = 0;
+    while (pos < this->rx_len) {
+      if (this->binary_mode) {
+        auto status = framing::FrameStatus::Incomplete;
+        pos += this->decoder.feed(data + pos, this->rx_len - pos, status);
+        if (status == framing::FrameStatus::Corrupted) {
+          ESP_LOGI("UARTPipe", "received corrupted frame.");
+          this->write_bytes(framing::CrcErrorReply);
+        } else if (status == framing::FrameStatus::Complete) {
+          auto payload = this->decoder.get_payload();
+          // empty frame ends binary transfer
+          if (payload.empty())
+            this->binary_mode = false;
+          this->rx_message.assign(framing::BlockCommand).append(payload);
+          this->db->publish(this->out_message_type, this->rx_message);
+        }
+        continue;
+      }
+      // a read may contain several lines (e.g. tunnel frames sent back to back);
+      // bytes searched during previous reads aren't searched again
+      auto from = std::max(pos, this->rx_scanned);
+      auto end = static_cast<const char*>(memchr(data + from, SerialTermination, this->rx_len - from));
+      if (this->rx_dropping) {
+        // rest of an overlong line: it goes up to next terminator
+        pos = end == nullptr ? this->rx_len : end - data + 1;
+        this->rx_dropping = end == nullptr;
+        continue;
+      }
+      if (end == nullptr) {
+        this->rx_scanned = this->rx_len;
+        break;
+      }
+      auto line_start = pos;
+      pos = end - data + 1;
+      // processing line may switch to binary mode
+      this->process_line(std::string_view(data + line_start, end - data - line_start));
+      if (this->rx_len == 0) return; // reply switched baud rate, which flushed input
+    }
+    // incomplete line moves to buffer start
+    if (pos > 0) {
+      memmove(data, data + pos, this->rx_len - pos);
+      this->rx_len -= pos;
+      this->rx_scanned = std::max(this->rx_scanned, pos) - pos;
+    }
+  }
+
+
+  void UARTPipe::receive() {
+    size_t available = 0;
+    uart_get_buffered_data_len(this->port, &available);
+    while (available > 0) {
+      // a line longer than buffer makes it grow; otherwise buffer is never cleared nor reallocated
+      if (this->rx_len == this->rx_buffer.size()) {
+        if (this->rx_buffer.size() >= MaxRxBufferSize) {
+          ESP_LOGE("UARTPipe", "line longer than %d bytes dropped.", this->rx_len);
+          this->rx_len = 0;
+          this->rx_scanned = 0;
+          this->rx_dropping = true;
+          this->write_bytes(OverflowReply);
+        } else {
+          this->rx_buffer.resize(std::min(2*this->rx_buffer.size(), MaxRxBufferSize));
+        }
+      }
+      auto len = std::min(available, this->rx_buffer.size() - this->rx_len);
+      // bytes are already there, so read doesn't wait
+      auto n = uart_read_bytes(this->port, this->rx_buffer.data() + this->rx_len, len, 0);
+      if (n <= 0) break;
+      available -= n;
+      this->rx_len += n;
+      this->process_buffer();
+    }
   }
 
 
   bool UARTPipe::publish_callback(MessageType t, const std::string & data) {
-    if ((t & this->in_message_type) == MessageType::NoOutlet) {
+    if (!accepts(this->in_message_type, t)) {
       ESP_LOGI("UARTPipe", "message of type %d rejected. Expected %d", static_cast<int>(t), static_cast<int>(this->in_message_type));
       return false;
     }
     ESP_LOGI("UARTPipe", "processing message of type %d", static_cast<int>(t));
-    return this->write_bytes(data) == data.size();
+    auto tt = static_cast<uint16_t>(t);
+    if (!(tt & static_cast<uint16_t>(MessageType::OutboundWireless))) {
+      // host sends frames only after receiving this reply
+      if (data.compare(0, framing::BinaryModeReply.size(), framing::BinaryModeReply) == 0) {
+        this->decoder.reset();
+        this->binary_mode = true;
+      }
+      return this->write_bytes(data) == data.size();
+    }
+    // obs-websocket message: one frame per tunneled connection it is addressed to;
+    // untagged messages go to all of them
+    uint8_t targets = this->tunnel_targets;
+    if (tt & static_cast<uint16_t>(MessageType::TargetAny))
+      targets &= tt >> 8;
+    bool success = targets != 0;
+    for (uint8_t n=0; n<MaxTargets; n++) {
+      if (!(targets & (1 << n))) continue;
+      std::string frame = TunnelPrefix + std::to_string(n) + "," + data + SerialTermination;
+      success &= this->write_bytes(frame) == frame.size();
+    }
+    return success;
   }
 
   void UARTPipe::event_task() {
     ESP_LOGI("UARTPipe", "created event task.");
     uart_event_t event;
-    std::string data;
-    char buf[CONFIG_UART_BUF_SIZE];
-    // UART event task accumulates characters until the SerialTermination character was found
+    // UART event task accumulates characters until the SerialTermination character was found,
+    // or decodes binary frames in binary mode
     while (this->loop_running) {
-      bzero(buf, CONFIG_UART_BUF_SIZE);
-      if(xQueueReceive(this->queue, static_cast<void*>(&event), (portTickType)portMAX_DELAY)) {
+      TickType_t timeout = portMAX_DELAY;
+      if (this->baud_rate_probing) {
+        auto left = static_cast<int32_t>(this->probe_deadline - xTaskGetTickCount());
+        timeout = left > 0 ? left : 0;
+      } else if (this->binary_mode) {
+        timeout = CONFIG_UART_BINARY_TIMEOUT / portTICK_RATE_MS;
+      }
+      if(xQueueReceive(this->queue, static_cast<void*>(&event), (portTickType)timeout)) {
         ESP_LOGI("UARTPipe", "received UART event; processing...");
         switch(event.type) {
           case UART_DATA: {
             ESP_LOGI("UARTPipe", "received UART event of type UART_DATA.");
-            auto len = uart_read_bytes(this->port, buf, CONFIG_UART_BUF_SIZE, 20 / portTICK_RATE_MS);
-            if (len>0) {
-              data.append(buf, len);
-              const char & last = data.back();
-              if (last == SerialTermination) {
-                data.erase(data.end()-1);
-                this->db->publish(this->out_message_type, data);
-                data.clear();
-              }
-            }
+            this->receive();
           }
           break;
           case UART_FIFO_OVF:
@@ -118,12 +422,24 @@ namespace eobsws::comm::pipe {
             ESP_LOGI("UARTPipe", "received UART event of type UART_%s.", event.type==UART_FIFO_OVF ? "_FIFO_OVF" : "_BUFFER_FULL");
             uart_flush_input(this->port);
             xQueueReset(this->queue);
+            this->clear_receiver();
           }
           break;
           
           default:
           break;
         }
+      } else if (this->baud_rate_probing) {
+        // host didn't confirm new baud rate: it may not have been able to switch
+        ESP_LOGI("UARTPipe", "baud rate not confirmed; reverting to %d.", this->previous_baud_rate);
+        this->baud_rate_probing = false;
+        this->apply_baud_rate(this->previous_baud_rate, this->previous_flow_control);
+      } else if (this->binary_mode) {
+        // host went silent during binary transfer: end it as if empty frame was received
+        ESP_LOGI("UARTPipe", "binary transfer timed out.");
+        this->decoder.reset();
+        this->binary_mode = false;
+        this->db->publish(this->out_message_type, framing::BlockCommand);
       }
     }
     vTaskDelete(nullptr); // delete task from RTOS task list
@@ -10,8 +10,15 @@
 
 #include "driver/uart.h"
 #include "freertos/queue.h"
+#include "freertos/ringbuf.h"
 
 #include "../data_node.h"
+#include "framing.h"
+
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <vector>
 
 /** \namespace eobsws::comm::pipe
  *  \brief Data pipes.
@@ -38,6 +45,146 @@ namespace eobsws::comm::pipe {
       *  \brief Handle of event queue.
       */
     QueueHandle_t queue;
+
+    /** \property RingbufHandle_t tx_ring
+      *  \brief Byte ring holding outbound data, drained by tx_task.
+      */
+    RingbufHandle_t tx_ring = nullptr;
+
+    /** \property std::mutex tx_mtx
+      *  \brief Mutex keeping pieces of a message larger than tx_ring together.
+      */
+    std::mutex tx_mtx;
+
+    /** \property std::atomic<size_t> tx_queued
+      *  \brief Number of bytes queued in tx_ring and not yet handed to UART driver.
+      */
+    std::atomic<size_t> tx_queued = 0;
+
+    /** \property uint8_t tunnel_targets
+      *  \brief OBS connections carried over UART link (bit n = connection n).
+      */
+    uint8_t tunnel_targets = 0;
+
+    /** \property std::vector<char> rx_buffer
+      *  \brief Linear receive buffer; it holds received bytes not dispatched yet,
+      *  i.e. the start of a line whose terminator didn't come yet. It grows for long
+      *  lines, up to MaxRxBufferSize.
+      */
+    std::vector<char> rx_buffer;
+
+    /** \property size_t rx_len
+      *  \brief Number of bytes held in receive buffer.
+      */
+    size_t rx_len = 0;
+
+    /** \property size_t rx_scanned
+      *  \brief Number of bytes of receive buffer already searched for a terminator.
+      */
+    size_t rx_scanned = 0;
+
+    /** \property bool rx_dropping
+      *  \brief If true, received bytes are dropped up to next terminator, because
+      *  line they belong to didn't fit in receive buffer.
+      */
+    bool rx_dropping = false;
+
+    /** \property std::string rx_message
+      *  \brief Message published for a received line or frame. It is reused, so that
+      *  publishing doesn't allocate memory once it has grown to the largest message.
+      */
+    std::string rx_message;
+
+    /** \property bool binary_mode
+      *  \brief Tell if received data is made of binary frames rather than lines.
+      */
+    bool binary_mode = false;
+
+    /** \property framing::FrameDecoder decoder
+      *  \brief Decoder for binary frames.
+      */
+    framing::FrameDecoder decoder;
+
+    /** \property int baud_rate
+      *  \brief Current baud rate.
+      */
+    int baud_rate;
+
+    /** \property bool flow_control
+      *  \brief Tell if RTS/CTS flow control is enabled.
+      */
+    bool flow_control = false;
+
+    /** \property bool flow_control_wired
+      *  \brief Tell if RTS/CTS pins are connected.
+      */
+    bool flow_control_wired = false;
+
+    /** \property int requested_baud_rate
+      *  \brief Baud rate to switch to with switch_baud_rate (0 = none).
+      */
+    int requested_baud_rate = 0;
+
+    /** \property bool requested_flow_control
+      *  \brief Flow control setting to switch to along with requested_baud_rate.
+      */
+    bool requested_flow_control = false;
+
+    /** \property int previous_baud_rate
+      *  \brief Baud rate to revert to if host doesn't confirm switch.
+      */
+    int previous_baud_rate;
+
+    /** \property bool previous_flow_control
+      *  \brief Flow control setting to revert to if host doesn't confirm switch.
+      */
+    bool previous_flow_control = false;
+
+    /** \property bool baud_rate_probing
+      *  \brief Tell if a baud rate switch awaits confirmation from host.
+      */
+    bool baud_rate_probing = false;
+
+    /** \property TickType_t probe_deadline
+      *  \brief Time at which an unconfirmed baud rate switch is reverted.
+      */
+    TickType_t probe_deadline = 0;
+
+    /** \fn bool wait_tx_done(TickType_t timeout)
+      *  \brief Wait until all queued data has left UART.
+      *  \param timeout: maximum waiting time, in ticks.
+      *  \returns true if all data was sent, false if timeout was reached.
+      */
+    bool wait_tx_done(TickType_t timeout);
+
+    /** \fn void apply_baud_rate(int baud_rate, bool flow_control)
+      *  \brief Set UART baud rate and flow control, once pending data is sent.
+      *  \param baud_rate: baud rate.
+      *  \param flow_control: true to enable RTS/CTS flow control.
+      */
+    void apply_baud_rate(int baud_rate, bool flow_control);
+
+    /** \fn void clear_receiver()
+      *  \brief Drop received bytes not dispatched yet, including a partial line or frame.
+      */
+    void clear_receiver();
+
+    /** \fn void receive()
+      *  \brief Read all bytes waiting in UART driver into receive buffer, and dispatch them.
+      */
+    void receive();
+
+    /** \fn void process_buffer()
+      *  \brief Split receive buffer into lines or binary frames, and dispatch them.
+      *  Bytes of an incomplete line are kept at the start of the buffer.
+      */
+    void process_buffer();
+
+    /** \fn void process_line(std::string_view line)
+      *  \brief Dispatch a received line, either as AT command or as tunnel frame.
+      *  \param line: received line, without termination character.
+      */
+    void process_line(std::string_view line);
     
     protected:
     /** \fn void event_task()
@@ -45,6 +192,12 @@ namespace eobsws::comm::pipe {
       */
     void event_task();
 
+    /** \fn void tx_task()
+      *  \brief Transmit task. It sends queued data to UART driver; data queued while
+      *  previous transfer was going on goes out as a single transfer.
+      */
+    void tx_task();
+
     /** \fn bool publish_callback(MessageType t, const std::string & data)
      *  \brief Callback to handle data broker messages.
      *  \param t: message type.
@@ -90,12 +243,60 @@ namespace eobsws::comm::pipe {
     ~UARTPipe();
     
     /** \fn int write_bytes(const std::string & bytes)
-      *  \brief Write bytes to transfer buffer.
+      *  \brief Queue bytes for transmission. This doesn't wait for room in queue,
+      *  unless data is larger than the whole queue; it then goes in pieces, each waiting
+      *  at most CONFIG_UART_BINARY_TIMEOUT, and the rest is dropped if a piece can't be queued.
       *  \param bytes : data to be transferred
-      *  \returns Number of bytes written, or -1 if an error occurred.
+      *  \returns Number of bytes queued, or -1 if queue is full or stayed full.
       */
     int write_bytes(const std::string & bytes);
 
+    /** \fn int write_bytes(std::string_view bytes, TickType_t timeout)
+      *  \brief Queue bytes for transmission, waiting for room in queue. Producers that
+      *  can be held up, such as file streaming, are thus paced by the link.
+      *  \param bytes : data to be transferred (at most the size of queue)
+      *  \param timeout : maximum waiting time, in ticks.
+      *  \returns Number of bytes queued, or -1 if no room was made before timeout.
+      */
+    int write_bytes(std::string_view bytes, TickType_t timeout);
+
+    /** \fn void set_tunnel_targets(uint8_t targets)
+      *  \brief Carry obs-websocket messages of given OBS connections over UART link,
+      *  alongside AT commands. Messages are framed as lines "+OBS:n,message", with n
+      *  the connection index; a host bridge relays them to OBS.
+      *  \param targets: OBS connections to carry (bit n = connection n; 0 disables tunnel).
+      */
+    void set_tunnel_targets(uint8_t targets);
+
+    /** \fn void set_flow_control_pins(int rts_io_num, int cts_io_num)
+      *  \brief Connect RTS/CTS pins, so that host may enable hardware flow control.
+      *  \param rts_io_num: GPIO pin for RTS.
+      *  \param cts_io_num: GPIO pin for CTS.
+      */
+    void set_flow_control_pins(int rts_io_num, int cts_io_num);
+
+    /** \fn bool request_baud_rate(int baud_rate, bool flow_control)
+      *  \brief Prepare switch to given baud rate, made by switch_baud_rate once reply
+      *  to host request was queued. Host must then confirm with confirm_baud_rate within
+      *  CONFIG_UART_BAUD_TIMEOUT, otherwise previous setting is restored.
+      *  \param baud_rate: baud rate.
+      *  \param flow_control: true to enable RTS/CTS flow control.
+      *  \returns true if setting is supported, false otherwise.
+      */
+    bool request_baud_rate(int baud_rate, bool flow_control);
+
+    /** \fn void switch_baud_rate()
+      *  \brief Switch to baud rate prepared with request_baud_rate, if any. Queued data
+      *  is sent at current rate first.
+      */
+    void switch_baud_rate();
+
+    /** \fn bool confirm_baud_rate()
+      *  \brief Keep baud rate set with request_baud_rate.
+      *  \returns true if a switch awaited confirmation, false otherwise.
+      */
+    bool confirm_baud_rate();
+
   };
 
 }
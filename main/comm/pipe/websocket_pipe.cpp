@@ -6,11 +6,50 @@
  */
 #include "freertos/FreeRTOS.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/netdb.h"
+#include <cstring>
+#include <algorithm>
 
 #include "websocket_pipe.h"
+#include "hardware/input/input_trace.h"
 
 namespace eobsws::comm::pipe {
 
+  /** \var static const char ProbeIdPrefix[]
+   *  \brief Prefix of request IDs used for round-trip probes.
+   */
+  static const char ProbeIdPrefix[] = "eobsws-probe-";
+
+  /** \struct QueuedMessage
+   *  \brief Item of send queue.
+   */
+  struct QueuedMessage {
+    /** \property std::string * data
+     *  \brief Message content, deleted by send task.
+     */
+    std::string * data;
+
+    /** \property bool traced
+     *  \brief True if message results from traced input event.
+     */
+    bool traced;
+  };
+
+  /** \fn static const char * find_token(const char * data, int len, const char * token)
+   *  \brief Find a token in a non null-terminated buffer.
+   *  \param data: buffer to search in.
+   *  \param len: buffer length.
+   *  \param token: null-terminated token to search for.
+   *  \returns a pointer to the first character following the token, or nullptr if it wasn't found.
+   */
+  static const char * find_token(const char * data, int len, const char * token) {
+      auto end = data + len;
+      auto tlen = strlen(token);
+      auto pos = std::search(data, end, token, token + tlen);
+      return pos == end ? nullptr : pos + tlen;
+  }
+
   WebSocketPipe::WebSocketPipe(
     std::shared_ptr<DataBroker> db,
     const std::string & wifi_ssid,
@@ -20,28 +59,78 @@ namespace eobsws::comm::pipe {
     const std::string & ws_path) : WiFiPipe(db, wifi_ssid, wifi_password),
     ws_host(ws_host), ws_port(ws_port), ws_path(ws_path)
   {
+    this->send_queue = xQueueCreate(CONFIG_WS_SEND_QUEUE_LENGTH, sizeof(QueuedMessage));
+    this->tasks_done = xSemaphoreCreateCounting(2, 0);
     // subscribe callback to data broker
     this->db->subscribe(this->convert_callback<WebSocketPipe>(this));
   }
 
 
   WebSocketPipe::~WebSocketPipe() {
+      // probe and send tasks use client and queue; wait for them to exit first
+      this->loop_running = false;
+      for (; this->tasks_started > 0; this->tasks_started--)
+          xSemaphoreTake(this->tasks_done, portMAX_DELAY);
+      vSemaphoreDelete(this->tasks_done);
       esp_websocket_client_close(this->ws_client, portMAX_DELAY);
       esp_websocket_client_stop(this->ws_client);
       esp_websocket_client_destroy(this->ws_client);
+      QueuedMessage msg;
+      while (xQueueReceive(this->send_queue, &msg, 0) == pdTRUE)
+          delete msg.data;
+      vQueueDelete(this->send_queue);
+  }
+
+
+  void WebSocketPipe::set_target(uint8_t target) {
+      this->target = target % MaxTargets;
+      this->in_message_type = MessageType::OutboundWireless | target_tag(this->target);
+      this->out_message_type = MessageType::InboundWireless | target_tag(this->target);
+  }
+
+
+  bool WebSocketPipe::set_tls(const std::string & cert_pem) {
+      if (cert_pem.find("-----BEGIN CERTIFICATE-----") == std::string::npos) {
+          ESP_LOGE("WebSocketPipe", "no valid certificate for connection %d; TLS disabled.", this->target);
+          this->tls = false;
+          return false;
+      }
+      this->cert_pem = cert_pem;
+      this->tls = true;
+      return true;
+  }
+
+
+  std::string WebSocketPipe::cache_key(const char * name) const {
+      return std::string(name) + "_" + std::to_string(this->target);
   }
 
 
   void WebSocketPipe::connect() {
       if (!this->connected) {
           WiFiPipe::connect();
+          // resolve host name once, so that client doesn't do it on every reconnection
+          // with TLS, client is given host name, so that it can be checked against certificate
+          this->ws_address = this->tls ? this->ws_host : this->resolve_host();
+          this->timing.resolved = esp_timer_get_time();
           // configure WebSocket client
           esp_websocket_client_config_t websocket_cfg = {};
-          websocket_cfg.host = this->ws_host.c_str();
+          websocket_cfg.host = this->ws_address.c_str();
           websocket_cfg.port = this->ws_port;
+          websocket_cfg.path = this->ws_path.c_str();
+          if (this->tls) {
+              // server certificate must chain to trusted certificate and name host
+              websocket_cfg.transport = WEBSOCKET_TRANSPORT_OVER_SSL;
+              websocket_cfg.cert_pem = this->cert_pem.c_str();
+          }
           websocket_cfg.buffer_size = CONFIG_WS_BUFFER_SIZE;
           websocket_cfg.task_stack = 8192;
           websocket_cfg.task_prio = 18;
+          // transport-level pings are kept as a backstop; link health is
+          // measured with application-level probes (see probe_task)
+          websocket_cfg.ping_interval_sec = CONFIG_WS_PING_INTERVAL;
+          websocket_cfg.pingpong_timeout_sec = 2*CONFIG_WS_PING_INTERVAL;
+          websocket_cfg.reconnect_timeout_ms = CONFIG_WS_RECONNECT_DELAY;
           
           ESP_LOGI("WebSocketPipe", "initializing WebSocket client.");
 
@@ -55,9 +144,65 @@ namespace eobsws::comm::pipe {
           esp_websocket_register_events(this->ws_client, WEBSOCKET_EVENT_ANY, fws, static_cast<void *>(this) );
           
           // start WebSocket client
+          this->handshake_start = esp_timer_get_time();
           esp_websocket_client_start(this->ws_client);
           ESP_LOGI("WebSocketPipe", "WebSocket client started.");
+
+          // start link monitoring
+          this->loop_running = true;
+          auto fprobe = [](void* arg) {
+            auto obj = reinterpret_cast<WebSocketPipe*>(arg);
+            obj->probe_task();
+          };
+          if (xTaskCreate(fprobe, "ws_probe_task", 4096, static_cast<void*>(this), 10, nullptr) == pdPASS)
+              this->tasks_started++;
+          // each connection sends from its own task, so that connections don't wait on each other
+          auto fsend = [](void* arg) {
+            auto obj = reinterpret_cast<WebSocketPipe*>(arg);
+            obj->send_task();
+          };
+          if (xTaskCreate(fsend, "ws_send_task", 4096, static_cast<void*>(this), 12, nullptr) == pdPASS)
+              this->tasks_started++;
+      }
+  }
+
+
+  std::string WebSocketPipe::resolve_host() {
+      // nothing to resolve if host is given as an IP address
+      esp_ip4_addr_t addr = {};
+      if (esp_netif_str_to_ip4(this->ws_host.c_str(), &addr) == ESP_OK)
+          return this->ws_host;
+      char buffer[16];
+      #if CONFIG_WIFI_FAST_CONNECT
+      if (this->nvs != nullptr && this->nvs->get_string("wifi_cache", this->cache_key("ws_host")) == this->ws_host) {
+          addr.addr = this->nvs->get_item<uint32_t>("wifi_cache", this->cache_key("ws_addr"), 0);
+          if (addr.addr != 0) {
+              this->ws_address_cached = true;
+              snprintf(buffer, sizeof(buffer), IPSTR, IP2STR(&addr));
+              ESP_LOGI("WebSocketPipe", "using cached address %s for %s.", buffer, this->ws_host.c_str());
+              return std::string(buffer);
+          }
+      }
+      #endif
+      struct addrinfo hints = {};
+      hints.ai_family = AF_INET;
+      hints.ai_socktype = SOCK_STREAM;
+      struct addrinfo * res = nullptr;
+      if (getaddrinfo(this->ws_host.c_str(), nullptr, &hints, &res) != 0 || res == nullptr) {
+          ESP_LOGE("WebSocketPipe", "cannot resolve host %s.", this->ws_host.c_str());
+          return this->ws_host;
+      }
+      addr.addr = reinterpret_cast<struct sockaddr_in *>(res->ai_addr)->sin_addr.s_addr;
+      freeaddrinfo(res);
+      snprintf(buffer, sizeof(buffer), IPSTR, IP2STR(&addr));
+      ESP_LOGI("WebSocketPipe", "resolved %s to %s.", this->ws_host.c_str(), buffer);
+      #if CONFIG_WIFI_FAST_CONNECT
+      if (this->nvs != nullptr) {
+          this->nvs->set_string("wifi_cache", this->cache_key("ws_host"), this->ws_host);
+          this->nvs->set_item<uint32_t>("wifi_cache", this->cache_key("ws_addr"), addr.addr);
       }
+      #endif
+      return std::string(buffer);
   }
 
 
@@ -77,12 +222,138 @@ namespace eobsws::comm::pipe {
   }
 
 
+  LinkStats WebSocketPipe::get_link_stats() const {
+    std::lock_guard<std::mutex> lock(this->stats_mtx);
+    return this->stats;
+  }
+
+
+  bool WebSocketPipe::is_link_up() const {
+    std::lock_guard<std::mutex> lock(this->stats_mtx);
+    return this->connected && this->probes_missed == 0;
+  }
+
+
+  uint32_t WebSocketPipe::probe_timeout() const {
+    // without RTT sample, use maximum value
+    if (this->stats.srtt == 0) return CONFIG_WS_PROBE_TIMEOUT_MAX*1000;
+    return std::clamp<uint32_t>(this->stats.srtt + 4*this->stats.rttvar,
+                                CONFIG_WS_PROBE_TIMEOUT_MIN*1000,
+                                CONFIG_WS_PROBE_TIMEOUT_MAX*1000);
+  }
+
+
+  bool WebSocketPipe::handle_probe_reply(const char * data, int len) {
+    auto pos = find_token(data, len, ProbeIdPrefix);
+    if (pos == nullptr) return false;
+    auto now = esp_timer_get_time();
+    uint32_t seq = strtoul(pos, nullptr, 10);
+    std::lock_guard<std::mutex> lock(this->stats_mtx);
+    // replies to probes that already timed out are just dropped
+    if (seq != this->probe_seq || this->probe_sent_at == 0) return true;
+    uint32_t rtt = now - this->probe_sent_at;
+    this->probe_sent_at = 0;
+    this->probes_missed = 0;
+    // smoothed RTT and variation as in RFC 6298
+    if (this->stats.srtt == 0) {
+      this->stats.srtt = rtt;
+      this->stats.rttvar = rtt/2;
+    } else {
+      uint32_t delta = this->stats.srtt > rtt ? this->stats.srtt - rtt : rtt - this->stats.srtt;
+      this->stats.rttvar = (3*this->stats.rttvar + delta)/4;
+      this->stats.srtt = (7*this->stats.srtt + rtt)/8;
+    }
+    this->stats.last_rtt = rtt;
+    ESP_LOGI("WebSocketPipe", "probe %u: rtt=%uus, srtt=%uus, jitter=%uus", seq, rtt, this->stats.srtt, this->stats.rttvar);
+    return true;
+  }
+
+
+  void WebSocketPipe::reconnect() {
+    ESP_LOGI("WebSocketPipe", "link is dead; reconnecting.");
+    {
+      std::lock_guard<std::mutex> lock(this->stats_mtx);
+      this->connected = false;
+      this->identified = false;
+      this->probe_sent_at = 0;
+      this->probes_missed = 0;
+      this->stats.reconnects++;
+    }
+    esp_websocket_client_stop(this->ws_client);
+    this->handshake_start = esp_timer_get_time();
+    esp_websocket_client_start(this->ws_client);
+  }
+
+
+  void WebSocketPipe::probe_task() {
+    ESP_LOGI("WebSocketPipe", "created probe task.");
+    char buffer[128];
+    while (this->loop_running) {
+      vTaskDelay(CONFIG_WS_PROBE_INTERVAL/portTICK_PERIOD_MS);
+      bool dead = false;
+      int len = 0;
+      {
+        std::lock_guard<std::mutex> lock(this->stats_mtx);
+        if (!this->connected || !this->identified) continue;
+        auto now = esp_timer_get_time();
+        if (this->probe_sent_at != 0) {
+          // a probe is outstanding; wait until it times out
+          if (now - this->probe_sent_at < this->probe_timeout()) continue;
+          this->stats.probes_lost++;
+          this->probe_sent_at = 0;
+          dead = ++this->probes_missed >= CONFIG_WS_PROBE_MAX_MISSED;
+        }
+        if (!dead) {
+          // GetStudioModeEnabled is a trivial getter, so reply time is dominated by the link
+          this->probe_seq++;
+          len = snprintf(buffer, sizeof(buffer),
+                         "{\"op\":6,\"d\":{\"requestType\":\"GetStudioModeEnabled\",\"requestId\":\"%s%u\"}}",
+                         ProbeIdPrefix, this->probe_seq);
+          this->probe_sent_at = now;
+          this->stats.probes_sent++;
+        }
+      }
+      if (dead)
+        this->reconnect();
+      else if (esp_websocket_client_send_text(this->ws_client, buffer, len, 500/portTICK_PERIOD_MS) < 0)
+        ESP_LOGI("WebSocketPipe", "cannot send probe.");
+    }
+    xSemaphoreGive(this->tasks_done);
+    vTaskDelete(nullptr);
+  }
+
+
   bool WebSocketPipe::publish_callback(MessageType t, const std::string & data) {
-    if ((t & this->in_message_type) == MessageType::NoOutlet) {
+    if (!accepts(this->in_message_type, t)) {
       ESP_LOGI("WebSocketPipe", "message of type %d rejected. Expected %d", static_cast<int>(t), static_cast<int>(this->in_message_type));
       return false;
     }
-    return this->write_bytes(data) == 0;
+    if (!this->connected) return false;
+    // message is handed over to send task; publisher doesn't wait for transmission
+    // only message resulting from traced input event is tagged, for send task to stamp it
+    QueuedMessage msg{new std::string(data), hardware::input::trace::claim()};
+    if (xQueueSend(this->send_queue, &msg, 0) != pdTRUE) {
+      ESP_LOGE("WebSocketPipe", "send queue of connection %d is full; message dropped.", this->target);
+      delete msg.data;
+      return false;
+    }
+    return true;
+  }
+
+
+  void WebSocketPipe::send_task() {
+    ESP_LOGI("WebSocketPipe", "created send task.");
+    QueuedMessage msg;
+    while (this->loop_running) {
+      if (xQueueReceive(this->send_queue, &msg, 100/portTICK_PERIOD_MS) != pdTRUE) continue;
+      if (this->write_bytes(*msg.data) < 0)
+        ESP_LOGE("WebSocketPipe", "connection %d lost; message dropped.", this->target);
+      else if (msg.traced)
+        hardware::input::trace::stamp(hardware::input::trace::Stage::Sent);
+      delete msg.data;
+    }
+    xSemaphoreGive(this->tasks_done);
+    vTaskDelete(nullptr);
   }
 
 
@@ -91,9 +362,26 @@ namespace eobsws::comm::pipe {
       switch (event_id) {
       case WEBSOCKET_EVENT_CONNECTED:
           this->connected = true;
+          // automatic reconnections aren't timed, as their start isn't notified by client
+          if (this->handshake_start != 0) {
+              std::lock_guard<std::mutex> lock(this->stats_mtx);
+              this->stats.handshake = esp_timer_get_time() - this->handshake_start;
+              this->handshake_start = 0;
+              ESP_LOGI("WebSocketPipe", "connection %d set up in %uus%s.", this->target,
+                       this->stats.handshake, this->tls ? " (TLS)" : "");
+          }
+          if (!this->ws_ever_connected) {
+              this->ws_ever_connected = true;
+              this->timing.ready = esp_timer_get_time();
+              this->log_timing();
+          }
           break;
-      case WEBSOCKET_EVENT_DISCONNECTED:
+      case WEBSOCKET_EVENT_DISCONNECTED: {
+          std::lock_guard<std::mutex> lock(this->stats_mtx);
           this->connected = false;
+          this->identified = false;
+          this->probe_sent_at = 0;
+      }
           break;
       case WEBSOCKET_EVENT_DATA:
           if (data->op_code == 0x08) {
@@ -103,12 +391,29 @@ namespace eobsws::comm::pipe {
           } else if (data->op_code == 0x00 || data->op_code == 0x01 || data->op_code == 0x02) {
               // continuation frame, text frame or binary frame
               ESP_LOGI("WebSocketPipe", "Received=%.*s", data->data_len, (char *)data->data_ptr);
+              // probe replies are consumed here
+              if (this->handle_probe_reply(data->data_ptr, data->data_len)) break;
+              // Identified message (op 2) means that requests can be sent
+              if (!this->identified) {
+                  auto pos = find_token(data->data_ptr, data->data_len, "\"op\":2");
+                  if (pos != nullptr && (pos == data->data_ptr + data->data_len || !isdigit(*pos)))
+                      this->identified = true;
+              }
               this->db->publish(this->out_message_type, std::string(data->data_ptr, data->data_len));
           } else if (data->op_code == 0x09 || data->op_code == 0x0a) {
-              // ping or pong
+              // ping or pong: answered and tracked by client for transport-level timeout
           }
           break;
       case WEBSOCKET_EVENT_ERROR:
+          // if first connection fails with cached parameters, they may be stale;
+          // drop them so that next boot goes through full scan, DHCP and DNS
+          if (!this->ws_ever_connected && (this->ws_address_cached || this->cache_used)) {
+              this->ws_address_cached = false;
+              this->cache_used = false;
+              if (this->nvs != nullptr)
+                  this->nvs->erase_item("wifi_cache", this->cache_key("ws_addr"));
+              this->invalidate_cache();
+          }
           break;
       }
   }
@@ -6,11 +6,55 @@
  */
 #pragma once
 #include "esp_websocket_client.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 
 #include "wifi_pipe.h"
+#include <mutex>
 
 namespace eobsws::comm::pipe {
 
+  /** \struct LinkStats
+   *  \brief Link quality figures measured with periodic round-trip probes.
+   *  Times are in microseconds.
+   */
+  struct LinkStats {
+    /** \property uint32_t srtt
+     *  \brief Smoothed round-trip time (0 if not measured yet).
+     */
+    uint32_t srtt = 0;
+
+    /** \property uint32_t rttvar
+     *  \brief Round-trip time variation (jitter).
+     */
+    uint32_t rttvar = 0;
+
+    /** \property uint32_t last_rtt
+     *  \brief Last measured round-trip time.
+     */
+    uint32_t last_rtt = 0;
+
+    /** \property uint32_t probes_sent
+     *  \brief Number of probes sent.
+     */
+    uint32_t probes_sent = 0;
+
+    /** \property uint32_t probes_lost
+     *  \brief Number of probes that timed out.
+     */
+    uint32_t probes_lost = 0;
+
+    /** \property uint32_t reconnects
+     *  \brief Number of reconnections triggered by dead link detection.
+     */
+    uint32_t reconnects = 0;
+
+    /** \property uint32_t handshake
+     *  \brief Duration of last connection setup (TCP, TLS if enabled, WebSocket upgrade).
+     */
+    uint32_t handshake = 0;
+  };
+
   /** \class WebSocketPipe
    *  \brief Base UART command parser class. It handles communication through an UART port
    *  and provides scaffolding to process data.
@@ -38,6 +82,86 @@ namespace eobsws::comm::pipe {
      *  \brief WebSocket server path
      */
     std::string ws_path;
+
+    /** \property std::string ws_address
+     *  \brief Resolved WebSocket server address
+     */
+    std::string ws_address;
+
+    /** \property bool tls
+     *  \brief If true, connection goes through TLS (wss://).
+     */
+    bool tls = false;
+
+    /** \property std::string cert_pem
+     *  \brief Trusted certificate (server or issuing CA), in PEM format.
+     */
+    std::string cert_pem;
+
+    /** \property int64_t handshake_start
+     *  \brief Time at which current connection setup started (0 if none).
+     */
+    int64_t handshake_start = 0;
+
+    /** \property uint8_t target
+     *  \brief Target index of this connection, used to route tagged messages.
+     */
+    uint8_t target = 0;
+
+    /** \property QueueHandle_t send_queue
+     *  \brief Queue of outbound messages (QueuedMessage items), drained by send_task.
+     */
+    QueueHandle_t send_queue = nullptr;
+
+    /** \property SemaphoreHandle_t tasks_done
+     *  \brief Semaphore given by probe and send tasks when they exit.
+     */
+    SemaphoreHandle_t tasks_done = nullptr;
+
+    /** \property uint8_t tasks_started
+     *  \brief Number of probe and send tasks started, to be waited for on destruction.
+     */
+    uint8_t tasks_started = 0;
+
+    /** \property bool ws_address_cached
+     *  \brief True if server address was taken from cache.
+     */
+    bool ws_address_cached = false;
+
+    /** \property bool ws_ever_connected
+     *  \brief True if WebSocket connection succeeded at least once.
+     */
+    bool ws_ever_connected = false;
+
+    /** \property std::atomic<bool> identified
+     *  \brief True once obs-websocket session is identified; probes are only sent then.
+     */
+    std::atomic<bool> identified = false;
+
+    /** \property uint32_t probe_seq
+     *  \brief Sequence number of last probe.
+     */
+    uint32_t probe_seq = 0;
+
+    /** \property int64_t probe_sent_at
+     *  \brief Time at which outstanding probe was sent (0 if none).
+     */
+    int64_t probe_sent_at = 0;
+
+    /** \property uint8_t probes_missed
+     *  \brief Number of consecutive probes that timed out.
+     */
+    uint8_t probes_missed = 0;
+
+    /** \property LinkStats stats
+     *  \brief Link quality figures.
+     */
+    LinkStats stats;
+
+    /** \property std::mutex stats_mtx
+     *  \brief Mutex protecting probe state and statistics.
+     */
+    mutable std::mutex stats_mtx;
     
     /** \property char data[CONFIG_WS_BUFFER_SIZE]
      *  \brief Data buffer.
@@ -49,6 +173,49 @@ namespace eobsws::comm::pipe {
      */
     esp_websocket_client_handle_t ws_client;
     
+    /** \fn std::string resolve_host()
+     *  \brief Resolve WebSocket host name to an IPv4 address, using cached result if available.
+     *  \returns IPv4 address in dotted notation, or host name if resolution failed.
+     */
+    std::string resolve_host();
+
+    /** \fn std::string cache_key(const char * name) const
+     *  \brief Get NVS key under which connection-specific data is cached.
+     *  \param name: base key name.
+     *  \returns key name suffixed with target index.
+     */
+    std::string cache_key(const char * name) const;
+
+    /** \fn void send_task()
+     *  \brief Task sending queued outbound messages, so that a slow connection
+     *  doesn't hold up the publisher nor other connections.
+     */
+    void send_task();
+
+    /** \fn void probe_task()
+     *  \brief Task sending periodic round-trip probes and detecting dead links.
+     */
+    void probe_task();
+
+    /** \fn uint32_t probe_timeout() const
+     *  \brief Compute probe timeout from RTT estimate, in the manner of TCP's RTO.
+     *  \returns probe timeout in microseconds.
+     */
+    uint32_t probe_timeout() const;
+
+    /** \fn bool handle_probe_reply(const char * data, int len)
+     *  \brief Check if a frame is a probe reply, and update RTT estimate if it is.
+     *  \param data: frame content.
+     *  \param len: frame length.
+     *  \returns true if frame was a probe reply, false otherwise.
+     */
+    bool handle_probe_reply(const char * data, int len);
+
+    /** \fn void reconnect()
+     *  \brief Restart WebSocket client after a dead link was detected.
+     */
+    void reconnect();
+
     /** \fn void websocket_callback(void *event_handler_arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
      *  \brief Callback to process WebSocket events.
      *  \param event_base: base ID of the event to register the handler for.
@@ -99,6 +266,30 @@ namespace eobsws::comm::pipe {
      *  \brief Initiate a WebSocket connection.
      */
     void connect() override;
+
+    /** \fn void set_target(uint8_t target)
+     *  \brief Set target index of this connection. The pipe then only accepts outbound
+     *  messages tagged for this target (or untagged), and tags inbound messages with it.
+     *  Must be called before connect.
+     *  \param target: target index (0 to MaxTargets-1).
+     */
+    void set_target(uint8_t target);
+
+    /** \fn bool set_tls(const std::string & cert_pem)
+     *  \brief Enable TLS (wss://). Server certificate must be the given certificate or
+     *  be issued by it, and must name host (in CN, or in SAN as a DNS name) as configured;
+     *  host name is therefore resolved by client, without address cache. Must be called
+     *  before connect.
+     *  \param cert_pem: server certificate (self-signed or issuing CA), in PEM format.
+     *  \returns true if TLS could be enabled, false if certificate is missing.
+     */
+    bool set_tls(const std::string & cert_pem);
+
+    /** \fn uint8_t get_target() const
+     *  \brief Get target index of this connection.
+     *  \returns target index.
+     */
+    uint8_t get_target() const { return this->target; }
     
     /** \fn int write_bytes(const uint8_t * bytes, uint16_t len)
      *  \brief Write bytes to transfer buffer.
@@ -121,6 +312,18 @@ namespace eobsws::comm::pipe {
      */
     int write_bytes(std::string bytes);
 
+    /** \fn LinkStats get_link_stats() const
+     *  \brief Get link quality figures.
+     *  \returns a copy of link quality figures.
+     */
+    LinkStats get_link_stats() const;
+
+    /** \fn bool is_link_up() const
+     *  \brief Tell if WebSocket connection is established and responsive.
+     *  \returns true if link is up, false otherwise.
+     */
+    bool is_link_up() const;
+
   };
 
 }
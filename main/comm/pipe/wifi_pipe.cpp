@@ -11,7 +11,11 @@
 #include "esp_event.h"
 #include "esp_wifi.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif_net_stack.h"
+#include "lwip/dhcp.h"
 #include <cstring>
+#include <ctime>
 
 #include "wifi_pipe.h"
 
@@ -20,6 +24,33 @@ namespace eobsws::comm::pipe {
   #define WIFI_CONNECTED_BIT BIT0
   #define WIFI_FAIL_BIT      BIT1
 
+  WiFiPipe * WiFiPipe::station = nullptr;
+  std::mutex WiFiPipe::station_mtx;
+
+  /** \var static constexpr int64_t LeaseMargin
+   *  \brief Minimum time left on a cached lease for it to be reused, in seconds.
+   */
+  static constexpr int64_t LeaseMargin = 60;
+
+  /** \var static constexpr int RenewTimeout
+   *  \brief Maximum waiting time for a cached lease to be renewed, in milliseconds.
+   */
+  static constexpr int RenewTimeout = 2000;
+
+  /** \fn static bool lease_valid(int64_t lease_end)
+   *  \brief Tell if a cached lease can still be used.
+   *  \param lease_end: time at which lease expires, in seconds on system clock.
+   *  \returns true if lease is known not to have expired, false otherwise.
+   */
+  static bool lease_valid(int64_t lease_end) {
+      // system clock keeps counting across software resets only; after a power loss,
+      // time spent off is unknown and lease may have run out
+      auto reason = esp_reset_reason();
+      if (reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT || reason == ESP_RST_UNKNOWN)
+          return false;
+      return lease_end > static_cast<int64_t>(time(nullptr)) + LeaseMargin;
+  }
+
   WiFiPipe::WiFiPipe(
     std::shared_ptr<DataBroker> db,
     const std::string & wifi_ssid,
@@ -32,6 +63,9 @@ namespace eobsws::comm::pipe {
   }
 
   WiFiPipe::~WiFiPipe() {
+      std::lock_guard<std::mutex> lock(WiFiPipe::station_mtx);
+      if (WiFiPipe::station != this) return;
+      WiFiPipe::station = nullptr;
       esp_wifi_disconnect();
       esp_wifi_stop();
       esp_wifi_deinit();
@@ -39,12 +73,32 @@ namespace eobsws::comm::pipe {
 
   void WiFiPipe::connect() {
       if (!this->connected) {
+          std::unique_lock<std::mutex> lock(WiFiPipe::station_mtx);
+          if (WiFiPipe::station != nullptr && WiFiPipe::station != this) {
+              // station is already brought up by another instance; just wait for it
+              auto owner = WiFiPipe::station;
+              lock.unlock();
+              ESP_LOGI("WiFiPipe", "sharing WiFi station.");
+              xEventGroupWaitBits(owner->wifi_event_group,
+                  WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
+                  pdFALSE,
+                  pdFALSE,
+                  portMAX_DELAY);
+              this->timing = owner->timing;
+              this->cache_used = owner->cache_used;
+              return;
+          }
+          WiFiPipe::station = this;
+          this->wifi_event_group = xEventGroupCreate();
+          lock.unlock();
+
           ESP_LOGI("WiFiPipe", "connecting to WiFi.");
           ESP_LOGI("WiFiPipe", "Network SSID: %s", this->wifi_ssid.c_str() );
+          this->timing = ConnectionTiming();
+          this->timing.start = esp_timer_get_time();
 
-          this->wifi_event_group = xEventGroupCreate();
           // set up WiFi station
-          esp_netif_create_default_wifi_sta();
+          this->netif = esp_netif_create_default_wifi_sta();
           wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
           // initialize WiFi interface
           ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -81,6 +135,23 @@ namespace eobsws::comm::pipe {
                   .capable = true,
                   .required = false
               };
+          // if parameters of last connection are known, connect directly
+          // to the same access point, without scanning
+          #if CONFIG_WIFI_FAST_CONNECT
+          if (this->load_cache()) {
+              ESP_LOGI("WiFiPipe", "attempting directed connection on channel %d.", this->cache.channel);
+              wifi_config.sta.bssid_set = true;
+              memcpy(wifi_config.sta.bssid, this->cache.bssid, sizeof(this->cache.bssid));
+              wifi_config.sta.channel = this->cache.channel;
+              this->fast_connect = true;
+          }
+          #endif
+          // static IP has precedence over cached lease; DHCP is used if none is available,
+          // or if lease may have expired (access point is still connected to directly)
+          if (this->static_ip.ip.addr != 0)
+              this->apply_ip_config(this->static_ip, this->static_dns);
+          else if (this->fast_connect && this->cache.ip_info.ip.addr != 0 && lease_valid(this->cache.lease_end))
+              this->apply_ip_config(this->cache.ip_info, this->cache.dns);
           
           // apply WiFi configuration
           ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA) );
@@ -91,23 +162,206 @@ namespace eobsws::comm::pipe {
 
           /* Waiting until either the connection is established (WIFI_CONNECTED_BIT) or connection failed for the maximum
           * number of re-tries (WIFI_FAIL_BIT). The bits are set by event_handler() (see above) */
-          xEventGroupWaitBits(this->wifi_event_group,
+          [[maybe_unused]] EventBits_t bits = xEventGroupWaitBits(this->wifi_event_group,
               WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
               pdFALSE,
               pdFALSE,
               portMAX_DELAY);
 
+          #if CONFIG_WIFI_FAST_CONNECT
+          if (bits & WIFI_CONNECTED_BIT) {
+              this->renew_lease();
+              this->save_cache();
+          }
+          #endif
+
           ESP_LOGI("WiFiPipe", "WiFi connection initialized.");
+          this->log_timing();
+      }
+  }
+
+
+  void WiFiPipe::set_cache(std::shared_ptr<storage::NVStorage> nvs) {
+      this->nvs = nvs;
+  }
+
+
+  bool WiFiPipe::set_static_ip(const std::string & ip, const std::string & netmask, const std::string & gateway, const std::string & dns) {
+      this->static_ip = {};
+      this->static_dns = 0;
+      if (ip.empty()) return true;
+      esp_netif_ip_info_t ip_info = {};
+      if (esp_netif_str_to_ip4(ip.c_str(), &ip_info.ip) != ESP_OK
+          || esp_netif_str_to_ip4(netmask.c_str(), &ip_info.netmask) != ESP_OK
+          || esp_netif_str_to_ip4(gateway.c_str(), &ip_info.gw) != ESP_OK) {
+          ESP_LOGE("WiFiPipe", "invalid static IP configuration.");
+          return false;
+      }
+      esp_ip4_addr_t dns_addr = {};
+      if (!dns.empty() && esp_netif_str_to_ip4(dns.c_str(), &dns_addr) != ESP_OK) {
+          ESP_LOGE("WiFiPipe", "invalid DNS server address.");
+          return false;
+      }
+      this->static_ip = ip_info;
+      this->static_dns = dns_addr.addr;
+      return true;
+  }
+
+
+  bool WiFiPipe::load_cache() {
+      this->cache = WiFiCache();
+      if (this->nvs == nullptr) return false;
+      // cache is only meaningful for the network it was recorded on
+      if (this->nvs->get_string("wifi_cache", "ssid") != this->wifi_ssid) return false;
+      auto bssid = this->nvs->get_item<uint64_t>("wifi_cache", "bssid", 0);
+      this->cache.channel = this->nvs->get_item<uint8_t>("wifi_cache", "channel", 0);
+      if (bssid == 0 || this->cache.channel == 0) return false;
+      for (size_t n=0; n<sizeof(this->cache.bssid); n++)
+          this->cache.bssid[n] = (bssid >> (8*(sizeof(this->cache.bssid)-1-n))) & 0xff;
+      this->cache.ip_info.ip.addr = this->nvs->get_item<uint32_t>("wifi_cache", "ip", 0);
+      this->cache.ip_info.netmask.addr = this->nvs->get_item<uint32_t>("wifi_cache", "netmask", 0);
+      this->cache.ip_info.gw.addr = this->nvs->get_item<uint32_t>("wifi_cache", "gateway", 0);
+      this->cache.dns = this->nvs->get_item<uint32_t>("wifi_cache", "dns", 0);
+      this->cache.lease_end = this->nvs->get_item<int64_t>("wifi_cache", "lease_end", 0);
+      this->cache.valid = true;
+      return true;
+  }
+
+
+  void WiFiPipe::save_cache() {
+      if (this->nvs == nullptr) return;
+      wifi_ap_record_t ap_info;
+      if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) return;
+      WiFiCache current;
+      memcpy(current.bssid, ap_info.bssid, sizeof(current.bssid));
+      current.channel = ap_info.primary;
+      // a statically configured address doesn't need to be cached
+      if (this->static_ip.ip.addr == 0) {
+          esp_netif_get_ip_info(this->netif, &current.ip_info);
+          auto dhcp = netif_dhcp_data(static_cast<struct netif*>(esp_netif_get_netif_impl(this->netif)));
+          if (dhcp != nullptr && current.ip_info.ip.addr != 0)
+              current.lease_end = static_cast<int64_t>(time(nullptr)) + dhcp->offered_t0_lease;
+      }
+      esp_netif_dns_info_t dns_info = {};
+      if (esp_netif_get_dns_info(this->netif, ESP_NETIF_DNS_MAIN, &dns_info) == ESP_OK)
+          current.dns = dns_info.ip.u_addr.ip4.addr;
+      // write only if something changed, to spare flash
+      if (this->cache.valid
+          && !memcmp(current.bssid, this->cache.bssid, sizeof(current.bssid))
+          && current.channel == this->cache.channel
+          && current.ip_info.ip.addr == this->cache.ip_info.ip.addr
+          && current.ip_info.netmask.addr == this->cache.ip_info.netmask.addr
+          && current.ip_info.gw.addr == this->cache.ip_info.gw.addr
+          && current.dns == this->cache.dns) {
+          // lease is renewed at each connection; only its expiry is updated
+          if (current.lease_end != this->cache.lease_end) {
+              this->nvs->set_item<int64_t>("wifi_cache", "lease_end", current.lease_end);
+              this->cache.lease_end = current.lease_end;
+          }
+          return;
+      }
+      uint64_t bssid = 0;
+      for (size_t n=0; n<sizeof(current.bssid); n++)
+          bssid = (bssid << 8) | current.bssid[n];
+      ESP_LOGI("WiFiPipe", "caching connection parameters.");
+      this->nvs->set_string("wifi_cache", "ssid", this->wifi_ssid);
+      this->nvs->set_item<uint64_t>("wifi_cache", "bssid", bssid);
+      this->nvs->set_item<uint8_t>("wifi_cache", "channel", current.channel);
+      this->nvs->set_item<uint32_t>("wifi_cache", "ip", current.ip_info.ip.addr);
+      this->nvs->set_item<uint32_t>("wifi_cache", "netmask", current.ip_info.netmask.addr);
+      this->nvs->set_item<uint32_t>("wifi_cache", "gateway", current.ip_info.gw.addr);
+      this->nvs->set_item<uint32_t>("wifi_cache", "dns", current.dns);
+      this->nvs->set_item<int64_t>("wifi_cache", "lease_end", current.lease_end);
+      current.valid = true;
+      this->cache = current;
+  }
+
+
+  void WiFiPipe::renew_lease() {
+      // a configured static address isn't leased
+      if (!this->fixed_ip || this->static_ip.ip.addr != 0) return;
+      ESP_LOGI("WiFiPipe", "renewing cached IP lease.");
+      // client asks for the address it held last (LWIP_DHCP_RESTORE_LAST_IP), so this
+      // takes a single exchange; connection bit is set again once lease is bound
+      xEventGroupClearBits(this->wifi_event_group, WIFI_CONNECTED_BIT);
+      this->fixed_ip = false;
+      esp_netif_dhcpc_start(this->netif);
+      auto bits = xEventGroupWaitBits(this->wifi_event_group, WIFI_CONNECTED_BIT,
+                                      pdFALSE, pdFALSE, RenewTimeout/portTICK_PERIOD_MS);
+      if (!(bits & WIFI_CONNECTED_BIT)) {
+          ESP_LOGE("WiFiPipe", "IP lease not renewed yet; DHCP goes on in background.");
+          // connection stays up; waiting instances must not be held
+          xEventGroupSetBits(this->wifi_event_group, WIFI_CONNECTED_BIT);
+      }
+  }
+
+
+  void WiFiPipe::invalidate_cache() {
+      if (this->nvs == nullptr) return;
+      ESP_LOGI("WiFiPipe", "invalidating cached connection parameters.");
+      // without BSSID, cache is considered invalid
+      this->nvs->erase_item("wifi_cache", "bssid");
+      this->cache.valid = false;
+  }
+
+
+  void WiFiPipe::fall_back() {
+      ESP_LOGI("WiFiPipe", "directed connection failed; falling back to full scan.");
+      this->fast_connect = false;
+      this->cache.valid = false;
+      wifi_config_t wifi_config;
+      esp_wifi_get_config(WIFI_IF_STA, &wifi_config);
+      wifi_config.sta.bssid_set = false;
+      wifi_config.sta.channel = 0;
+      esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+      // cached lease may not be valid on another access point
+      if (this->fixed_ip && this->static_ip.ip.addr == 0) {
+          esp_netif_dhcpc_start(this->netif);
+          this->fixed_ip = false;
       }
   }
 
 
+  void WiFiPipe::apply_ip_config(const esp_netif_ip_info_t & ip_info, uint32_t dns) {
+      esp_netif_dhcpc_stop(this->netif);
+      if (esp_netif_set_ip_info(this->netif, &ip_info) != ESP_OK) {
+          ESP_LOGE("WiFiPipe", "cannot set IP configuration; using DHCP.");
+          esp_netif_dhcpc_start(this->netif);
+          return;
+      }
+      if (dns != 0) {
+          esp_netif_dns_info_t dns_info = {};
+          dns_info.ip.type = ESP_IPADDR_TYPE_V4;
+          dns_info.ip.u_addr.ip4.addr = dns;
+          esp_netif_set_dns_info(this->netif, ESP_NETIF_DNS_MAIN, &dns_info);
+      }
+      this->fixed_ip = true;
+  }
+
+
+  void WiFiPipe::log_timing() const {
+      auto phase = [this](int64_t t) {
+        return t > 0 ? static_cast<int>((t - this->timing.start)/1000) : -1;
+      };
+      ESP_LOGI("WiFiPipe", "connection timing (ms since start, -1=not reached): associated=%d, got_ip=%d, resolved=%d, ready=%d",
+               phase(this->timing.associated), phase(this->timing.got_ip),
+               phase(this->timing.resolved), phase(this->timing.ready));
+  }
+
+
   void WiFiPipe::wifi_callback(esp_event_base_t event_base, int32_t event_id, void* event_data) {
       if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
           esp_wifi_connect();
+      } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+          if (this->timing.associated == 0)
+              this->timing.associated = esp_timer_get_time();
       } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
           // connection failed...
-          if (this->wifi_retry_count < CONFIG_WIFI_MAX_RETRIES) {
+          if (this->fast_connect) {
+              // access point changed or moved => retry with full scan
+              this->fall_back();
+              esp_wifi_connect();
+          } else if (this->wifi_retry_count < CONFIG_WIFI_MAX_RETRIES) {
               // if number of retries < max, retry
               esp_wifi_connect();
               this->wifi_retry_count++;
@@ -117,6 +371,12 @@ namespace eobsws::comm::pipe {
           }
       } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
           // connected, yippie!
+          // lease renewal after a directed connection doesn't change how it was made
+          if (this->timing.got_ip == 0) {
+              this->timing.got_ip = esp_timer_get_time();
+              this->cache_used = this->fast_connect;
+              this->fast_connect = false;
+          }
           this->wifi_retry_count = 0;
           xEventGroupSetBits(this->wifi_event_group, WIFI_CONNECTED_BIT);
       }
@@ -10,10 +10,81 @@
 #include <stdio.h>
 #include "freertos/event_groups.h"
 #include "esp_event.h"
+#include "esp_netif.h"
 #include "../data_node.h"
+#include "storage/nvs.h"
+#include <atomic>
+#include <mutex>
 
 namespace eobsws::comm::pipe {
 
+  /** \struct ConnectionTiming
+   *  \brief Timestamps of connection phases, in microseconds since boot.
+   *  A value of 0 means that the phase hasn't been reached.
+   */
+  struct ConnectionTiming {
+    /** \property int64_t start
+     *  \brief Time at which connection was initiated.
+     */
+    int64_t start = 0;
+
+    /** \property int64_t associated
+     *  \brief Time at which station got associated with access point.
+     */
+    int64_t associated = 0;
+
+    /** \property int64_t got_ip
+     *  \brief Time at which station got an IP address.
+     */
+    int64_t got_ip = 0;
+
+    /** \property int64_t resolved
+     *  \brief Time at which remote host name got resolved.
+     */
+    int64_t resolved = 0;
+
+    /** \property int64_t ready
+     *  \brief Time at which link became ready for application traffic.
+     */
+    int64_t ready = 0;
+  };
+
+  /** \struct WiFiCache
+   *  \brief Parameters of the last successful connection, persisted in NVS
+   *  to skip scan and DHCP on next boot.
+   */
+  struct WiFiCache {
+    /** \property bool valid
+     *  \brief True if cached data can be used.
+     */
+    bool valid = false;
+
+    /** \property uint8_t bssid[6]
+     *  \brief MAC address of access point.
+     */
+    uint8_t bssid[6] = {};
+
+    /** \property uint8_t channel
+     *  \brief WiFi channel of access point.
+     */
+    uint8_t channel = 0;
+
+    /** \property esp_netif_ip_info_t ip_info
+     *  \brief IP address, netmask and gateway.
+     */
+    esp_netif_ip_info_t ip_info = {};
+
+    /** \property uint32_t dns
+     *  \brief DNS server address.
+     */
+    uint32_t dns = 0;
+
+    /** \property int64_t lease_end
+     *  \brief Time at which IP lease expires, in seconds on system clock (0 if unknown).
+     */
+    int64_t lease_end = 0;
+  };
+
   /** \class WiFiPipe
    *  \brief Base WiFi pipe class. It handles communication through a WiFi connection.
    */
@@ -45,10 +116,10 @@ namespace eobsws::comm::pipe {
      */
     bool loop_running;
 
-    /** \property bool connected
+    /** \property std::atomic<bool> connected
      *  \brief If true, WiFi connection is established; false otherwise.
      */
-    bool connected = false;
+    std::atomic<bool> connected = false;
     
     /** \property EventGroupHandle_t wifi_event_group
      *  \brief WiFi event group.
@@ -59,6 +130,96 @@ namespace eobsws::comm::pipe {
      *  \brief Connection retry count.
      */
     int wifi_retry_count = 0;
+
+    /** \property esp_netif_t * netif
+     *  \brief Station network interface.
+     */
+    esp_netif_t * netif = nullptr;
+
+    /** \property std::shared_ptr<storage::NVStorage> nvs
+     *  \brief Non-volatile storage used to cache connection parameters.
+     */
+    std::shared_ptr<storage::NVStorage> nvs;
+
+    /** \property WiFiCache cache
+     *  \brief Connection parameters loaded from NVS.
+     */
+    WiFiCache cache;
+
+    /** \property esp_netif_ip_info_t static_ip
+     *  \brief Static IP configuration; DHCP is used if address is 0.
+     */
+    esp_netif_ip_info_t static_ip = {};
+
+    /** \property uint32_t static_dns
+     *  \brief Static DNS server address.
+     */
+    uint32_t static_dns = 0;
+
+    /** \property bool fast_connect
+     *  \brief True while a directed connection with cached parameters is attempted.
+     */
+    bool fast_connect = false;
+
+    /** \property bool cache_used
+     *  \brief True if current connection was established with cached parameters.
+     */
+    bool cache_used = false;
+
+    /** \property bool fixed_ip
+     *  \brief True if IP configuration is set without DHCP.
+     */
+    bool fixed_ip = false;
+
+    /** \property ConnectionTiming timing
+     *  \brief Timestamps of connection phases.
+     */
+    ConnectionTiming timing;
+
+    /** \property static WiFiPipe * station
+     *  \brief Instance that owns the WiFi station. The station is shared by all
+     *  instances, so that several connections can run over the same WiFi link.
+     */
+    static WiFiPipe * station;
+
+    /** \property static std::mutex station_mtx
+     *  \brief Mutex protecting station ownership.
+     */
+    static std::mutex station_mtx;
+    
+    /** \fn bool load_cache()
+     *  \brief Load cached connection parameters from NVS.
+     *  \returns true if cached parameters are usable, false otherwise.
+     */
+    bool load_cache();
+
+    /** \fn void save_cache()
+     *  \brief Store parameters of current connection in NVS, if they changed.
+     */
+    void save_cache();
+
+    /** \fn void renew_lease()
+     *  \brief Restart DHCP client after a cached lease was applied, so that lease is
+     *  renewed with the server, and wait a short while for it to be bound.
+     */
+    void renew_lease();
+
+    /** \fn void fall_back()
+     *  \brief Drop cached parameters and revert to a full scan with DHCP.
+     */
+    void fall_back();
+
+    /** \fn void apply_ip_config(const esp_netif_ip_info_t & ip_info, uint32_t dns)
+     *  \brief Set a fixed IP configuration on station interface, bypassing DHCP.
+     *  \param ip_info: IP address, netmask and gateway.
+     *  \param dns: DNS server address (0 to keep current).
+     */
+    void apply_ip_config(const esp_netif_ip_info_t & ip_info, uint32_t dns);
+
+    /** \fn void log_timing() const
+     *  \brief Log duration of connection phases.
+     */
+    void log_timing() const;
     
     /** \fn void wifi_callback(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
      *  \brief Callback to process WiFi events.
@@ -99,6 +260,33 @@ namespace eobsws::comm::pipe {
      */
     virtual void connect();
 
+    /** \fn void set_cache(std::shared_ptr<storage::NVStorage> nvs)
+     *  \brief Set storage used to cache connection parameters. Must be called before connect.
+     *  \param nvs: pointer to a non-volatile storage accessor.
+     */
+    void set_cache(std::shared_ptr<storage::NVStorage> nvs);
+
+    /** \fn bool set_static_ip(const std::string & ip, const std::string & netmask, const std::string & gateway, const std::string & dns)
+     *  \brief Configure a static IP address. Must be called before connect.
+     *  \param ip: IP address in dotted notation; if empty, DHCP is used.
+     *  \param netmask: network mask in dotted notation.
+     *  \param gateway: gateway address in dotted notation.
+     *  \param dns: DNS server address in dotted notation (optional).
+     *  \returns true if configuration is valid, false otherwise.
+     */
+    bool set_static_ip(const std::string & ip, const std::string & netmask, const std::string & gateway, const std::string & dns);
+
+    /** \fn void invalidate_cache()
+     *  \brief Erase cached connection parameters, so that next connection does a full scan.
+     */
+    void invalidate_cache();
+
+    /** \fn const ConnectionTiming & get_timing() const
+     *  \brief Get timestamps of connection phases.
+     *  \returns timestamps of connection phases.
+     */
+    const ConnectionTiming & get_timing() const { return this->timing; }
+
     /** \fn int8_t get_rssi() const
      *  \brief Gets raw WiFi RSSI value.
      *  \returns raw value of WiFi RSSI.
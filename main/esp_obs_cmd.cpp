@@ -12,11 +12,14 @@
 #include "esp_system.h"
 
 #include "impl/setup.h"
+#include "storage/ota.h"
 #include "impl/gui.h"
 #include "impl/calibrate.h"
+#include "impl/reload.h"
 #include "hardware/digital_pin.h"
 
 #include <mutex>
+#include <algorithm>
 
 /** \var std::mutex mtx
  *  \brief Global mutex.
@@ -41,10 +44,11 @@ extern "C" void app_main(void) {
     auto cfg = Configuration(nvs);
     // initializes LVGL
     lv_init();
-    // sets up screen
-    auto tft = setup_screen(cfg);
-    // sets up touch panel
-    auto touch = setup_touch(cfg);
+    // sets up screen; screen is shared with UART handler, for screenshots
+    std::shared_ptr<hardware::screen::ScreenLVGL> tft = setup_screen(cfg);
+    // sets up touch panel; touch panel and GPIO pins are shared with UART handler,
+    // for injected input events
+    std::shared_ptr<hardware::input::TouchpadLVGL> touch = setup_touch(cfg);
     touch->set_display(tft->raw_ptr());
     // sets up GPIO pins
     auto gpio = setup_gpio();
@@ -60,40 +64,52 @@ extern "C" void app_main(void) {
         auto tdev = std::dynamic_pointer_cast<hardware::input::ResistiveTouchPanel>(touch->device);
         calibrate_touch(*tdev, nvs);
         nvs->set_item<uint8_t>("calibration", "touch_ok", 1);
-        esp_restart();
+        // new calibration applies right away
+        cfg = Configuration(nvs);
+        tdev->set_scale(cfg.touch_scaling_x, cfg.touch_scaling_y);
+        tdev->set_offset(cfg.touch_offset_x, cfg.touch_offset_y);
+        #if CONFIG_TOUCH_WITH_INT
+        tdev->enable_touch_interrupt();
+        #endif
     }
     // sets up flash storage
     auto spiflash = setup_flash(cfg.storage_part_name);
     // initializes communication routines
     // -> creates data broker
     auto db = std::make_shared<comm::DataBroker>();
+    // -> collects configuration changes, applied in main loop
+    auto watcher = std::make_shared<ConfigWatcher>(db);
     // sets up UART handler
     UARTData udata;
-    setup_uart(db, nvs, spiflash, udata);
+    setup_uart(db, nvs, spiflash, tft, touch, gpio, udata);
+    // firmware that gets this far can receive another update: it is kept,
+    // otherwise bootloader goes back to previous one at next reset
+    storage::OTAUpdater::confirm_boot();
     // potentiometers calibration
     // this is done after UART so that we can reset the calibration
     // flags in case of a faulty screen calibration
     if (!cfg.pots_calibrated) {
         calibrate_potentiometers(gpio, nvs);
         nvs->set_item<uint8_t>("calibration", "pots_ok", 1);
-        esp_restart();
+        cfg = Configuration(nvs);
     }
     // sets up obs-websocket handler
     OBSData odata;
-    setup_websocket(db, cfg, odata);
+    setup_websocket(db, nvs, spiflash, cfg, odata);
+    setup_tunnel(cfg, udata);
+    setup_stats(udata, odata);
+    // sets up HTTP server for fast uploads over WiFi
+    auto http = setup_http(db, nvs, spiflash, cfg, odata);
     // initializes GUI elements
     GUIData gdata;
     std::vector<ButtonConfiguration> bcfgs;
     bcfgs.reserve(6);
     for (uint8_t n=0; n<6; n++)
         bcfgs.emplace_back(ButtonConfiguration(nvs, n));
-    auto screen_color = lvgl::misc::color::from_rgb(nvs->get_item<uint8_t>("screen","bg_color_r",0),
-                                                    nvs->get_item<uint8_t>("screen","bg_color_g",0),
-                                                    nvs->get_item<uint8_t>("screen","bg_color_b",0));
     // from that point on we'll modify the interface
     // => acquire the lock, otherwise LVGL may complain
     mtx.lock();
-    gdata.root->set_style_bg_color(screen_color, LV_PART_MAIN);
+    gdata.root->set_style_bg_color(cfg.screen_color, LV_PART_MAIN);
     load_wifi_icons(spiflash, gdata);
     load_battery_icons(spiflash, gdata);
     draw_buttons(db, spiflash, bcfgs, gdata);
@@ -101,17 +117,20 @@ extern "C" void app_main(void) {
     mtx.unlock(); // unlocks here as the 2 next functions claim the lock
     draw_wifi_icon(gdata, 0);
     draw_battery_icon(gdata, 0, false);
-    // creates WebSocket connection task
+    // creates WebSocket connection tasks
     auto fconnect = [](void* arg) {
       auto obj = reinterpret_cast<comm::pipe::WebSocketPipe*>(arg);
       obj->connect();
       vTaskDelete(nullptr);
     };
-    xTaskCreate(fconnect, "ws_connect_task", 8192, static_cast<void*>(odata.ws_pipe.get()), 15, nullptr);
+    // creates one connection task per OBS connection, so that connections are set up in parallel
+    for (auto & ws_pipe: odata.ws_pipes)
+        xTaskCreate(fconnect, "ws_connect_task", 8192, static_cast<void*>(ws_pipe.get()), 15, nullptr);
     // main loop - takes care of a number of basic things:
     //  1) reads potentiometers, updates bars and transmits data if necessary
     //  2) reads WiFi RSSI and updates icon
     //  3) reads battery level and updates icon
+    //  4) applies configuration changes
     char buffer[256]; // text buffer for outbound messages
     bool screen_active = true; // if true, screen is active
     for (;;) {
@@ -129,15 +148,19 @@ extern "C" void app_main(void) {
                               /static_cast<float>((cfg.pots[n].raw_max - cfg.pots[n].raw_min)*cfg.pots[n].divider)
                               +static_cast<float>(cfg.pots[n].obs_min*cfg.pots[n].raw_max - cfg.pots[n].obs_max*cfg.pots[n].raw_min)
                               /static_cast<float>((cfg.pots[n].raw_max - cfg.pots[n].raw_min)*cfg.pots[n].divider);
-                // generates command - if succesfull, sends data
+                // generates command - if succesfull, sends data to configured OBS connections
                 auto nchr = sprintf(buffer, cfg.pots[n].command.c_str(), value);
                 if (nchr>0)
-                    db->publish(comm::MessageType::OutboundWireless,
-                                comm::parser::obs::add_request_id(std::string(buffer, nchr)));
+                    db->broadcast(comm::MessageType::OutboundWireless | comm::target_mask(cfg.pots[n].targets),
+                                  comm::parser::obs::add_request_id(std::string(buffer, nchr)));
             }
         }
-        // reads WiFi RSSI and updates icon
-        draw_wifi_icon(gdata, odata.ws_pipe->get_rssi());
+        // reads WiFi RSSI and link round-trip time, and updates icon;
+        // icon reflects the worst OBS connection, and shows no connection if one is down
+        uint32_t rtt = 0;
+        for (auto & ws_pipe: odata.ws_pipes)
+            rtt = std::max(rtt, ws_pipe->is_link_up() ? ws_pipe->get_link_stats().srtt : UINT32_MAX);
+        draw_wifi_icon(gdata, odata.ws_pipes.empty() ? 0 : odata.ws_pipes[0]->get_rssi(), rtt);
         // reads battery level and updates icon if necessary;
         // battery level gets read with a /2 voltage divider, and processed
         // by ADC with 6dB attenuation -> scale should be about (1000, 1100).
@@ -154,6 +177,10 @@ extern "C" void app_main(void) {
             std::dynamic_pointer_cast<eobsws::hardware::screen::ST7789VI_TFT>(tft->screen)->set_backlight_level(cfg.bl_lvl_act, 100);
             screen_active = true;
         }
+        // applies configuration changes; connections stay up
+        auto changes = watcher->take_changes();
+        if (!changes.empty())
+            reload_config(db, nvs, spiflash, changes, cfg, bcfgs, gdata, tft, touch);
         // waits for 100ms
         vTaskDelay(100/portTICK_PERIOD_MS);
     }
@@ -11,6 +11,11 @@
 
 namespace eobsws::gui::image {
 
+    /** \var static constexpr int ChunkReadSize
+     *  \brief Size of reads feeding chunk data to decoder, in bytes.
+     */
+    static constexpr int ChunkReadSize = 1024;
+
     void ImagePNG::initialize() {
         ESP_LOGI("ImagePNG", "initializing Pngle for 0x%x.", reinterpret_cast<unsigned int>(this));
         if (this->pngle != nullptr) {
@@ -66,8 +71,13 @@ namespace eobsws::gui::image {
         
         // keep feeding file until width and height are set
         // reading header
-        auto buf = this->file->read(8);
-        pngle_feed(this->pngle.get(), buf.c_str(), buf.size());
+        uint8_t signature[8];
+        auto nread = this->file->read_into(signature, sizeof(signature));
+        if (nread != sizeof(signature)) {
+            ESP_LOGE("ImagePNG", "file '%s' is too short.", file->get_file_path().c_str());
+            return ESP_FAIL;
+        }
+        pngle_feed(this->pngle.get(), signature, nread);
         // reading chunks until width and height are set
         ESP_LOGI("ImagePNG", "reading image metadata.");
         while (this->width == 0 || this->height == 0) {
@@ -82,8 +92,12 @@ namespace eobsws::gui::image {
         this->bitmap.reserve(this->width * this->height);
 
         ESP_LOGI("ImagePNG", "reading image content.");
-        while (!this->ready)
-            this->read_next_chunk();
+        while (!this->ready) {
+            if (this->read_next_chunk() != 0 && !this->ready) {
+                ESP_LOGE("ImagePNG", "chunk reading failed.");
+                return ESP_FAIL;
+            }
+        }
 
         ESP_LOGI("ImagePNG", "file '%s' parsed succesfully.", file->get_file_path().c_str());
         return ESP_OK;
@@ -96,26 +110,29 @@ namespace eobsws::gui::image {
         }
         // if a chunk has been partly read, we carry on reading;
         // else, we assume we are at the beginning of a new chunk
-        ESP_LOGI("ImagePNG", "Reading chunk size...");
+        ESP_LOGD("ImagePNG", "Reading chunk size...");
         // chunk structure: length (4 bytes) | chunk type (4 bytes) | chunk data (length) | CRC (4 bytes)
         // we read 4 bytes to get length and add 8 bytes to account for type and CRC
-        auto buf = this->file->read(8);
+        uint8_t buf[8];
+        if (this->file->read_into(buf, sizeof(buf)) != sizeof(buf))
+            return -1;
         int chunk_length = ((buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3]) + 4; // add 4 for CRC
         if (chunk_length < 0)
             return -1;
-        ESP_LOGI("ImagPNG", "chunk size: %d bytes", chunk_length);
-        // reading type
-        int chunk_type = (buf[4] << 24) | (buf[5] << 16) | (buf[6] << 8) | buf[7];
-        ESP_LOGI("ImagePNG", "chunk type: 0x%x", chunk_type);
-        ESP_LOGI("ImagePNG", "pngle_feed result: %d", pngle_feed(this->pngle.get(), buf.c_str(), 8));
+        ESP_LOGD("ImagePNG", "chunk size: %d bytes", chunk_length);
+        ESP_LOGD("ImagePNG", "chunk type: 0x%x", (buf[4] << 24) | (buf[5] << 16) | (buf[6] << 8) | buf[7]);
+        if (pngle_feed(this->pngle.get(), buf, sizeof(buf)) < 0)
+            return -1;
+        // chunk data goes through a stack buffer, so that decoding doesn't allocate per chunk
+        uint8_t chunk[ChunkReadSize];
         while (chunk_length > 0) {
-            ESP_LOGI("ImagePNG", "reading %d bytes...", std::min(chunk_length, 1024));
-            auto chunk = this->file->read(std::min(chunk_length, 1024));
-            ESP_LOGI("ImagePNG", "%d bytes read.", chunk.size());
-            chunk_length -= chunk.size();
-            ESP_LOGI("ImagePNG", "%d bytes remaining", chunk_length);
-            int fed = pngle_feed(this->pngle.get(), chunk.c_str(), chunk.size());
-            ESP_LOGI("ImagePNG", "pngle_feed result: %d", fed);
+            auto nread = this->file->read_into(chunk, std::min(chunk_length, ChunkReadSize));
+            // file ending within a chunk would keep us here forever
+            if (nread == 0 || nread == static_cast<size_t>(-1))
+                return -1;
+            chunk_length -= nread;
+            int fed = pngle_feed(this->pngle.get(), chunk, nread);
+            ESP_LOGD("ImagePNG", "%d bytes fed, %d remaining in chunk; pngle_feed result: %d", nread, chunk_length, fed);
             if (fed<0)
                 return -1;
         }
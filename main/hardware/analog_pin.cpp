@@ -6,6 +6,7 @@
  */
 #include "driver/rtc_io.h"
 #include "analog_pin.h"
+#include "input/input_trace.h"
 
 namespace eobsws::hardware {
 
@@ -73,6 +74,14 @@ namespace eobsws::hardware {
     }
 
     bool AnalogPin::read(int * result) {
+        int forced = this->forced_value;
+        if (forced >= 0) {
+            *result = forced;
+            if (this->value == forced) return false;
+            this->value = static_cast<uint16_t>(forced);
+            input::trace::stamp(input::trace::Stage::Read);
+            return true;
+        }
         if (this->adc_unit == ADC_UNIT_1) {
             adc1_config_width(this->adc_width);
             adc1_config_channel_atten((adc1_channel_t)this->adc_channel, this->adc_atten);
@@ -115,4 +124,8 @@ namespace eobsws::hardware {
         return this->value;
     }
 
+    void AnalogPin::force_value(int value) {
+        this->forced_value = value;
+    }
+
 }
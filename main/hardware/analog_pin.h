@@ -7,6 +7,7 @@
 #pragma once
 #include <driver/gpio.h>
 #include <driver/adc.h>
+#include <atomic>
 
 /** \namespace eobsws::hardware
  *  \brief Hardware drivers.
@@ -64,6 +65,11 @@ namespace eobsws::hardware {
        */
       bool initialized = false;    
 
+      /** \property std::atomic<int> forced_value
+       *  \brief Value reported instead of measurements, or -1 to report measurements.
+       */
+      std::atomic<int> forced_value = -1;
+
   public:
       /** \fn AnalogPin()
         *  \brief Constructor.
@@ -129,6 +135,14 @@ namespace eobsws::hardware {
         *  \returns last valid measurement, or 0 if none is stored.
         */
       uint16_t get_value();
+
+      /** \fn void force_value(int value)
+        *  \brief Report given value instead of measurements, as if pin read it; a forced
+        *         value counts as changed whenever it differs from previous one, regardless
+        *         of tolerance.
+        *  \param value: raw value to report, or -1 to go back to measurements.
+        */
+      void force_value(int value);
   };
 
 }
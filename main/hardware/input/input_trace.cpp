@@ -0,0 +1,76 @@
+/** \file input_trace.cpp
+ *  \brief Implementation file for input latency tracing.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "input_trace.h"
+
+#if CONFIG_INPUT_INJECTION
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include <mutex>
+
+namespace eobsws::hardware::input::trace {
+
+    /** \var static constexpr size_t StageCount
+     *  \brief Number of traced stages.
+     */
+    static constexpr size_t StageCount = static_cast<size_t>(Stage::Count);
+
+    /** \var static int64_t stamps[StageCount]
+     *  \brief Time at which traced event reached each stage, in microseconds since boot
+     *  (0 if not reached).
+     */
+    static int64_t stamps[StageCount] = {};
+
+    /** \var static TaskHandle_t reader
+     *  \brief Task that read traced event (nullptr if not read yet).
+     */
+    static TaskHandle_t reader = nullptr;
+
+    /** \var static std::mutex stamps_mtx
+     *  \brief Mutex guarding stamps; stages are reached by different tasks.
+     */
+    static std::mutex stamps_mtx;
+
+    void start() {
+        std::lock_guard<std::mutex> lock(stamps_mtx);
+        for (auto & t: stamps) t = 0;
+        reader = nullptr;
+        stamps[static_cast<size_t>(Stage::Injected)] = esp_timer_get_time();
+    }
+
+    void stamp(Stage stage) {
+        auto now = esp_timer_get_time();
+        std::lock_guard<std::mutex> lock(stamps_mtx);
+        auto & t = stamps[static_cast<size_t>(stage)];
+        if (stamps[static_cast<size_t>(Stage::Injected)] != 0 && t == 0) {
+            t = now;
+            if (stage == Stage::Read)
+                reader = xTaskGetCurrentTaskHandle();
+        }
+    }
+
+    bool get_delays(int32_t * delays) {
+        std::lock_guard<std::mutex> lock(stamps_mtx);
+        auto t0 = stamps[static_cast<size_t>(Stage::Injected)];
+        if (t0 == 0) return false;
+        for (size_t n=1; n<StageCount; n++)
+            delays[n-1] = stamps[n] != 0 ? static_cast<int32_t>(stamps[n] - t0) : -1;
+        return true;
+    }
+
+    bool claim() {
+        auto now = esp_timer_get_time();
+        std::lock_guard<std::mutex> lock(stamps_mtx);
+        auto & t = stamps[static_cast<size_t>(Stage::Queued)];
+        if (reader == nullptr || t != 0 || xTaskGetCurrentTaskHandle() != reader)
+            return false;
+        t = now;
+        return true;
+    }
+
+}
+#endif
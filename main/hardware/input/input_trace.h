@@ -0,0 +1,67 @@
+/** \file input_trace.h
+ *  \brief Header file for input latency tracing. Injecting an input event over serial
+ *  link arms the trace; stages that the event goes through, until a WebSocket pipe sends
+ *  the resulting message, then record when they were first reached. The resulting message
+ *  is the first one queued by the task that read the event, so that messages from other
+ *  tasks can't pass for it. A single event is
+ *  traced at a time, so benchmarks wait for a message to be sent before injecting the
+ *  next event. Without CONFIG_INPUT_INJECTION, tracing functions do nothing.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#pragma once
+#include "sdkconfig.h"
+#include <cstdint>
+
+/** \namespace eobsws::hardware::input::trace
+ *  \brief Input latency tracing.
+ */
+namespace eobsws::hardware::input::trace {
+
+  /** \enum Stage
+   *  \brief Stages of an input event.
+   */
+  enum class Stage : uint8_t {
+    Injected, ///< event injected with a serial command
+    Read, ///< event read by input driver (LVGL touchpad callback or potentiometer polling)
+    Queued, ///< resulting message queued by a WebSocket pipe
+    Sent, ///< resulting message sent by a WebSocket pipe
+    Count ///< number of stages
+  };
+
+#if CONFIG_INPUT_INJECTION
+  /** \fn void start()
+   *  \brief Start tracing a new event; previous stamps are dropped.
+   */
+  void start();
+
+  /** \fn void stamp(Stage stage)
+   *  \brief Record time at which traced event reached given stage. Only the first
+   *  time is kept, and nothing is recorded if no event is traced.
+   *  \param stage: reached stage.
+   */
+  void stamp(Stage stage);
+
+  /** \fn bool get_delays(int32_t * delays)
+   *  \brief Get delays between injection of traced event and the following stages.
+   *  \param delays: array receiving delay of each stage after Injected, in microseconds,
+   *  or -1 for stages not reached.
+   *  \returns true if an event was traced, false otherwise.
+   */
+  bool get_delays(int32_t * delays);
+
+  /** \fn bool claim()
+   *  \brief Tell if a message being queued results from traced event, i.e. if it is the
+   *  first one queued by the task that read the event; Queued stage is then recorded.
+   *  \returns true if message results from traced event, false otherwise.
+   */
+  bool claim();
+#else
+  inline void start() {}
+  inline void stamp(Stage stage) {}
+  inline bool get_delays(int32_t * delays) { return false; }
+  inline bool claim() { return false; }
+#endif
+
+}
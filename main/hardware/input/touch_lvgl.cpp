@@ -5,13 +5,35 @@
  *  License: MIT
  */
 #include "touch_lvgl.h"
+#include "input_trace.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 namespace eobsws::hardware::input {
 
     TouchpadLVGL::TouchpadLVGL(std::shared_ptr<TouchPanel> device) : device(device) {}
 
+    void TouchpadLVGL::inject(uint16_t x, uint16_t y, uint32_t duration) {
+        this->injected_point = (static_cast<uint32_t>(x) << 16) | y;
+        this->injected_until = static_cast<uint32_t>(esp_timer_get_time()/1000) + duration;
+        this->injecting = true;
+    }
+
     void TouchpadLVGL::read(lv_indev_data_t * data) {
+        // an injected event takes precedence over device until it is released
+        if (this->injecting) {
+            uint32_t now = esp_timer_get_time()/1000;
+            if (static_cast<int32_t>(this->injected_until - now) > 0) {
+                uint32_t point = this->injected_point;
+                data->point.x = point >> 16;
+                data->point.y = point & 0xffff;
+                data->state = LV_INDEV_STATE_PRESSED;
+                data->continue_reading = false;
+                trace::stamp(trace::Stage::Read);
+                return;
+            }
+            this->injecting = false;
+        }
         if (this->device->get_touch_occurred()) {
             uint16_t tp_data[3];
             this->device->get_data(tp_data);
@@ -8,6 +8,7 @@
 
 #include "touch.h"
 #include "lvglpp/core/indev.h"
+#include <atomic>
 
 namespace eobsws::hardware::input {
 
@@ -16,6 +17,21 @@ namespace eobsws::hardware::input {
      */
     class TouchpadLVGL : public lvgl::core::PointerInputDevice {
     private:
+        /** \property std::atomic<uint32_t> injected_point
+         *  \brief Position of injected touch event (X in upper 16 bits, Y in lower 16 bits).
+         */
+        std::atomic<uint32_t> injected_point = 0;
+
+        /** \property std::atomic<uint32_t> injected_until
+         *  \brief Time at which injected touch event ends, in milliseconds since boot.
+         */
+        std::atomic<uint32_t> injected_until = 0;
+
+        /** \property std::atomic<bool> injecting
+         *  \brief True while an injected touch event is pressed.
+         */
+        std::atomic<bool> injecting = false;
+
         /** \fn void read(lv_indev_data_t * data) override
          *  \brief Callback for LVGL driver to read touchpad data.
          *  \param data: pointer to the LVGL-provided data recipient.
@@ -34,5 +50,15 @@ namespace eobsws::hardware::input {
          */
         TouchpadLVGL(std::shared_ptr<TouchPanel> device);
 
+        /** \fn void inject(uint16_t x, uint16_t y, uint32_t duration)
+         *  \brief Inject a touch event, reported to LVGL as if it came from device. It
+         *  replaces any injected event still pressed.
+         *  \param x: X position, in screen coordinates.
+         *  \param y: Y position, in screen coordinates.
+         *  \param duration: time during which position is pressed, in milliseconds; it
+         *  must exceed LVGL input read period for event to be seen.
+         */
+        void inject(uint16_t x, uint16_t y, uint32_t duration);
+
     };
 }
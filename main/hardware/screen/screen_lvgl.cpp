@@ -6,6 +6,13 @@
  */
 #include "screen_lvgl.h"
 #include "esp_log.h"
+#include <cstring>
+#include <mutex>
+
+/** \var std::mutex mtx
+ *  \brief Global mutex guarding LVGL, held by display task while it redraws and flushes.
+ */
+extern std::mutex mtx;
 
 namespace eobsws::hardware::screen {
     ScreenLVGL::ScreenLVGL(std::shared_ptr<Screen> screen)
@@ -13,8 +20,51 @@ namespace eobsws::hardware::screen {
         this->screen = screen;
     }
 
+    bool ScreenLVGL::start_capture(uint32_t * buffer) {
+        // redraw is requested under lock, so that no flush comes between arming and redraw
+        std::lock_guard<std::mutex> guard(mtx);
+        uint32_t * expected = nullptr;
+        if (!this->capture_buffer.compare_exchange_strong(expected, buffer)) return false;
+        this->captured_pixels = 0;
+        lv_obj_invalidate(lv_disp_get_scr_act(this->raw_ptr()));
+        return true;
+    }
+
+
+    bool ScreenLVGL::is_capture_complete() const {
+        return this->captured_pixels >= static_cast<size_t>(this->screen->get_screen_width())*this->screen->get_screen_height();
+    }
+
+
+    void ScreenLVGL::stop_capture() {
+        // flushes happen under lock: none is running once lock is acquired
+        std::lock_guard<std::mutex> guard(mtx);
+        this->capture_buffer = nullptr;
+    }
+
+
+    void ScreenLVGL::capture_area(const lv_area_t * area, const lv_color_t * color_map, uint32_t * buffer) {
+        auto width = this->screen->get_screen_width();
+        size_t area_width = area->x2 - area->x1 + 1;
+        for (auto y = area->y1; y <= area->y2; y++) {
+            auto src = color_map + (y - area->y1)*area_width;
+            auto dst = buffer + y*width + area->x1;
+        #if LV_COLOR_DEPTH == 32
+            memcpy(dst, src, area_width*sizeof(uint32_t));
+        #else
+            for (size_t x = 0; x < area_width; x++)
+                dst[x] = lv_color_to32(src[x]);
+        #endif
+        }
+        this->captured_pixels += area_width*(area->y2 - area->y1 + 1);
+    }
+
+
     void ScreenLVGL::flush(const lv_area_t * area,  lv_color_t * color_map) {
         ESP_LOGI("LVGL::Screen", "flush started...");
+        // a running capture gets a copy of the area before it goes to the screen
+        if (auto buffer = this->capture_buffer.load(); buffer != nullptr)
+            this->capture_area(area, color_map, buffer);
     #if LV_COLOR_DEPTH == 32
         // if LVGL is configured to work with RGBA8888 data, buffer is already in the right format
         this->screen->paint_area(area->x1, area->y1, area->x2, area->y2, (uint32_t*)color_map);
@@ -8,6 +8,8 @@
 #include "lvglpp/core/display.h"
 #include "lvglpp/misc/color.h"
 #include "screen.h"
+#include <atomic>
+#include <memory>
 
 namespace eobsws::hardware::screen {
 
@@ -16,6 +18,24 @@ namespace eobsws::hardware::screen {
      */
     class ScreenLVGL : public lvgl::core::Display {
     private:
+        /** \property std::atomic<uint32_t*> capture_buffer
+         *  \brief Buffer receiving a copy of flushed areas while a capture runs (nullptr otherwise).
+         */
+        std::atomic<uint32_t*> capture_buffer = nullptr;
+
+        /** \property std::atomic<size_t> captured_pixels
+         *  \brief Number of pixels copied since capture started.
+         */
+        std::atomic<size_t> captured_pixels = 0;
+
+        /** \fn void capture_area(const lv_area_t * area, const lv_color_t * color_map, uint32_t * buffer)
+         *  \brief Copy flushed area to capture buffer.
+         *  \param area: display area being flushed.
+         *  \param color_map: data flushed to display.
+         *  \param buffer: capture buffer.
+         */
+        void capture_area(const lv_area_t * area, const lv_color_t * color_map, uint32_t * buffer);
+
         /** \fn void flush(const lv_area_t * area, lv_color_t * color_map)
          *  \brief Flush data to screen in the specified area.
          *  \param area: display area over which to flush given data
@@ -35,6 +55,26 @@ namespace eobsws::hardware::screen {
          */
         ScreenLVGL(std::shared_ptr<Screen> screen);
 
+        /** \fn bool start_capture(uint32_t * buffer)
+         *  \brief Start capturing a frame: whole screen is redrawn, and flushed areas are
+         *  copied to given buffer on their way to the screen, so that display task isn't
+         *  held up longer than the redraw. Must be called without holding GUI lock.
+         *  \param buffer: buffer receiving frame, holding screen width x height pixels (XRGB8888).
+         *  \returns true if capture started, false if another one runs.
+         */
+        bool start_capture(uint32_t * buffer);
+
+        /** \fn bool is_capture_complete() const
+         *  \brief Tell if every pixel of screen was captured.
+         *  \returns true if capture is complete, false otherwise.
+         */
+        bool is_capture_complete() const;
+
+        /** \fn void stop_capture()
+         *  \brief Stop capture; buffer isn't written anymore once this returns.
+         */
+        void stop_capture();
+
     };
 
 }
@@ -93,7 +93,7 @@ namespace eobsws::impl {
 
 
     void calibrate_potentiometers(
-        std::vector<std::unique_ptr<hardware::AnalogPin>> & pins,
+        std::vector<std::shared_ptr<hardware::AnalogPin>> & pins,
         std::shared_ptr<storage::NVStorage> nvs) {
         using namespace lvgl::widgets;
         using namespace lvgl::core;
@@ -174,10 +174,11 @@ namespace eobsws::impl {
         a->set_playback_time(0);
         a->start();
         vTaskDelay(500/portTICK_PERIOD_MS);
-        // clean up
+        // clean up; interface gets drawn next, on default background
         mtx.lock();
         a = nullptr;
         cont = nullptr;
+        root.set_style_bg_color(palette::black(), LV_PART_MAIN);
         mtx.unlock();
     }
 
@@ -23,7 +23,7 @@ namespace eobsws::impl {
      */
     void calibrate_touch(hardware::input::ResistiveTouchPanel & touch, std::shared_ptr<storage::NVStorage> nvs);
 
-    /** \fn void calibrate_potentiometers(std::vector<std::unique_ptr<hardware::AnalogPin>> & pins, std::shared_ptr<storage::NVStorage> nvs)
+    /** \fn void calibrate_potentiometers(std::vector<std::shared_ptr<hardware::AnalogPin>> & pins, std::shared_ptr<storage::NVStorage> nvs)
      *  \brief Starts potentiometers calibration procedure. This requires a calibrated screen.
      * 
      *  This asks the user to first set potentiometers to minimum, then to maximum.
@@ -31,5 +31,5 @@ namespace eobsws::impl {
      *  \param pins: a vector containing pointers to two analog pin drivers.
      *  \param nvs: pointer to a non-volatile storage accessor.
      */
-    void calibrate_potentiometers(std::vector<std::unique_ptr<hardware::AnalogPin>> & pins, std::shared_ptr<storage::NVStorage> nvs);
+    void calibrate_potentiometers(std::vector<std::shared_ptr<hardware::AnalogPin>> & pins, std::shared_ptr<storage::NVStorage> nvs);
 }
@@ -41,6 +41,75 @@ namespace eobsws::impl {
     }
 
 
+    void draw_button(std::shared_ptr<comm::DataBroker> db,
+                     std::shared_ptr<storage::SPIFlash> spiflash,
+                     const ButtonConfiguration & cfg, uint8_t n, GUIData & data) {
+        // transition parameters for click effect; shared by all buttons
+        if (data.lvgl_transitions.empty()) {
+            std::vector<lv_style_prop_t> props{
+                LV_STYLE_IMG_RECOLOR, LV_STYLE_IMG_RECOLOR_OPA, LV_STYLE_PROP_INV};
+            data.lvgl_transitions.push_back(std::make_shared<lvgl::misc::LinearStyleTransition>(props, 300, 0));
+        }
+        auto transition = data.lvgl_transitions.front();
+        // create button instance
+        std::shared_ptr<gui::widgets::ImageButtonPNG> btn;
+        if (cfg.type == ButtonType::ToggleButton) {
+            btn = std::make_shared<gui::widgets::ImageToggleButtonPNG>(*data.root);
+        } else {
+            btn = std::make_shared<gui::widgets::ImageButtonPNG>(*data.root);
+        }
+        // image for off state
+        auto img_bg_off = std::make_shared<gi::LvglDecorator<gi::ImagePNG>>(spiflash, cfg.image_off);
+        btn->set_src(gui::widgets::ImagePosition::Left, LV_IMGBTN_STATE_RELEASED, img_bg_off);
+        btn->set_src(gui::widgets::ImagePosition::Left, LV_IMGBTN_STATE_PRESSED, img_bg_off);
+        // for toggle button, set toggled-on image
+        if (cfg.type == ButtonType::ToggleButton) {
+            auto img_bg_on = std::make_shared<gi::LvglDecorator<gi::ImagePNG>>(spiflash, cfg.image_on);
+            btn->set_src(gui::widgets::ImagePosition::Left, LV_IMGBTN_STATE_CHECKED_RELEASED, img_bg_on);
+            btn->set_src(gui::widgets::ImagePosition::Left, LV_IMGBTN_STATE_CHECKED_PRESSED, img_bg_on);
+            btn->add_flag(LV_OBJ_FLAG_CHECKABLE);
+        }
+        // set button functions
+        // -> data broker in charge of processing events
+        btn->set_data_broker(db);
+        // -> on which channel, and to which OBS connections
+        btn->set_message_type(comm::MessageType::OutboundWireless | comm::target_mask(cfg.targets));
+        // -> event message(s)
+        if (cfg.type == ButtonType::ToggleButton) {
+            auto tgbtn = std::reinterpret_pointer_cast<gui::widgets::ImageToggleButtonPNG>(btn);
+            tgbtn->set_message_data(cfg.command_on, true);
+            tgbtn->set_message_data(cfg.command_off, false);
+            tgbtn->set_trigger(LV_EVENT_CLICKED);
+        } else {
+            btn->set_message_data(cfg.command_on);
+            btn->set_trigger(LV_EVENT_CLICKED);
+        }
+        // styling; buttons are 100x100 pixels, on 2 rows of 3
+        btn->set_size(100, 100);
+        // we keep a 5px horizontal gap and a 4px vertical gap
+        btn->set_pos(5+105*(n%3),4+104*(n/3));
+        // released style
+        auto released_style = std::make_shared<lvgl::misc::Style>();
+        // set transition profile
+        released_style->set_transition(*transition);
+        // pressed style with configured color
+        auto pressed_style = std::make_shared<lvgl::misc::Style>();
+        pressed_style->set_img_recolor_opa(cfg.event_opacity);
+        pressed_style->set_img_recolor(cfg.event_color);
+        pressed_style->set_transition(*transition);
+        // apply style to button pressed state
+        btn->add_style(*released_style, LV_STATE_DEFAULT);
+        btn->add_style(*pressed_style, LV_STATE_PRESSED);
+        // store button and its styles; a replaced button is deleted before its styles
+        if (n >= data.buttons.size()) {
+            data.buttons.resize(n+1);
+            data.button_styles.resize(n+1);
+        }
+        data.buttons[n] = std::move(btn);
+        data.button_styles[n] = {released_style, pressed_style};
+    }
+
+
     void draw_buttons(std::shared_ptr<comm::DataBroker> db,
                       std::shared_ptr<storage::SPIFlash> spiflash,
                       std::vector<ButtonConfiguration> & cfgs, GUIData & data) {
@@ -54,100 +123,47 @@ namespace eobsws::impl {
          *               this is the only command necessary.
          *  command_off = command triggered when toggled off (only for toggle buttons).
          */
-        // transition parameters for click effect
-        std::vector<lv_style_prop_t> props{
-            LV_STYLE_IMG_RECOLOR, LV_STYLE_IMG_RECOLOR_OPA, LV_STYLE_PROP_INV};
-        auto transition = std::make_shared<lvgl::misc::LinearStyleTransition>(props, 300, 0);
-        data.lvgl_transitions.push_back(transition);
-        // create buttons
-        for (uint8_t ny=0; ny<2; ny++) {
-            for (uint8_t nx=0; nx<3; nx++) {
-                uint8_t n = ny*3 + nx;
-                // create button instance
-                std::shared_ptr<gui::widgets::ImageButtonPNG> btn;
-                if (cfgs[n].type == ButtonType::PushButton) {
-                    btn = std::make_shared<gui::widgets::ImageButtonPNG>(*data.root);
-                } else if (cfgs[n].type == ButtonType::ToggleButton) {
-                    btn = std::make_shared<gui::widgets::ImageToggleButtonPNG>(*data.root);
-                }
-                // image for off state
-                auto img_bg_off = std::make_shared<gi::LvglDecorator<gi::ImagePNG>>(spiflash, cfgs[n].image_off);
-                btn->set_src(gui::widgets::ImagePosition::Left, LV_IMGBTN_STATE_RELEASED, img_bg_off);
-                btn->set_src(gui::widgets::ImagePosition::Left, LV_IMGBTN_STATE_PRESSED, img_bg_off);
-                // for toggle button, set toggled-on image
-                if (cfgs[n].type == ButtonType::ToggleButton) {
-                    auto img_bg_on = std::make_shared<gi::LvglDecorator<gi::ImagePNG>>(spiflash, cfgs[n].image_on);
-                    btn->set_src(gui::widgets::ImagePosition::Left, LV_IMGBTN_STATE_CHECKED_RELEASED, img_bg_on);
-                    btn->set_src(gui::widgets::ImagePosition::Left, LV_IMGBTN_STATE_CHECKED_PRESSED, img_bg_on);
-                    btn->add_flag(LV_OBJ_FLAG_CHECKABLE);
-                }
-                // set button functions
-                // -> data broker in charge of processing events
-                btn->set_data_broker(db);
-                // -> on which channel
-                btn->set_message_type(comm::MessageType::OutboundWireless);
-                // -> event message(s)
-                if (cfgs[n].type == ButtonType::ToggleButton) {
-                    auto tgbtn = std::reinterpret_pointer_cast<gui::widgets::ImageToggleButtonPNG>(btn);
-                    tgbtn->set_message_data(cfgs[n].command_on, true);
-                    tgbtn->set_message_data(cfgs[n].command_off, false);
-                    tgbtn->set_trigger(LV_EVENT_CLICKED);
-                } else {
-                    btn->set_message_data(cfgs[n].command_on);
-                    btn->set_trigger(LV_EVENT_CLICKED);
-                }
-                // styling; buttons are 100x100 pixels
-                btn->set_size(100, 100);
-                // we keep a 5px horizontal gap and a 4px vertical gap
-                btn->set_pos(5+105*nx,4+104*ny);
-                // released style
-                auto released_style = std::make_shared<lvgl::misc::Style>(); 
-                // set transition profile 
-                released_style->set_transition(*transition);
-                // pressed style with configured color
-                auto pressed_style = std::make_shared<lvgl::misc::Style>();
-                pressed_style->set_img_recolor_opa(cfgs[n].event_opacity);
-                pressed_style->set_img_recolor(cfgs[n].event_color);
-                pressed_style->set_transition(*transition);
-                // store styles in storage
-                data.lvgl_styles.push_back(released_style);
-                data.lvgl_styles.push_back(pressed_style);
-                // apply style to button pressed state
-                btn->add_style(*released_style, LV_STATE_DEFAULT);
-                btn->add_style(*pressed_style, LV_STATE_PRESSED);
-                // store button
-                data.buttons.push_back(std::move(btn));
-            }
+        for (uint8_t n=0; n<6; n++)
+            draw_button(db, spiflash, cfgs[n], n, data);
+    }
+
+
+    void draw_bar(const Configuration & cfg, uint8_t n, GUIData & data) {
+        auto bar = std::make_unique<lvgl::widgets::Bar>(*data.root);
+        // set bar range
+        bar->set_range(cfg.pots[n].raw_min, cfg.pots[n].raw_max);
+        // set position and size
+        bar->set_size(130, 20);
+        bar->set_pos(5 + 135*n, 215);
+        // background style
+        auto bg_style = std::make_shared<lvgl::misc::Style>();
+        bg_style->set_bg_color(cfg.pots[n].bg_color);
+        bg_style->set_bg_opa(cfg.pots[n].bg_opacity);
+        bar->add_style(*bg_style.get(), LV_PART_MAIN);
+        // foreground style
+        auto fg_style = std::make_shared<lvgl::misc::Style>();
+        fg_style->set_bg_color(cfg.pots[n].fg_color);
+        fg_style->set_bg_opa(cfg.pots[n].fg_opacity);
+        bar->add_style(*fg_style, LV_PART_INDICATOR);
+        // store bar and its styles; a replaced bar hands its value over
+        if (n >= data.bars.size()) {
+            data.bars.resize(n+1);
+            data.bar_styles.resize(n+1);
+        } else if (data.bars[n] != nullptr) {
+            bar->set_value(data.bars[n]->get_value(), LV_ANIM_OFF);
         }
+        data.bars[n] = std::move(bar);
+        data.bar_styles[n] = {bg_style, fg_style};
     }
 
 
     void draw_bars(Configuration & cfg, GUIData & data) {
-        for (uint8_t n=0; n<2; n++) {
-            auto idx_str = std::to_string(n);
-            data.bars.emplace_back(std::make_unique<lvgl::widgets::Bar>(*data.root));
-            // set bar range
-            data.bars[n]->set_range(cfg.pots[n].raw_min, cfg.pots[n].raw_max);
-            // set position and size
-            data.bars[n]->set_size(130, 20);
-            data.bars[n]->set_pos(5 + 135*n, 215);
-            // background style
-            auto bg_style = std::make_shared<lvgl::misc::Style>();
-            bg_style->set_bg_color(cfg.pots[n].bg_color);
-            bg_style->set_bg_opa(cfg.pots[n].bg_opacity);
-            data.bars[n]->add_style(*bg_style.get(), LV_PART_MAIN);
-            data.lvgl_styles.push_back(bg_style);
-            // foreground style
-            auto fg_style = std::make_shared<lvgl::misc::Style>();
-            fg_style->set_bg_color(cfg.pots[n].fg_color);
-            fg_style->set_bg_opa(cfg.pots[n].fg_opacity);
-            data.bars[n]->add_style(*fg_style, LV_PART_INDICATOR);
-            data.lvgl_styles.push_back(fg_style);
-        }
+        for (uint8_t n=0; n<2; n++)
+            draw_bar(cfg, n, data);
     }
 
 
-    void draw_wifi_icon(GUIData & data, int8_t rssi) {
+    void draw_wifi_icon(GUIData & data, int8_t rssi, uint32_t rtt) {
         // choose icon based on RSSI value
         uint8_t idx = 0; // by default, no connection
         if (rssi >= -90 && rssi < -70) {
@@ -160,6 +176,14 @@ namespace eobsws::impl {
             // good
             idx = 3;
         }
+        // a down or slow link is shown as such, whatever the signal strength
+        if (rtt == UINT32_MAX) {
+            idx = 0;
+        } else if (rtt > 300000) {
+            idx = std::min<uint8_t>(idx, 1);
+        } else if (rtt > 100000) {
+            idx = std::min<uint8_t>(idx, 2);
+        }
         std::lock_guard<std::mutex> guard(mtx);
         data.wifi_icon->set_src(data.wifi_imgs[idx]);
     }
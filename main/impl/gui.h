@@ -23,6 +23,20 @@ namespace eobsws::impl {
      */
     void load_battery_icons(std::shared_ptr<storage::SPIFlash> spiflash, GUIData & data);
 
+    /** \fn void draw_button(std::shared_ptr<comm::DataBroker> db,
+     *                       std::shared_ptr<storage::SPIFlash> spiflash,
+     *                       const ButtonConfiguration & cfg, uint8_t n, GUIData & data)
+     *  \brief Draw a button, replacing the one drawn before at the same place, if any.
+     *  \param db: data broker assigned to button to issue commands.
+     *  \param spiflash: pointer to a flash storage partition containing image files.
+     *  \param cfg: button configuration.
+     *  \param n: button index (0 to 5).
+     *  \param data: storage object for GUI data.
+     */
+    void draw_button(std::shared_ptr<comm::DataBroker> db,
+                     std::shared_ptr<storage::SPIFlash> spiflash,
+                     const ButtonConfiguration & cfg, uint8_t n, GUIData & data);
+
     /** \fn void draw_buttons(std::shared_ptr<comm::DataBroker> db,
      *                        std::shared_ptr<storage::SPIFlash> spiflash,
      *                        std::vector<ButtonConfiguration> & cfgs, GUIData & data);
@@ -36,6 +50,14 @@ namespace eobsws::impl {
                       std::shared_ptr<storage::SPIFlash> spiflash,
                       std::vector<ButtonConfiguration> & cfgs, GUIData & data);
 
+    /** \fn void draw_bar(const Configuration & cfg, uint8_t n, GUIData & data)
+     *  \brief Draws an indicator bar, replacing the one drawn before at the same place, if any.
+     *  \param cfg: configuration storage instance.
+     *  \param n: bar index (0 or 1).
+     *  \param data: storage object for GUI data.
+     */
+    void draw_bar(const Configuration & cfg, uint8_t n, GUIData & data);
+
     /** \fn void draw_bars(Configuration & cfg, GUIData & data)
      *  \brief Draws indicator bars.
      *  \param cfg: configuration storage instance.
@@ -43,12 +65,13 @@ namespace eobsws::impl {
      */
     void draw_bars(Configuration & cfg, GUIData & data);
 
-    /** \fn void draw_wifi_icon(GUIData & data, int8_t rssi)
-     *  \brief Draws WiFi indicator icon for given RSSI value.
+    /** \fn void draw_wifi_icon(GUIData & data, int8_t rssi, uint32_t rtt)
+     *  \brief Draws WiFi indicator icon for given RSSI value and link round-trip time.
      *  \param data: storage object for GUI data.
      *  \param rssi: WiFi RSSI value.
+     *  \param rtt: link round-trip time in microseconds (0 if unknown, UINT32_MAX if link is down).
      */
-    void draw_wifi_icon(GUIData & data, int8_t rssi);
+    void draw_wifi_icon(GUIData & data, int8_t rssi, uint32_t rtt = 0);
 
     /** \fn void draw_battery_icon(GUIData & data, uint8_t value, bool charging)
      *  \brief Draws battery level indicator icon for given value.
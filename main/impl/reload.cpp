@@ -0,0 +1,130 @@
+/** \file reload.cpp
+ *  \brief Implementation file for configuration reload routines.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "reload.h"
+#include "gui.h"
+#include "hardware/screen/st7789vi.h"
+#include "hardware/input/res_touch.h"
+#include "esp_log.h"
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+extern std::mutex mtx;
+
+namespace eobsws::impl {
+
+    ConfigWatcher::ConfigWatcher(std::shared_ptr<comm::DataBroker> db) : DataNode(db) {
+        this->in_message_type = comm::MessageType::ConfigChanged;
+        this->db->subscribe(this->convert_callback<ConfigWatcher>(this));
+    }
+
+
+    bool ConfigWatcher::publish_callback(comm::MessageType t, const std::string & data) {
+        if (!comm::accepts(this->in_message_type, t)) return false;
+        std::lock_guard<std::mutex> guard(this->changes_mtx);
+        if (std::find(this->changes.begin(), this->changes.end(), data) == this->changes.end())
+            this->changes.push_back(data);
+        return true;
+    }
+
+
+    std::vector<std::string> ConfigWatcher::take_changes() {
+        std::lock_guard<std::mutex> guard(this->changes_mtx);
+        return std::exchange(this->changes, std::vector<std::string>());
+    }
+
+
+    /** \fn static bool uses_file(const ButtonConfiguration & bcfg, const std::vector<std::string> & changes)
+     *  \brief Tell if one of the changed files is an image of a button.
+     *  \param bcfg: button configuration.
+     *  \param changes: changed NVS namespaces and file paths.
+     *  \returns true if button shows one of the files, false otherwise.
+     */
+    static bool uses_file(const ButtonConfiguration & bcfg, const std::vector<std::string> & changes) {
+        // paths may be given with or without leading slash
+        auto strip = [](std::string_view path) {
+            path.remove_prefix(std::min(path.find_first_not_of('/'), path.size()));
+            return path;
+        };
+        for (auto & change: changes) {
+            auto path = strip(change);
+            if (path.empty()) continue;
+            if (path == strip(bcfg.image_off)
+                || (bcfg.type == ButtonType::ToggleButton && path == strip(bcfg.image_on)))
+                return true;
+        }
+        return false;
+    }
+
+
+    void reload_config(std::shared_ptr<comm::DataBroker> db,
+                       std::shared_ptr<storage::NVStorage> nvs,
+                       std::shared_ptr<storage::SPIFlash> spiflash,
+                       const std::vector<std::string> & changes,
+                       Configuration & cfg, std::vector<ButtonConfiguration> & bcfgs,
+                       GUIData & gdata,
+                       std::shared_ptr<hardware::screen::ScreenLVGL> tft,
+                       std::shared_ptr<hardware::input::TouchpadLVGL> touch) {
+        // NVS reads are cheap: everything is read again and compared with live settings
+        auto new_cfg = Configuration(nvs);
+        std::vector<ButtonConfiguration> new_bcfgs;
+        new_bcfgs.reserve(bcfgs.size());
+        for (uint8_t n=0; n<bcfgs.size(); n++)
+            new_bcfgs.emplace_back(ButtonConfiguration(nvs, n));
+
+        mtx.lock();
+        // buttons whose settings or images changed
+        for (uint8_t n=0; n<bcfgs.size(); n++) {
+            if (new_bcfgs[n] == bcfgs[n] && !uses_file(new_bcfgs[n], changes)) continue;
+            ESP_LOGI("ConfigReload", "Redrawing button %d.", n);
+            draw_button(db, spiflash, new_bcfgs[n], n, gdata);
+        }
+        // bars whose appearance changed; values and commands are taken as they are
+        for (uint8_t n=0; n<cfg.pots.size() && n<new_cfg.pots.size(); n++) {
+            if (new_cfg.pots[n].same_bar(cfg.pots[n])) continue;
+            ESP_LOGI("ConfigReload", "Redrawing bar %d.", n);
+            draw_bar(new_cfg, n, gdata);
+        }
+        // screen background
+        if (lv_color_to32(new_cfg.screen_color) != lv_color_to32(cfg.screen_color))
+            gdata.root->set_style_bg_color(new_cfg.screen_color, LV_PART_MAIN);
+        mtx.unlock();
+
+        // touch panel calibration
+        auto tdev = std::dynamic_pointer_cast<hardware::input::ResistiveTouchPanel>(touch->device);
+        if (tdev != nullptr) {
+            tdev->set_scale(new_cfg.touch_scaling_x, new_cfg.touch_scaling_y);
+            tdev->set_offset(new_cfg.touch_offset_x, new_cfg.touch_offset_y);
+        }
+        // backlight; screen is woken up so that new level shows
+        if (new_cfg.bl_lvl_act != cfg.bl_lvl_act || new_cfg.bl_lvl_dimmed != cfg.bl_lvl_dimmed
+            || new_cfg.bl_dim_delay != cfg.bl_dim_delay) {
+            std::dynamic_pointer_cast<hardware::screen::ST7789VI_TFT>(tft->screen)->set_backlight_level(new_cfg.bl_lvl_act, 100);
+            tft->trig_activity();
+        }
+        if (!new_cfg.same_connections(cfg) || new_cfg.screen_orientation != cfg.screen_orientation)
+            ESP_LOGI("ConfigReload", "Connection settings and screen orientation apply at next restart.");
+        if ((cfg.touch_calibrated && !new_cfg.touch_calibrated) || (cfg.pots_calibrated && !new_cfg.pots_calibrated))
+            ESP_LOGI("ConfigReload", "Calibration runs at next restart.");
+
+        // live settings are updated, except those kept until next restart
+        new_cfg.storage_part_name = std::move(cfg.storage_part_name);
+        new_cfg.wifi_ssid = std::move(cfg.wifi_ssid);
+        new_cfg.wifi_password = std::move(cfg.wifi_password);
+        new_cfg.wifi_static_ip = std::move(cfg.wifi_static_ip);
+        new_cfg.wifi_netmask = std::move(cfg.wifi_netmask);
+        new_cfg.wifi_gateway = std::move(cfg.wifi_gateway);
+        new_cfg.wifi_dns = std::move(cfg.wifi_dns);
+        new_cfg.http_token = std::move(cfg.http_token);
+        new_cfg.websockets = std::move(cfg.websockets);
+        new_cfg.screen_orientation = cfg.screen_orientation;
+        cfg = std::move(new_cfg);
+        bcfgs = std::move(new_bcfgs);
+    }
+
+}
@@ -0,0 +1,87 @@
+/** \file reload.h
+ *  \brief Header file for configuration reload routines.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#pragma once
+#include "comm/data_node.h"
+#include "hardware/screen/screen_lvgl.h"
+#include "hardware/input/touch_lvgl.h"
+#include "types.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eobsws::impl {
+
+    /** \class ConfigWatcher
+     *  \brief Collects configuration change notifications issued on data broker,
+     *  so that main task can apply them when it sees fit.
+     */
+    class ConfigWatcher : public comm::DataNode {
+    private:
+        /** \property std::mutex changes_mtx
+         *  \brief Mutex protecting list of changes.
+         */
+        std::mutex changes_mtx;
+
+        /** \property std::vector<std::string> changes
+         *  \brief Changes notified since last call to take_changes.
+         */
+        std::vector<std::string> changes;
+
+    public:
+        /** \fn ConfigWatcher(std::shared_ptr<comm::DataBroker> db)
+         *  \brief Constructor.
+         *  \param db: pointer to data broker to subscribe to.
+         */
+        ConfigWatcher(std::shared_ptr<comm::DataBroker> db);
+
+        /** \fn bool publish_callback(comm::MessageType t, const std::string & data)
+         *  \brief Callback for publish events from data broker.
+         *  \param t: message type.
+         *  \param data: changed NVS namespace, file path, or "*".
+         *  \returns true if change was recorded, false otherwise.
+         */
+        bool publish_callback(comm::MessageType t, const std::string & data);
+
+        /** \fn std::vector<std::string> take_changes()
+         *  \brief Get changes notified since last call, and forget them.
+         *  \returns list of changes (empty if none).
+         */
+        std::vector<std::string> take_changes();
+    };
+
+    /** \fn void reload_config(std::shared_ptr<comm::DataBroker> db,
+     *                         std::shared_ptr<storage::NVStorage> nvs,
+     *                         std::shared_ptr<storage::SPIFlash> spiflash,
+     *                         const std::vector<std::string> & changes,
+     *                         Configuration & cfg, std::vector<ButtonConfiguration> & bcfgs,
+     *                         GUIData & gdata,
+     *                         std::shared_ptr<hardware::screen::ScreenLVGL> tft,
+     *                         std::shared_ptr<hardware::input::TouchpadLVGL> touch)
+     *  \brief Read configuration again and apply differences with live one: only buttons
+     *  and bars whose settings or images changed are redrawn. Connection settings and
+     *  screen orientation are kept until next restart. Claims GUI lock.
+     *  \param db: data broker assigned to buttons to issue commands.
+     *  \param nvs: pointer to a non-volatile storage accessor.
+     *  \param spiflash: pointer to a flash storage partition containing image files.
+     *  \param changes: changed NVS namespaces and file paths, as given by ConfigWatcher.
+     *  \param cfg: live configuration; updated.
+     *  \param bcfgs: live buttons configuration; updated.
+     *  \param gdata: storage object for GUI data.
+     *  \param tft: screen driver.
+     *  \param touch: touch panel driver.
+     */
+    void reload_config(std::shared_ptr<comm::DataBroker> db,
+                       std::shared_ptr<storage::NVStorage> nvs,
+                       std::shared_ptr<storage::SPIFlash> spiflash,
+                       const std::vector<std::string> & changes,
+                       Configuration & cfg, std::vector<ButtonConfiguration> & bcfgs,
+                       GUIData & gdata,
+                       std::shared_ptr<hardware::screen::ScreenLVGL> tft,
+                       std::shared_ptr<hardware::input::TouchpadLVGL> touch);
+
+}
@@ -6,6 +6,7 @@
  */
 
 #include "setup.h"
+#include "storage/file.h"
 #include "esp_log.h"
 
 namespace eobsws::impl {
@@ -69,16 +70,16 @@ namespace eobsws::impl {
     }
 
 
-    std::vector< std::unique_ptr<hardware::AnalogPin> > setup_gpio() {
+    std::vector< std::shared_ptr<hardware::AnalogPin> > setup_gpio() {
         // configure analog GPIO pins
-        std::vector< std::unique_ptr<hardware::AnalogPin> > v;
+        std::vector< std::shared_ptr<hardware::AnalogPin> > v;
         constexpr gpio_num_t pins[]{
             static_cast<gpio_num_t>(CONFIG_PIN_POT_1),
             static_cast<gpio_num_t>(CONFIG_PIN_POT_2),
             static_cast<gpio_num_t>(CONFIG_PIN_BATT_MON)
             };
         for (auto pin: pins) {
-            auto pot = std::make_unique<hardware::AnalogPin>();
+            auto pot = std::make_shared<hardware::AnalogPin>();
             pot->set_pin(pin);
             pot->set_attenuation(ADC_ATTEN_6db);
             // set averaging with 10 measurements, and a tolerance of 10,
@@ -102,51 +103,137 @@ namespace eobsws::impl {
     void setup_uart(std::shared_ptr<comm::DataBroker> db,
                     std::shared_ptr<storage::NVStorage> nvs,
                     std::shared_ptr<storage::SPIFlash> spiflash,
+                    std::shared_ptr<hardware::screen::ScreenLVGL> screen,
+                    std::shared_ptr<hardware::input::TouchpadLVGL> touch,
+                    const std::vector< std::shared_ptr<hardware::AnalogPin> > & pots,
                     UARTData & udata) {
         // load UART handler blocks: pipe, parser with stubs
         namespace cps = comm::parser::serial;
         udata.uart_pipe = std::make_shared<comm::pipe::UARTPipe>(db);
+        udata.uart_pipe->set_flow_control_pins(CONFIG_UART_RTS_PIN, CONFIG_UART_CTS_PIN);
         udata.uart_parser = std::make_shared<comm::parser::SerialParser>(db);
         udata.uart_stubs.emplace_back(std::make_shared<cps::PutFileParserStub>(spiflash));
-        udata.uart_stubs.emplace_back(std::make_shared<cps::GetFileParserStub>(spiflash));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::GetFileParserStub>(spiflash, udata.uart_pipe));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::PutBinParserStub>(spiflash));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::GetBinParserStub>(spiflash));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::OTAParserStub>());
         udata.uart_stubs.emplace_back(std::make_shared<cps::DeleteFileParserStub>(spiflash));
         udata.uart_stubs.emplace_back(std::make_shared<cps::MakedirParserStub>(spiflash));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::HashFileParserStub>(spiflash));
         udata.uart_stubs.emplace_back(std::make_shared<cps::ListDirParserStub>(spiflash));
         udata.uart_stubs.emplace_back(std::make_shared<cps::SetConfigParserStub>(nvs));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::SetConfigBatchParserStub>(nvs));
         udata.uart_stubs.emplace_back(std::make_shared<cps::GetConfigParserStub>(nvs));
         udata.uart_stubs.emplace_back(std::make_shared<cps::DelConfigParserStub>(nvs));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::DumpConfigParserStub>(nvs, udata.uart_pipe));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::LoadConfigParserStub>(nvs));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::ReloadConfigParserStub>());
         udata.uart_stubs.emplace_back(std::make_shared<cps::GetBufSizeParserStub>());
         udata.uart_stubs.emplace_back(std::make_shared<cps::GetFirmwareVersionParserStub>());
+        udata.uart_stubs.emplace_back(std::make_shared<cps::SetBaudRateParserStub>(udata.uart_pipe));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::ConfirmBaudRateParserStub>(udata.uart_pipe));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::ScreenshotParserStub>(screen, udata.uart_pipe));
+        #if CONFIG_INPUT_INJECTION
+        udata.uart_stubs.emplace_back(std::make_shared<cps::TouchParserStub>(touch));
+        // last analog pin is battery monitor, whose value isn't sent anywhere
+        udata.uart_stubs.emplace_back(std::make_shared<cps::SetPotParserStub>(
+            std::vector< std::shared_ptr<hardware::AnalogPin> >(pots.begin(), pots.end() - 1)));
+        udata.uart_stubs.emplace_back(std::make_shared<cps::GetTraceParserStub>());
+        #endif
+        #if CONFIG_FILE_READ_BENCH
+        udata.uart_stubs.emplace_back(std::make_shared<cps::BenchImageParserStub>(spiflash));
+        #endif
         // register loaded stubs with parser
         for (auto & stub: udata.uart_stubs)
             udata.uart_parser->register_parser_stub(stub);
     }
 
 
-    void setup_websocket(std::shared_ptr<comm::DataBroker> db, const Configuration & cfg, OBSData & odata) {
-        // load obs-websocket handler blocks: pipe, parser with stubs
-        odata.ws_pipe = std::make_shared<comm::pipe::WebSocketPipe>(db,
-            cfg.wifi_ssid, cfg.wifi_password,
-            cfg.websocket_host, cfg.websocket_port, cfg.websocket_path);
-        odata.obs_parser = std::make_shared<comm::parser::OBSParser>(db);
+    void setup_websocket(std::shared_ptr<comm::DataBroker> db,
+                         std::shared_ptr<storage::NVStorage> nvs,
+                         std::shared_ptr<storage::SPIFlash> spiflash,
+                         const Configuration & cfg,
+                         OBSData & odata) {
+        // reply parser is shared by all connections
         odata.obs_reply_parser = std::make_shared<comm::parser::OBSReplyParser>(db);
-        odata.ws_stubs.emplace_back(std::make_shared<comm::parser::obs::OBSHello>(cfg.websocket_password));
-        odata.ws_stubs.emplace_back(std::make_shared<comm::parser::obs::OBSIdentified>());
-        odata.ws_stubs.emplace_back(std::make_shared<comm::parser::obs::OBSEvent>());
-        auto event_stub = odata.ws_stubs.back();
-        odata.ws_stubs.emplace_back(std::make_shared<comm::parser::obs::OBSRequestResponse>());
-        auto req_resp_stub = odata.ws_stubs.back();
-        odata.ws_stubs.emplace_back(std::make_shared<comm::parser::obs::OBSRequestBatchResponse>());
-        auto batch_req_resp_stub = odata.ws_stubs.back();
-        // register loaded stubs with parser
-        for (auto & stub: odata.ws_stubs)
-            odata.obs_parser->register_parser_stub(stub);
-        // set event parser stub to issue event messages
-        event_stub->set_message_type(comm::MessageType::Event);
-        // set response parser stubs to issue event messages; it could be set to something
-        // else but at this point I don't do anything with those
-        req_resp_stub->set_message_type(comm::MessageType::Event);
-        batch_req_resp_stub->set_message_type(comm::MessageType::Event);
+        // load obs-websocket handler blocks for each connection: pipe, parser with stubs;
+        // messages are tagged with connection index so that each session keeps its own
+        // handshake state and event stream
+        for (uint8_t n=0; n<cfg.websockets.size(); n++) {
+            auto & ws = cfg.websockets[n];
+            auto tag = comm::target_tag(n);
+            // tunneled connections have no pipe of their own; UART pipe carries them
+            if (ws.transport == Transport::WiFi) {
+                auto ws_pipe = std::make_shared<comm::pipe::WebSocketPipe>(db,
+                    cfg.wifi_ssid, cfg.wifi_password, ws.host, ws.port, ws.path);
+                ws_pipe->set_target(n);
+                // connection parameters get cached to speed up next connection
+                ws_pipe->set_cache(nvs);
+                ws_pipe->set_static_ip(cfg.wifi_static_ip, cfg.wifi_netmask, cfg.wifi_gateway, cfg.wifi_dns);
+                // for wss://, server certificate is read from flash storage
+                if (ws.tls) {
+                    storage::File cert_file(spiflash, ws.cert);
+                    std::string cert_pem;
+                    if (cert_file.open("r")) {
+                        cert_pem = cert_file.read(0);
+                        cert_file.close();
+                    }
+                    ws_pipe->set_tls(cert_pem);
+                }
+                odata.ws_pipes.push_back(ws_pipe);
+            }
+            auto obs_parser = std::make_shared<comm::parser::OBSParser>(db);
+            obs_parser->set_input_message_type(comm::MessageType::InboundWireless | tag);
+            obs_parser->set_output_message_type(comm::MessageType::OutboundWireless | tag);
+            odata.obs_parsers.push_back(obs_parser);
+            auto first_stub = odata.ws_stubs.size();
+            odata.ws_stubs.emplace_back(std::make_shared<comm::parser::obs::OBSHello>(ws.password));
+            odata.ws_stubs.emplace_back(std::make_shared<comm::parser::obs::OBSIdentified>());
+            odata.ws_stubs.emplace_back(std::make_shared<comm::parser::obs::OBSEvent>());
+            auto event_stub = odata.ws_stubs.back();
+            odata.ws_stubs.emplace_back(std::make_shared<comm::parser::obs::OBSRequestResponse>());
+            auto req_resp_stub = odata.ws_stubs.back();
+            odata.ws_stubs.emplace_back(std::make_shared<comm::parser::obs::OBSRequestBatchResponse>());
+            auto batch_req_resp_stub = odata.ws_stubs.back();
+            // register loaded stubs with parser
+            for (auto k=first_stub; k<odata.ws_stubs.size(); k++)
+                obs_parser->register_parser_stub(odata.ws_stubs[k]);
+            // set event parser stub to issue event messages
+            event_stub->set_message_type(comm::MessageType::Event | tag);
+            // set response parser stubs to issue event messages; it could be set to something
+            // else but at this point I don't do anything with those
+            req_resp_stub->set_message_type(comm::MessageType::Event | tag);
+            batch_req_resp_stub->set_message_type(comm::MessageType::Event | tag);
+        }
+    }
+
+
+    void setup_tunnel(const Configuration & cfg, UARTData & udata) {
+        uint8_t targets = 0;
+        for (uint8_t n=0; n<cfg.websockets.size(); n++)
+            if (cfg.websockets[n].transport == Transport::Serial)
+                targets |= 1 << n;
+        udata.uart_pipe->set_tunnel_targets(targets);
+    }
+
+
+    void setup_stats(UARTData & udata, const OBSData & odata) {
+        udata.uart_stubs.emplace_back(std::make_shared<comm::parser::serial::GetLinkStatsParserStub>(odata.ws_pipes));
+        udata.uart_parser->register_parser_stub(udata.uart_stubs.back());
+    }
+
+
+    std::unique_ptr<comm::pipe::HTTPServer> setup_http(std::shared_ptr<comm::DataBroker> db,
+                                                       std::shared_ptr<storage::NVStorage> nvs,
+                                                       std::shared_ptr<storage::SPIFlash> spiflash,
+                                                       const Configuration & cfg,
+                                                       const OBSData & odata) {
+        // without token, anyone on the network could write files; without WiFi
+        // connection, radio is never started
+        if (cfg.http_token.empty() || odata.ws_pipes.empty()) return nullptr;
+        auto server = std::make_unique<comm::pipe::HTTPServer>(spiflash, nvs, db, cfg.http_token);
+        server->enable();
+        return server;
     }
 
 }
@@ -32,11 +32,11 @@ namespace eobsws::impl {
      */
     std::unique_ptr<hardware::input::TouchpadLVGL> setup_touch(const Configuration & cfg);
 
-    /** \fn std::vector< std::unique_ptr<hardware::AnalogPin> > setup_gpio()
+    /** \fn std::vector< std::shared_ptr<hardware::AnalogPin> > setup_gpio()
      *  \brief Sets up the analog GPIO pin drivers.
      *  \returns a container with analog pin driver instances.
      */
-    std::vector<std::unique_ptr<hardware::AnalogPin>> setup_gpio();
+    std::vector<std::shared_ptr<hardware::AnalogPin>> setup_gpio();
 
     /** \fn std::shared_ptr<storage::SPIFlash> setup_flash(const std::string & part_name)
      *  \brief Sets up the flash storage partition.
@@ -48,29 +48,76 @@ namespace eobsws::impl {
     /** \fn void setup_uart(std::shared_ptr<comm::DataBroker> db,
      *                      std::shared_ptr<storage::NVStorage> nvs,
      *                      std::shared_ptr<storage::SPIFlash> spiflash,
+     *                      std::shared_ptr<hardware::screen::ScreenLVGL> screen,
+     *                      std::shared_ptr<hardware::input::TouchpadLVGL> touch,
+     *                      const std::vector< std::shared_ptr<hardware::AnalogPin> > & pots,
      *                      UARTData & udata)
      *  \brief Sets up the UART communication handler.
      *  \param db: data broker assigned to buttons to issue commands.
      *  \param nvs: pointer to a non-volatile storage accessor.
      *  \param spiflash: pointer to a flash storage partition containing image files.
+     *  \param screen: pointer to the screen driver, for screenshots.
+     *  \param touch: pointer to the touch panel driver, for injected touch events.
+     *  \param pots: analog pin drivers, for forced potentiometer values.
      *  \param udata: container for UART handler.
      */
     void setup_uart(std::shared_ptr<comm::DataBroker> db,
                     std::shared_ptr<storage::NVStorage> nvs,
                     std::shared_ptr<storage::SPIFlash> spiflash,
+                    std::shared_ptr<hardware::screen::ScreenLVGL> screen,
+                    std::shared_ptr<hardware::input::TouchpadLVGL> touch,
+                    const std::vector< std::shared_ptr<hardware::AnalogPin> > & pots,
                     UARTData & udata);
 
     /** \fn void setup_websocket(std::shared_ptr<comm::DataBroker> db,
+     *                           std::shared_ptr<storage::NVStorage> nvs,
+     *                           std::shared_ptr<storage::SPIFlash> spiflash,
      *                           const Configuration & cfg,
      *                           OBSData & odata)
      *  \brief Sets up the obs-websocket handler.
      *  \param db: data broker assigned to buttons to issue commands.
+     *  \param nvs: pointer to a non-volatile storage accessor, used to cache connection parameters.
+     *  \param spiflash: pointer to a flash storage partition containing server certificates.
      *  \param cfg: configuration storage instance.
      *  \param odata: container for obs-websocket handler.
      */
     void setup_websocket(std::shared_ptr<comm::DataBroker> db,
+                         std::shared_ptr<storage::NVStorage> nvs,
+                         std::shared_ptr<storage::SPIFlash> spiflash,
                          const Configuration & cfg,
                          OBSData & odata);
 
-}
+    /** \fn void setup_tunnel(const Configuration & cfg, UARTData & udata)
+     *  \brief Sets up UART link to carry obs-websocket connections configured with serial transport.
+     *  \param cfg: configuration storage instance.
+     *  \param udata: container for UART handler.
+     */
+    void setup_tunnel(const Configuration & cfg, UARTData & udata);
+
+    /** \fn void setup_stats(UARTData & udata, const OBSData & odata)
+     *  \brief Registers serial commands giving access to obs-websocket link statistics.
+     *  \param udata: container for UART handler.
+     *  \param odata: container for obs-websocket handler.
+     */
+    void setup_stats(UARTData & udata, const OBSData & odata);
 
+    /** \fn std::unique_ptr<comm::pipe::HTTPServer> setup_http(std::shared_ptr<comm::DataBroker> db,
+     *                                                          std::shared_ptr<storage::NVStorage> nvs,
+     *                                                          std::shared_ptr<storage::SPIFlash> spiflash,
+     *                                                          const Configuration & cfg,
+     *                                                          const OBSData & odata)
+     *  \brief Sets up the HTTP file and configuration server, started once WiFi is connected.
+     *  \param db: pointer to data broker receiving configuration change notifications.
+     *  \param nvs: pointer to a non-volatile storage accessor.
+     *  \param spiflash: pointer to a flash storage partition containing image files.
+     *  \param cfg: configuration storage instance.
+     *  \param odata: container for obs-websocket handler.
+     *  \returns a pointer to a server instance, or nullptr if no token is set or WiFi isn't used.
+     */
+    std::unique_ptr<comm::pipe::HTTPServer> setup_http(std::shared_ptr<comm::DataBroker> db,
+                                                       std::shared_ptr<storage::NVStorage> nvs,
+                                                       std::shared_ptr<storage::SPIFlash> spiflash,
+                                                       const Configuration & cfg,
+                                                       const OBSData & odata);
+
+}
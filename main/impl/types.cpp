@@ -8,20 +8,63 @@
 
 namespace eobsws::impl {
 
+    /** \fn static inline bool same_color(lv_color_t c1, lv_color_t c2)
+     *  \brief Compare two colors.
+     *  \param c1,c2: colors to compare.
+     *  \returns true if colors are the same, false otherwise.
+     */
+    static inline bool same_color(lv_color_t c1, lv_color_t c2) {
+        return lv_color_to32(c1) == lv_color_to32(c2);
+    }
+
+
+    bool PotentiometerConfiguration::same_bar(const PotentiometerConfiguration & other) const {
+        return this->raw_min == other.raw_min && this->raw_max == other.raw_max
+               && same_color(this->bg_color, other.bg_color) && same_color(this->fg_color, other.fg_color)
+               && this->bg_opacity == other.bg_opacity && this->fg_opacity == other.fg_opacity;
+    }
+
+
+    bool WebSocketConfiguration::operator==(const WebSocketConfiguration & other) const {
+        return this->host == other.host && this->port == other.port && this->path == other.path
+               && this->password == other.password && this->transport == other.transport
+               && this->tls == other.tls && this->cert == other.cert;
+    }
+
+
     Configuration::Configuration(std::shared_ptr<storage::NVStorage> nvs) {
         // flash storage partition name
         this->storage_part_name = nvs->get_string("storage", "part_name", CONFIG_VFAT_VOLUME_NAME);
         // WiFi settings
         this->wifi_ssid = nvs->get_string("wifi", "ssid", CONFIG_WIFI_SSID);
         this->wifi_password = nvs->get_string("wifi", "password", CONFIG_WIFI_PASSWORD);
-        // WebSockets settings
-        this->websocket_host = nvs->get_string("websocket", "host", CONFIG_WEBSOCKET_HOST);
-        this->websocket_port = nvs->get_item<uint16_t>("websocket", "port", CONFIG_WEBSOCKET_PORT);
-        this->websocket_password = nvs->get_string("websocket", "password", CONFIG_WEBSOCKET_PASSWORD);
-        this->websocket_path = nvs->get_string("websocket", "path", CONFIG_WEBSOCKET_PATH);
+        this->wifi_static_ip = nvs->get_string("wifi", "static_ip", "");
+        this->wifi_netmask = nvs->get_string("wifi", "netmask", "255.255.255.0");
+        this->wifi_gateway = nvs->get_string("wifi", "gateway", "");
+        this->wifi_dns = nvs->get_string("wifi", "dns", "");
+        // HTTP server settings
+        this->http_token = nvs->get_string("http", "token", "");
+        // WebSockets settings; connection 0 is in namespace websocket,
+        // connection n in websocket_n; numbering stops at first WiFi connection without host
+        for (size_t n=0; n<CONFIG_WS_MAX_SESSIONS; n++) {
+            std::string idx_str = n == 0 ? "websocket" : "websocket_" + std::to_string(n);
+            WebSocketConfiguration ws;
+            ws.transport = nvs->get_item(idx_str, "transport", Transport::WiFi);
+            ws.host = nvs->get_string(idx_str, "host", n == 0 ? CONFIG_WEBSOCKET_HOST : "");
+            if (n > 0 && ws.host.empty() && ws.transport == Transport::WiFi) break;
+            ws.port = nvs->get_item<uint16_t>(idx_str, "port", CONFIG_WEBSOCKET_PORT);
+            ws.password = nvs->get_string(idx_str, "password", n == 0 ? CONFIG_WEBSOCKET_PASSWORD : "");
+            ws.path = nvs->get_string(idx_str, "path", CONFIG_WEBSOCKET_PATH);
+            ws.tls = nvs->get_item<uint8_t>(idx_str, "tls", 0) == 1;
+            ws.cert = nvs->get_string(idx_str, "cert", "");
+            this->websockets.push_back(ws);
+        }
         // screen settings
         this->screen_orientation = static_cast<lv_disp_rot_t>(
             nvs->get_item<uint8_t>("screen", "orientation", 0) << 1);
+        this->screen_color = lvgl::misc::color::from_rgb(nvs->get_item<uint8_t>("screen","bg_color_r",0),
+                                                         nvs->get_item<uint8_t>("screen","bg_color_g",0),
+                                                         nvs->get_item<uint8_t>("screen","bg_color_b",0));
         // backlight dimming
         this->bl_lvl_dimmed = 1024 - nvs->get_item<uint16_t>("screen", "bl_lvl_dimmed", 0);
         this->bl_lvl_act = 1024 - nvs->get_item<uint16_t>("screen", "bl_lvl_act", 0);
@@ -52,6 +95,8 @@ namespace eobsws::impl {
             this->pots[n].divider = nvs->get_item<uint16_t>(idx_str, "divider", 1);
             // command template in which value gets inserted
             this->pots[n].command = nvs->get_string(idx_str, "command", "%0.2f");
+            // OBS connections receiving commands
+            this->pots[n].targets = nvs->get_item<uint8_t>(idx_str, "targets", 1);
             // indicator bar colors
             using namespace lvgl::misc::color;
             this->pots[n].bg_color = from_rgb(nvs->get_item<uint8_t>(idx_str,"bg_color_r",0),
@@ -66,6 +111,15 @@ namespace eobsws::impl {
     }
 
 
+    bool Configuration::same_connections(const Configuration & other) const {
+        return this->storage_part_name == other.storage_part_name
+               && this->wifi_ssid == other.wifi_ssid && this->wifi_password == other.wifi_password
+               && this->wifi_static_ip == other.wifi_static_ip && this->wifi_netmask == other.wifi_netmask
+               && this->wifi_gateway == other.wifi_gateway && this->wifi_dns == other.wifi_dns
+               && this->http_token == other.http_token && this->websockets == other.websockets;
+    }
+
+
     ButtonConfiguration::ButtonConfiguration(std::shared_ptr<storage::NVStorage> nvs, uint8_t idx) {
         // namespace in NVS where to search
         auto idx_str = "button_" + std::to_string(idx);
@@ -86,7 +140,16 @@ namespace eobsws::impl {
             nvs->get_item<uint8_t>(idx_str,"event_color_g",0),
             nvs->get_item<uint8_t>(idx_str,"event_color_b",0));
         this->event_opacity = nvs->get_item<uint8_t>(idx_str,"event_color_a",LV_OPA_30);
+        // OBS connections receiving commands
+        this->targets = nvs->get_item<uint8_t>(idx_str, "targets", 1);
     }
 
 
-}
\ No newline at end of file
+    bool ButtonConfiguration::operator==(const ButtonConfiguration & other) const {
+        return this->image_off == other.image_off && this->image_on == other.image_on
+               && this->type == other.type && this->command_on == other.command_on
+               && this->command_off == other.command_off && same_color(this->event_color, other.event_color)
+               && this->event_opacity == other.event_opacity && this->targets == other.targets;
+    }
+
+}
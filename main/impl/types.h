@@ -10,6 +10,7 @@
 #include "comm/parser/serial_parser.h"
 #include "comm/parser/serial_parser_stub.h"
 #include "comm/pipe/websocket_pipe.h"
+#include "comm/pipe/http_server.h"
 #include "comm/parser/obs_parser.h"
 #include "comm/parser/obs_reply_parser.h"
 #include "comm/parser/obs_parser_stub.h"
@@ -85,6 +86,75 @@ namespace eobsws::impl {
          *  \brief Opacity of bar foreground.
          */
         lv_opa_t fg_opacity;
+
+        /** \property uint8_t targets
+         *  \brief OBS connections to which commands are sent (bit n = connection n).
+         */
+        uint8_t targets = 1;
+
+        /** \fn bool same_bar(const PotentiometerConfiguration & other) const
+         *  \brief Tell if indicator bar looks the same with another configuration.
+         *  \param other: configuration to compare with.
+         *  \returns true if range, colors and opacities are the same, false otherwise.
+         */
+        bool same_bar(const PotentiometerConfiguration & other) const;
+    };
+
+
+    /** \enum Transport
+     *  \brief Transports for obs-websocket connections.
+     */
+    enum class Transport : uint8_t {
+        WiFi = 0, /**< direct WebSocket connection over WiFi */
+        Serial = 1 /**< tunneled over UART link, relayed to OBS by a host bridge */
+    };
+
+
+    /** \class WebSocketConfiguration
+     *  \brief Container class for obs-websocket connection configuration.
+     */
+    struct WebSocketConfiguration {
+        /** \property std::string host
+         *  \brief WebSocket host address.
+         */
+        std::string host;
+
+        /** \property uint16_t port
+         *  \brief WebSocket host port.
+         */
+        uint16_t port;
+
+        /** \property std::string path
+         *  \brief Path on WebSocket host.
+         */
+        std::string path;
+
+        /** \property std::string password
+         *  \brief Password for obs-websocket server.
+         */
+        std::string password;
+
+        /** \property Transport transport
+         *  \brief Transport used by connection.
+         */
+        Transport transport = Transport::WiFi;
+
+        /** \property bool tls
+         *  \brief If true, connection uses TLS (wss://).
+         */
+        bool tls = false;
+
+        /** \property std::string cert
+         *  \brief Path to trusted server or CA certificate (PEM) on flash storage; required with TLS.
+         */
+        std::string cert;
+
+        /** \fn bool operator==(const WebSocketConfiguration & other) const
+         *  \brief Compare with another configuration.
+         *  \param other: configuration to compare with.
+         *  \returns true if all settings are the same, false otherwise.
+         */
+        bool operator==(const WebSocketConfiguration & other) const;
     };
 
 
@@ -107,31 +177,46 @@ namespace eobsws::impl {
          */
         std::string wifi_password;
 
-        /** \property std::string websocket_host
-         *  \brief WebSocket host address.
+        /** \property std::string wifi_static_ip
+         *  \brief Static IP address; DHCP is used if empty.
          */
-        std::string websocket_host;
+        std::string wifi_static_ip;
 
-        /** \property uint16_t websocket_port
-         *  \brief WebSocket host port.
+        /** \property std::string wifi_netmask
+         *  \brief Network mask used with static IP address.
          */
-        uint16_t websocket_port;
+        std::string wifi_netmask;
 
-        /** \property std::string websocket_path
-         *  \brief Path on WebSocket host.
+        /** \property std::string wifi_gateway
+         *  \brief Gateway used with static IP address.
          */
-        std::string websocket_path;
+        std::string wifi_gateway;
 
-        /** \property std::string websocket_password
-         *  \brief Password for obs-websocket server.
+        /** \property std::string wifi_dns
+         *  \brief DNS server used with static IP address.
+         */
+        std::string wifi_dns;
+
+        /** \property std::string http_token
+         *  \brief Access token for HTTP server; server doesn't run if empty.
+         */
+        std::string http_token;
+
+        /** \property std::vector<WebSocketConfiguration> websockets
+         *  \brief Configuration of obs-websocket connections; index is the connection target.
          */
-        std::string websocket_password;
+        std::vector<WebSocketConfiguration> websockets;
 
         /** \property lv_disp_rot_t screen_orientation
          *  \brief Screen orientation: LV_DISP_ROT_NONE or LV_DISP_ROT_180
          */
         lv_disp_rot_t screen_orientation = LV_DISP_ROT_NONE;
 
+        /** \property lv_color_t screen_color
+         *  \brief Screen background color.
+         */
+        lv_color_t screen_color;
+
         /** \property uint16_t bl_lvl_act
          *  \brief Screen backlight level when active (0=minimum, 1024=maximum)
          */
@@ -197,6 +282,14 @@ namespace eobsws::impl {
          *  \param nvs: pointer to a non-volatile storage accessor.
          */
         Configuration(std::shared_ptr<storage::NVStorage> nvs);
+
+        /** \fn bool same_connections(const Configuration & other) const
+         *  \brief Tell if connection settings (storage, WiFi, obs-websocket, HTTP) are the
+         *  same in another configuration; they can't change without a restart.
+         *  \param other: configuration to compare with.
+         *  \returns true if connection settings are the same, false otherwise.
+         */
+        bool same_connections(const Configuration & other) const;
     };
 
 
@@ -225,15 +318,16 @@ namespace eobsws::impl {
      *  \brief Container class for OBS handler.
      */
     struct OBSData {
-        /** \property std::shared_ptr<comm::pipe::WebSocketPipe> ws_pipe
-         *  \brief Pointer to a WebSocket communication pipe instance.
+        /** \property std::vector< std::shared_ptr<comm::pipe::WebSocketPipe> > ws_pipes
+         *  \brief WebSocket communication pipe instances, one per connection.
          */
-        std::shared_ptr<comm::pipe::WebSocketPipe> ws_pipe;
+        std::vector< std::shared_ptr<comm::pipe::WebSocketPipe> > ws_pipes;
 
-        /** \property std::shared_ptr<comm::parser::OBSParser> obs_parser
-         *  \brief Pointer to an obs-websocket command parser instance.
+        /** \property std::vector< std::shared_ptr<comm::parser::OBSParser> > obs_parsers
+         *  \brief obs-websocket command parser instances, one per connection; each one
+         *  holds its own session state.
          */
-        std::shared_ptr<comm::parser::OBSParser> obs_parser;
+        std::vector< std::shared_ptr<comm::parser::OBSParser> > obs_parsers;
 
         /** \property std::shared_ptr<comm::parser::OBSReplyParser> obs_reply_parser
          *  \brief Pointer to an obs-websocket reply parser instance.
@@ -261,11 +355,21 @@ namespace eobsws::impl {
          */
         std::vector< std::shared_ptr<gui::widgets::ImageButtonPNG>> buttons;
 
+        /** \property std::vector< std::vector< std::shared_ptr<lvgl::misc::Style> > > button_styles
+         *  \brief Styles of each button, kept apart so that a button can be rebuilt alone.
+         */
+        std::vector< std::vector< std::shared_ptr<lvgl::misc::Style> > > button_styles;
+
         /** \property std::vector< std::unique_ptr<lvgl::widgets::Bar> > bars
          *  \brief This stores the bars instances.
          */
         std::vector< std::unique_ptr<lvgl::widgets::Bar> > bars;
 
+        /** \property std::vector< std::vector< std::shared_ptr<lvgl::misc::Style> > > bar_styles
+         *  \brief Styles of each bar, kept apart so that a bar can be rebuilt alone.
+         */
+        std::vector< std::vector< std::shared_ptr<lvgl::misc::Style> > > bar_styles;
+
         /** \property std::vector< std::unique_ptr<lvgl::core::Object> > lvgl_objects
          *  \brief This contains LVGL objects that have to be stored for the program to
          *  work properly, but are not accessed directly.
@@ -358,12 +462,24 @@ namespace eobsws::impl {
          */
         lv_opa_t event_opacity;
 
+        /** \property uint8_t targets
+         *  \brief OBS connections to which commands are sent (bit n = connection n).
+         */
+        uint8_t targets;
+
         /** \fn ButtonConfiguration(std::shared_ptr<storage::NVStorage> nvs, uint8_t idx)
          *  \brief Constructor.
          *  \param nvs: pointer to a non-volatile storage accessor.
          *  \param idx: button index in storage.
          */
         ButtonConfiguration(std::shared_ptr<storage::NVStorage> nvs, uint8_t idx);
+
+        /** \fn bool operator==(const ButtonConfiguration & other) const
+         *  \brief Compare with another configuration.
+         *  \param other: configuration to compare with.
+         *  \returns true if all settings are the same, false otherwise.
+         */
+        bool operator==(const ButtonConfiguration & other) const;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+/** \file block_cache.cpp
+ *  \brief Implementation file for file block cache.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "block_cache.h"
+
+#if CONFIG_FILE_READ_CACHE
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <algorithm>
+#include <cstring>
+
+namespace eobsws::storage {
+
+    BlockCache::BlockCache(size_t nblocks) : entries(nblocks) {
+        this->data = static_cast<uint8_t*>(heap_caps_malloc(nblocks*BlockSize, MALLOC_CAP_SPIRAM));
+        if (this->data == nullptr) {
+            ESP_LOGE("BlockCache", "cannot allocate %d blocks; files are read directly.", nblocks);
+            return;
+        }
+        this->enabled = true;
+    }
+
+    BlockCache::~BlockCache() {
+        heap_caps_free(this->data);
+    }
+
+    BlockCache & BlockCache::shared() {
+        static BlockCache cache(CONFIG_FILE_CACHE_BLOCKS);
+        return cache;
+    }
+
+    BlockCache::Entry * BlockCache::get_block(const std::string & path, size_t path_hash,
+                                              size_t block, const Loader & load) {
+        auto it = std::find_if(this->entries.begin(), this->entries.end(), [&](const Entry & e) {
+            return e.valid && e.block == block && e.path_hash == path_hash && e.path == path;
+        });
+        if (it != this->entries.end()) {
+            this->stats.hits++;
+            it->last_use = ++this->use_counter;
+            return &*it;
+        }
+        // block goes in place of least recently used one; invalid entries have age 0
+        it = std::min_element(this->entries.begin(), this->entries.end(), [](const Entry & e1, const Entry & e2) {
+            return (e1.valid ? e1.last_use : 0) < (e2.valid ? e2.last_use : 0);
+        });
+        this->stats.misses++;
+        it->valid = false;
+        auto size = load(block*BlockSize, this->data + (it - this->entries.begin())*BlockSize);
+        if (size == static_cast<size_t>(-1)) return nullptr;
+        it->path = path;
+        it->path_hash = path_hash;
+        it->block = block;
+        it->size = size;
+        it->last_use = ++this->use_counter;
+        it->valid = true;
+        return &*it;
+    }
+
+    size_t BlockCache::read(const std::string & path, size_t pos, void * buffer, size_t len, const Loader & load) {
+        auto path_hash = std::hash<std::string>()(path);
+        auto out = static_cast<uint8_t*>(buffer);
+        size_t nread = 0;
+        std::lock_guard<std::mutex> guard(this->mtx);
+        while (nread < len) {
+            auto block = (pos + nread) / BlockSize;
+            auto offset = (pos + nread) % BlockSize;
+            auto entry = this->get_block(path, path_hash, block, load);
+            if (entry == nullptr) return -1;
+            if (offset >= entry->size) break; // end of file
+            auto n = std::min(len - nread, entry->size - offset);
+            memcpy(out + nread, this->data + (entry - this->entries.data())*BlockSize + offset, n);
+            nread += n;
+            if (entry->size < BlockSize) break; // last block of file
+        }
+        return nread;
+    }
+
+    void BlockCache::invalidate(const std::string & path) {
+        auto path_hash = std::hash<std::string>()(path);
+        std::lock_guard<std::mutex> guard(this->mtx);
+        for (auto & e: this->entries) {
+            if (e.valid && e.path_hash == path_hash && e.path == path)
+                e.valid = false;
+        }
+    }
+
+    void BlockCache::clear() {
+        std::lock_guard<std::mutex> guard(this->mtx);
+        for (auto & e: this->entries)
+            e.valid = false;
+    }
+
+    BlockCache::Stats BlockCache::get_stats() {
+        std::lock_guard<std::mutex> guard(this->mtx);
+        return this->stats;
+    }
+
+    void BlockCache::reset_stats() {
+        std::lock_guard<std::mutex> guard(this->mtx);
+        this->stats = Stats();
+    }
+
+}
+#endif
@@ -0,0 +1,168 @@
+/** \file block_cache.h
+ *  \brief Header file for file block cache. Files opened read-only are read by whole
+ *  blocks, aligned on flash sectors, which are kept in a small least-recently-used cache
+ *  shared by all files; small reads (PNG chunk headers, LVGL image decoders) then cost a
+ *  copy instead of a trip through FAT and wear levelling. Cache memory is taken from
+ *  PSRAM. Without CONFIG_FILE_READ_CACHE, the cache isn't built and files are read directly.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#pragma once
+#include "sdkconfig.h"
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eobsws::storage {
+
+    /** \class BlockCache
+     *  \brief Least-recently-used cache of file blocks, shared by all open files.
+     *  Blocks are identified by file path and index; writing to or deleting a file
+     *  drops its blocks.
+     */
+    class BlockCache {
+    public:
+        /** \var static constexpr size_t BlockSize
+         *  \brief Block size; blocks match wear levelling sectors, so that a block load
+         *  reads a single sector.
+         */
+        static constexpr size_t BlockSize = CONFIG_WL_SECTOR_SIZE;
+
+        /** \typedef Loader
+         *  \brief Function reading up to BlockSize bytes of a file at given offset into
+         *  given buffer; it returns number of bytes read (fewer at end of file), or -1 if failed.
+         */
+        using Loader = std::function<size_t(size_t offset, uint8_t * buffer)>;
+
+        /** \struct Stats
+         *  \brief Cache statistics.
+         */
+        struct Stats {
+            uint32_t hits = 0; ///< number of block accesses served from cache
+            uint32_t misses = 0; ///< number of block loads
+        };
+
+    private:
+        /** \struct Entry
+         *  \brief Cache entry.
+         */
+        struct Entry {
+            std::string path; ///< full path of file
+            size_t path_hash = 0; ///< hash of path, compared before path
+            size_t block = 0; ///< block index in file
+            size_t size = 0; ///< number of valid bytes in block (less than BlockSize for last block)
+            uint32_t last_use = 0; ///< use counter value at last access
+            bool valid = false; ///< true if entry holds a block
+        };
+
+        /** \property std::mutex mtx
+         *  \brief Mutex guarding entries; files are read by several tasks.
+         */
+        std::mutex mtx;
+
+        /** \property std::vector<Entry> entries
+         *  \brief Cache entries; entry n holds data at offset n*BlockSize.
+         */
+        std::vector<Entry> entries;
+
+        /** \property uint8_t * data
+         *  \brief Block data, in PSRAM.
+         */
+        uint8_t * data = nullptr;
+
+        /** \property uint32_t use_counter
+         *  \brief Counter incremented at each block access, giving entries their age.
+         */
+        uint32_t use_counter = 0;
+
+        /** \property bool enabled
+         *  \brief If false, files opened from then on bypass cache.
+         */
+        bool enabled = false;
+
+        /** \property Stats stats
+         *  \brief Cache statistics.
+         */
+        Stats stats;
+
+        /** \fn Entry * get_block(const std::string & path, size_t path_hash, size_t block, const Loader & load)
+         *  \brief Get block from cache, loading it in place of least recently used one
+         *  if it isn't there. Mutex must be held.
+         *  \param path: full file path.
+         *  \param path_hash: hash of path.
+         *  \param block: block index.
+         *  \param load: function reading block from file.
+         *  \returns pointer to entry, or nullptr if block couldn't be loaded.
+         */
+        Entry * get_block(const std::string & path, size_t path_hash, size_t block, const Loader & load);
+
+    public:
+        /** \fn BlockCache(size_t nblocks)
+         *  \brief Constructor. Cache is disabled if its memory can't be allocated.
+         *  \param nblocks: number of cached blocks.
+         */
+        BlockCache(size_t nblocks);
+
+        /** \fn ~BlockCache()
+         *  \brief Destructor.
+         */
+        ~BlockCache();
+
+        /** \fn static BlockCache & shared()
+         *  \brief Get cache shared by all files, holding CONFIG_FILE_CACHE_BLOCKS blocks.
+         *  \returns cache instance.
+         */
+        static BlockCache & shared();
+
+        /** \fn bool is_enabled() const
+         *  \brief Tell if files opened read-only go through cache.
+         *  \returns true if cache is enabled, false otherwise.
+         */
+        bool is_enabled() const { return this->enabled; }
+
+        /** \fn void set_enabled(bool enabled)
+         *  \brief Enable or disable cache for files opened from then on; used by benchmarks.
+         *  Cache stays disabled if its memory couldn't be allocated.
+         *  \param enabled: true to enable cache, false to disable it.
+         */
+        void set_enabled(bool enabled) { this->enabled = enabled && this->data != nullptr; }
+
+        /** \fn size_t read(const std::string & path, size_t pos, void * buffer, size_t len, const Loader & load)
+         *  \brief Read data from file through cache.
+         *  \param path: full file path.
+         *  \param pos: position in file.
+         *  \param buffer: buffer receiving data, of at least len bytes.
+         *  \param len: number of bytes to read.
+         *  \param load: function reading a block from file, called for blocks missing from cache.
+         *  \returns number of bytes read, fewer at end of file, or -1 if failed.
+         */
+        size_t read(const std::string & path, size_t pos, void * buffer, size_t len, const Loader & load);
+
+        /** \fn void invalidate(const std::string & path)
+         *  \brief Drop all blocks of a file.
+         *  \param path: full file path.
+         */
+        void invalidate(const std::string & path);
+
+        /** \fn void clear()
+         *  \brief Drop all blocks.
+         */
+        void clear();
+
+        /** \fn Stats get_stats()
+         *  \brief Get cache statistics.
+         *  \returns statistics since last reset.
+         */
+        Stats get_stats();
+
+        /** \fn void reset_stats()
+         *  \brief Reset cache statistics.
+         */
+        void reset_stats();
+    };
+
+}
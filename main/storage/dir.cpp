@@ -125,6 +125,28 @@ namespace eobsws::storage {
         return false;
     }
 
+    std::vector<FileInfo> Directory::list_files() const {
+        std::vector<FileInfo> files;
+        if (this->fd == nullptr)
+            return files;
+
+        auto full_path = this->partition->get_full_path(this->dir_path);
+        struct dirent *entry;
+        struct stat st;
+        seekdir(this->fd.get(), this->pos_start); // rewind
+        while ((entry = readdir(this->fd.get())) != nullptr) {
+            if (!is_file_valid(entry)) continue;
+            FileInfo info = {entry->d_name, entry->d_type, 0, 0};
+            if (stat((full_path + "/" + entry->d_name).c_str(), &st) == 0) {
+                if (entry->d_type == DT_REG) info.size = st.st_size;
+                info.mtime = st.st_mtime;
+            }
+            files.push_back(std::move(info));
+        }
+        ESP_LOGI("Directory", "listed %d files in %x", files.size(), (int)this);
+        return files;
+    }
+
     bool Directory::is_open() const {
         return (this->fd != nullptr);
     }
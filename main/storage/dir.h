@@ -11,7 +11,10 @@
 #include <sys/unistd.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <time.h>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "partition.h"
 
@@ -25,6 +28,16 @@ namespace eobsws::storage {
      */
     using DirCloser = std::integral_constant<std::decay_t<decltype(closedir)>, closedir>;
 
+    /** \struct FileInfo
+     *  \brief Directory entry with its metadata.
+     */
+    struct FileInfo {
+        std::string name; ///< file name
+        unsigned char type; ///< file type (DT_REG or DT_DIR)
+        size_t size; ///< file size in bytes (0 for directories)
+        time_t mtime; ///< last modification time (0 if partition doesn't record it)
+    };
+
     /** \class Directory
      *  \brief Class providing access to a directory on a partition.
      */
@@ -101,5 +114,11 @@ namespace eobsws::storage {
          *  \returns true if operation succeeded, false otherwise.
          */
         bool get_file_info(const int position, std::string & file_name, unsigned char & file_type) const;
+
+        /** \fn std::vector<FileInfo> list_files() const
+         *  \brief Lists directory entries with their size and modification time, in one pass.
+         *  \returns directory entries (empty if directory isn't open).
+         */
+        std::vector<FileInfo> list_files() const;
     };
 };
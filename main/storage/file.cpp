@@ -5,10 +5,16 @@
  *  License: MIT
  */
 #include "file.h"
+#include "block_cache.h"
 #include "esp_log.h"
 
+#include <cstring>
+
 namespace eobsws::storage {
-    
+
+    std::atomic<uint32_t> File::fread_count = 0;
+    std::atomic<uint32_t> File::fread_bytes = 0;
+
     File::File(std::shared_ptr<Partition> partition, const std::string & file_path) {
         ESP_LOGI("File", "calling constructor for %x", (int)this);
         this->partition = partition;
@@ -17,6 +23,8 @@ namespace eobsws::storage {
 
     File::~File() {
         ESP_LOGI("File", "calling destructor for %x", (int)this);
+        // goes through close, so that a file dropped while open doesn't leave stale cached blocks
+        this->close();
     }
 
     bool File::open(const char * mode) {
@@ -35,10 +43,19 @@ namespace eobsws::storage {
             return false;
         }
         
-        auto full_path = this->partition->get_full_path(this->file_path);
-        ESP_LOGI("File", "absolute file path is '%s'", full_path.c_str());
+        this->full_path = this->partition->get_full_path(this->file_path);
+        ESP_LOGI("File", "absolute file path is '%s'", this->full_path.c_str());
 
-        this->fd = FilePtrType(fopen(full_path.c_str(), mode), FileCloser());
+        this->fd = FilePtrType(fopen(this->full_path.c_str(), mode), FileCloser());
+        #if CONFIG_FILE_READ_CACHE
+        // read-only files go through block cache; others make cached blocks stale
+        bool read_only = mode[0] == 'r' && strchr(mode, '+') == nullptr;
+        this->cached = read_only && BlockCache::shared().is_enabled();
+        this->writable = !read_only;
+        this->pos = 0;
+        if (!read_only)
+            BlockCache::shared().invalidate(this->full_path);
+        #endif
         ESP_LOGI("File", "file %x got file descriptor %x.", (int)this, (int)(this->fd.get()));
         return (this->fd != nullptr);
     }
@@ -46,30 +63,69 @@ namespace eobsws::storage {
     bool File::close() {
         if (this->fd != nullptr) {
             ESP_LOGI("File", "closing file for %x; descriptor %x", (int)this, int(this->fd.get()));
-            int ret = fclose(this->fd.get());
+            // descriptor is released, so that it doesn't get closed again
+            int ret = fclose(this->fd.release());
+            #if CONFIG_FILE_READ_CACHE
+            // stdio buffer is flushed by fclose; blocks read from flash before that are stale
+            if (this->writable)
+                BlockCache::shared().invalidate(this->full_path);
+            #endif
             if (ret != 0) return false;
             return true;
         }
         return false;
     }
 
-    size_t File::write(const std::string & data) const {
+    size_t File::write(std::string_view data) const {
+        return this->write(data.data(), data.size());
+    }
+
+    size_t File::write(const void * data, size_t len) const {
         if (!(this->is_open() ) ) return -1;
-        ESP_LOGI("File", "writing %d bytes of data to file %x", data.size(), (int)this);
-        return fwrite(data.c_str(), sizeof(char), data.size(), this->fd.get());
+        ESP_LOGD("File", "writing %d bytes of data to file %x", len, (int)this);
+        auto nwritten = fwrite(data, sizeof(char), len, this->fd.get());
+        #if CONFIG_FILE_READ_CACHE
+        // files opened for reading before this one may have cached old content
+        BlockCache::shared().invalidate(this->full_path);
+        #endif
+        return nwritten;
     }
 
     std::string File::read(size_t len) const {
         if ( !(this->is_open()) ) return std::string{};
-        // if len == 0, take file size
-        if (len == 0) len = this->get_size();
+        // if len == 0, take what's left of file
+        if (len == 0) len = this->get_size() - this->get_pos();
         std::string result(len, '\0');
-        ESP_LOGI("File", "reading %d bytes of data from file %x", len, (int)this);
-        if (fread(&result[0], sizeof(char), len, this->fd.get()) != -1) {
-            result.shrink_to_fit();
-            return result;
+        auto nread = this->read_into(result.data(), len);
+        if (nread == static_cast<size_t>(-1)) return std::string{};
+        result.resize(nread);
+        return result;
+    }
+
+    size_t File::read_into(void * buffer, size_t len) const {
+        if ( !(this->is_open()) ) return -1;
+        ESP_LOGD("File", "reading %d bytes of data from file %x", len, (int)this);
+        #if CONFIG_FILE_READ_CACHE
+        if (this->cached) {
+            auto nread = BlockCache::shared().read(this->full_path, this->pos, buffer, len,
+                [this](size_t offset, uint8_t * block) -> size_t {
+                    if (fseek(this->fd.get(), offset, SEEK_SET) != 0) return -1;
+                    return this->read_direct(block, BlockCache::BlockSize);
+                });
+            if (nread != static_cast<size_t>(-1)) this->pos += nread;
+            return nread;
         }
-        return std::string{};
+        #endif
+        return this->read_direct(buffer, len);
+    }
+
+    size_t File::read_direct(void * buffer, size_t len) const {
+        auto nread = fread(buffer, sizeof(char), len, this->fd.get());
+        fread_count++;
+        fread_bytes += nread;
+        // a short read is an error unless end of file was reached
+        if (nread < len && ferror(this->fd.get())) return -1;
+        return nread;
     }
 
     size_t File::get_size() const {
@@ -85,14 +141,23 @@ namespace eobsws::storage {
 
     int File::get_pos() const {
         if (!(this->is_open() ) ) return -1;
-        fpos_t curpos;
-        fgetpos(this->fd.get(), &curpos);
-        return curpos;
+        if (this->cached) return this->pos;
+        return ftell(this->fd.get());
     }
 
     bool File::seek(long int offset, int origin) const {
         if (!(this->is_open() ) ) return false;
-        ESP_LOGI("File", "moving to position %d in file with descriptor 0x%x", (int)offset, (int)this->fd.get());
+        ESP_LOGD("File", "moving to position %d in file with descriptor 0x%x", (int)offset, (int)this->fd.get());
+        if (this->cached) {
+            // position is only recorded; blocks are read when needed
+            long int base = 0;
+            if (origin == SEEK_CUR) base = this->pos;
+            else if (origin == SEEK_END) base = this->get_size();
+            else if (origin != SEEK_SET) return false;
+            if (base + offset < 0) return false;
+            this->pos = base + offset;
+            return true;
+        }
         return fseek(this->fd.get(), offset, origin) == 0;
     }
 
@@ -9,7 +9,9 @@
 #include "partition.h"
 
 #include <stdio.h>
+#include <atomic>
 #include <memory>
+#include <string_view>
 
 namespace eobsws::storage {
 
@@ -43,6 +45,46 @@ namespace eobsws::storage {
          *  We could use a unique_ptr here but then fclose must be handled with care.
          */
         FilePtrType fd = FilePtrType(nullptr, FileCloser());
+
+        /** \property std::string full_path
+         *  \brief Absolute file path, identifying file in block cache.
+         */
+        std::string full_path;
+
+        /** \property bool cached
+         *  \brief True if file is read through block cache (files opened read-only).
+         */
+        bool cached = false;
+
+        /** \property bool writable
+         *  \brief True if file was opened for writing; its cached blocks are then dropped
+         *  when it is closed, once written data is flushed.
+         */
+        bool writable = false;
+
+        /** \property mutable size_t pos
+         *  \brief Position in file, for files read through block cache; descriptor is
+         *  only moved to load blocks.
+         */
+        mutable size_t pos = 0;
+
+        /** \property static std::atomic<uint32_t> fread_count
+         *  \brief Number of reads issued to file system, by all files.
+         */
+        static std::atomic<uint32_t> fread_count;
+
+        /** \property static std::atomic<uint32_t> fread_bytes
+         *  \brief Number of bytes read from file system, by all files.
+         */
+        static std::atomic<uint32_t> fread_bytes;
+
+        /** \fn size_t read_direct(void * buffer, size_t len) const
+         *  \brief Read data from file system at descriptor position.
+         *  \param buffer: buffer receiving data, of at least len bytes.
+         *  \param len: number of bytes to read.
+         *  \returns number of bytes read, fewer at end of file, or -1 if failed.
+         */
+        size_t read_direct(void * buffer, size_t len) const;
         
     public:
         /** \fn File(std::shared_ptr<Partition> partition, const std::string & file_path)
@@ -70,20 +112,36 @@ namespace eobsws::storage {
          */
         bool close();
 
-        /** \fn size_t write(const std::string & data) const
+        /** \fn size_t write(std::string_view data) const
          *  \brief Write data to file.
          *  \param data: data string.
          *  \returns number of bytes written, or -1 if failed.
          */
-        size_t write(const std::string & data) const;
+        size_t write(std::string_view data) const;
+
+        /** \fn size_t write(const void * data, size_t len) const
+         *  \brief Write data to file, straight from caller's buffer.
+         *  \param data: pointer to data.
+         *  \param len: number of bytes to write.
+         *  \returns number of bytes written, or -1 if failed.
+         */
+        size_t write(const void * data, size_t len) const;
 
         /** \fn std::string read(size_t len) const
          *  \brief Read data from file.
-         *  \param len: number of bytes to read.
-         *  \returns bytes read, or empty string if failed.
+         *  \param len: number of bytes to read (0 = whole file).
+         *  \returns bytes read, fewer at end of file, or empty string if failed.
          */
         std::string read(size_t len) const;
 
+        /** \fn size_t read_into(void * buffer, size_t len) const
+         *  \brief Read data from file into caller's buffer, without memory allocations.
+         *  \param buffer: buffer receiving data, of at least len bytes.
+         *  \param len: number of bytes to read.
+         *  \returns number of bytes read, fewer at end of file, or -1 if failed.
+         */
+        size_t read_into(void * buffer, size_t len) const;
+
         /** \fn bool is_open() const
          *  \brief Tell if file is open.
          *  \returns true if file is open, false otherwise.
@@ -102,6 +160,17 @@ namespace eobsws::storage {
          */
         int get_pos() const;
 
+        /** \fn static void get_read_stats(uint32_t & count, uint32_t & bytes)
+         *  \brief Get number of reads and bytes that reached file system, for benchmarks.
+         *  Reads served by block cache aren't counted.
+         *  \param count: number of reads since boot.
+         *  \param bytes: number of bytes read since boot.
+         */
+        static void get_read_stats(uint32_t & count, uint32_t & bytes) {
+            count = fread_count;
+            bytes = fread_bytes;
+        }
+
         /** \fn bool seek(long int offset, int origin) const
          *  \brief Move position in file to given offset.
          *  \param offset: position to reach.
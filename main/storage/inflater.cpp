@@ -0,0 +1,48 @@
+/** \file inflater.cpp
+ *  \brief Implementation file for streaming decompression into files.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "inflater.h"
+#include "esp_log.h"
+
+namespace eobsws::storage {
+
+    Inflater::Inflater(uint8_t window_bits) : window_size(1 << window_bits) {
+        this->decompressor = std::make_unique<tinfl_decompressor>();
+        this->window = std::make_unique<uint8_t[]>(this->window_size);
+        tinfl_init(this->decompressor.get());
+    }
+
+    bool Inflater::inflate(std::string_view data, const File & file) {
+        auto in = reinterpret_cast<const mz_uint8*>(data.data());
+        size_t in_left = data.size();
+        while (!this->done) {
+            size_t in_bytes = in_left;
+            size_t out_bytes = this->window_size - this->window_pos;
+            auto status = tinfl_decompress(this->decompressor.get(), in, &in_bytes,
+                                           this->window.get(), this->window.get() + this->window_pos,
+                                           &out_bytes, TINFL_FLAG_HAS_MORE_INPUT);
+            in += in_bytes;
+            in_left -= in_bytes;
+            if (out_bytes > 0) {
+                std::string_view out(reinterpret_cast<char*>(this->window.get() + this->window_pos), out_bytes);
+                if (file.write(out) != out_bytes) return false;
+                // window wraps around; back-references only reach 2^window_bits bytes back
+                this->window_pos = (this->window_pos + out_bytes) & (this->window_size - 1);
+            }
+            if (status < TINFL_STATUS_DONE) {
+                ESP_LOGE("Inflater", "corrupted stream (status %d).", status);
+                return false;
+            }
+            if (status == TINFL_STATUS_DONE)
+                this->done = true;
+            else if (status == TINFL_STATUS_NEEDS_MORE_INPUT)
+                break;
+        }
+        // data following end of stream is an error
+        return in_left == 0;
+    }
+
+}
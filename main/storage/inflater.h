@@ -0,0 +1,72 @@
+/** \file inflater.h
+ *  \brief Header file for streaming decompression into files.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#pragma once
+
+#include "file.h"
+#include "esp32/rom/miniz.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace eobsws::storage {
+
+    /** \class Inflater
+     *  \brief Decompresses a raw deflate stream chunk by chunk and writes result to a file.
+     *  Memory use is fixed: decompressor state and a circular window of 2^window_bits bytes,
+     *  which must be at least the window used by the compressor.
+     */
+    class Inflater {
+    private:
+        /** \property std::unique_ptr<tinfl_decompressor> decompressor
+         *  \brief Decompressor state.
+         */
+        std::unique_ptr<tinfl_decompressor> decompressor;
+
+        /** \property std::unique_ptr<uint8_t[]> window
+         *  \brief Circular buffer holding last decompressed bytes.
+         */
+        std::unique_ptr<uint8_t[]> window;
+
+        /** \property size_t window_size
+         *  \brief Size of circular buffer.
+         */
+        size_t window_size;
+
+        /** \property size_t window_pos
+         *  \brief Position of next decompressed byte in circular buffer.
+         */
+        size_t window_pos = 0;
+
+        /** \property bool done
+         *  \brief Tell if end of stream was reached.
+         */
+        bool done = false;
+
+    public:
+        /** \fn Inflater(uint8_t window_bits)
+         *  \brief Constructor.
+         *  \param window_bits: base-2 logarithm of window size.
+         */
+        Inflater(uint8_t window_bits);
+
+        /** \fn bool inflate(std::string_view data, const File & file)
+         *  \brief Decompress a chunk of compressed stream into file.
+         *  \param data: compressed data.
+         *  \param file: file to write decompressed data to.
+         *  \returns true if data could be decompressed and written, false otherwise.
+         */
+        bool inflate(std::string_view data, const File & file);
+
+        /** \fn bool is_done() const
+         *  \brief Tell if end of stream was reached.
+         *  \returns true if stream is complete, false otherwise.
+         */
+        bool is_done() const { return this->done; }
+    };
+
+}
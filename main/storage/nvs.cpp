@@ -14,6 +14,188 @@
 
 namespace eobsws::storage {
 
+    /** \var static constexpr uint8_t NamespaceTag
+     *  \brief Type byte of namespace records in configuration blobs.
+     */
+    static constexpr uint8_t NamespaceTag = NVS_TYPE_ANY;
+
+    /** \var static constexpr size_t MaxNameLength
+     *  \brief Maximum length of namespace and key names.
+     */
+    static constexpr size_t MaxNameLength = 15;
+
+    /** \fn static inline bool is_integer(uint8_t type)
+     *  \brief Tell if item type is an integer type (low nibble then gives its size).
+     *  \param type: item type.
+     *  \returns true for integer types, false otherwise.
+     */
+    static inline bool is_integer(uint8_t type) {
+        auto size = type & 0x0f;
+        return (type & 0xe0) == 0 && (size == 1 || size == 2 || size == 4 || size == 8);
+    }
+
+    /** \fn static inline void put_le(std::string & data, uint64_t value, size_t len)
+     *  \brief Append a little-endian value.
+     *  \param data: string to append to.
+     *  \param value: value to append.
+     *  \param len: number of bytes.
+     */
+    static inline void put_le(std::string & data, uint64_t value, size_t len) {
+        for (size_t n = 0; n < len; n++)
+            data.push_back(static_cast<char>(value >> (8*n)));
+    }
+
+    /** \fn static inline uint64_t get_le(std::string_view data)
+     *  \brief Read a little-endian value.
+     *  \param data: value bytes (8 at most).
+     *  \returns value.
+     */
+    static inline uint64_t get_le(std::string_view data) {
+        uint64_t value = 0;
+        for (size_t n = 0; n < data.size(); n++)
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(data[n])) << (8*n);
+        return value;
+    }
+
+    /** \fn static void put_name(std::string & blob, std::string_view name)
+     *  \brief Append a namespace or key name to a configuration blob.
+     *  \param blob: configuration blob.
+     *  \param name: name to append.
+     */
+    static void put_name(std::string & blob, std::string_view name) {
+        blob.push_back(static_cast<char>(name.size()));
+        blob.append(name);
+    }
+
+    /** \fn template <typename T> static esp_err_t dump_integer(NVSHandle & handle, const char * key, std::string & blob)
+     *  \brief Append value of an integer key to a configuration blob.
+     *  \tparam T: key type.
+     *  \param handle: namespace handle.
+     *  \param key: key name.
+     *  \param blob: configuration blob.
+     *  \returns ESP_OK if key could be read, an error code otherwise.
+     */
+    template <typename T> static esp_err_t dump_integer(NVSHandle & handle, const char * key, std::string & blob) {
+        T value;
+        auto ret = handle.get_item(key, value);
+        if (ret == ESP_OK)
+            put_le(blob, static_cast<uint64_t>(value), sizeof(T));
+        return ret;
+    }
+
+    /** \fn static bool dump_value(NVSHandle & handle, uint8_t type, const char * key, std::string & blob)
+     *  \brief Append value of a key to a configuration blob.
+     *  \param handle: namespace handle.
+     *  \param type: key type.
+     *  \param key: key name.
+     *  \param blob: configuration blob.
+     *  \returns true if value could be read, false otherwise (blob is then left incomplete).
+     */
+    static bool dump_value(NVSHandle & handle, uint8_t type, const char * key, std::string & blob) {
+        esp_err_t ret;
+        switch (type) {
+            case NVS_TYPE_U8: ret = dump_integer<uint8_t>(handle, key, blob); break;
+            case NVS_TYPE_I8: ret = dump_integer<int8_t>(handle, key, blob); break;
+            case NVS_TYPE_U16: ret = dump_integer<uint16_t>(handle, key, blob); break;
+            case NVS_TYPE_I16: ret = dump_integer<int16_t>(handle, key, blob); break;
+            case NVS_TYPE_U32: ret = dump_integer<uint32_t>(handle, key, blob); break;
+            case NVS_TYPE_I32: ret = dump_integer<int32_t>(handle, key, blob); break;
+            case NVS_TYPE_U64: ret = dump_integer<uint64_t>(handle, key, blob); break;
+            case NVS_TYPE_I64: ret = dump_integer<int64_t>(handle, key, blob); break;
+            case NVS_TYPE_STR:
+            case NVS_TYPE_BLOB:
+            {
+                bool is_string = type == NVS_TYPE_STR;
+                size_t size;
+                ret = handle.get_item_size(is_string ? ItemType::SZ : ItemType::BLOB, key, size);
+                if (ret != ESP_OK) break;
+                // strings are stored with their terminating null, which isn't exported
+                auto len = is_string ? size - 1 : size;
+                if (len > 0xffff) return false;
+                put_le(blob, len, 2);
+                // value is read in place, at the end of blob
+                auto pos = blob.size();
+                blob.resize(pos + size);
+                ret = is_string ? handle.get_string(key, blob.data() + pos, size)
+                                : handle.get_blob(key, blob.data() + pos, size);
+                blob.resize(pos + len);
+                break;
+            }
+            default:
+                return false;
+        }
+        return ret == ESP_OK;
+    }
+
+    /** \fn template <typename T> static esp_err_t load_integer(NVSHandle & handle, const char * key, std::string_view value)
+     *  \brief Write integer key from its configuration blob value.
+     *  \tparam T: key type.
+     *  \param handle: namespace handle.
+     *  \param key: key name.
+     *  \param value: little-endian value.
+     *  \returns ESP_OK if key could be written, an error code otherwise.
+     */
+    template <typename T> static esp_err_t load_integer(NVSHandle & handle, const char * key, std::string_view value) {
+        return handle.set_item<T>(key, static_cast<T>(get_le(value)));
+    }
+
+    /** \fn static esp_err_t load_value(NVSHandle & handle, uint8_t type, const char * key, std::string_view value)
+     *  \brief Write key from its configuration blob value.
+     *  \param handle: namespace handle.
+     *  \param type: key type.
+     *  \param key: key name.
+     *  \param value: value bytes.
+     *  \returns ESP_OK if key could be written, an error code otherwise.
+     */
+    static esp_err_t load_value(NVSHandle & handle, uint8_t type, const char * key, std::string_view value) {
+        switch (type) {
+            case NVS_TYPE_U8: return load_integer<uint8_t>(handle, key, value);
+            case NVS_TYPE_I8: return load_integer<int8_t>(handle, key, value);
+            case NVS_TYPE_U16: return load_integer<uint16_t>(handle, key, value);
+            case NVS_TYPE_I16: return load_integer<int16_t>(handle, key, value);
+            case NVS_TYPE_U32: return load_integer<uint32_t>(handle, key, value);
+            case NVS_TYPE_I32: return load_integer<int32_t>(handle, key, value);
+            case NVS_TYPE_U64: return load_integer<uint64_t>(handle, key, value);
+            case NVS_TYPE_I64: return load_integer<int64_t>(handle, key, value);
+            case NVS_TYPE_STR: return handle.set_string(key, std::string(value).c_str());
+            case NVS_TYPE_BLOB: return handle.set_blob(key, value.data(), value.size());
+            default: return ESP_FAIL;
+        }
+    }
+
+    /** \fn template <typename F> static bool for_each_record(std::string_view blob, F && f)
+     *  \brief Walk through the records of a configuration blob.
+     *  \param blob: configuration blob.
+     *  \param f: function called with type, name and value of each record (value is empty
+     *  for namespaces); walk stops if it returns false.
+     *  \returns true if blob is well-formed and f accepted every record, false otherwise.
+     */
+    template <typename F> static bool for_each_record(std::string_view blob, F && f) {
+        size_t pos = 0;
+        while (pos < blob.size()) {
+            auto type = static_cast<uint8_t>(blob[pos++]);
+            if (pos >= blob.size()) return false;
+            size_t name_len = static_cast<uint8_t>(blob[pos++]);
+            if (name_len == 0 || name_len > MaxNameLength || pos + name_len > blob.size()) return false;
+            auto name = blob.substr(pos, name_len);
+            pos += name_len;
+            size_t value_len = 0;
+            if (is_integer(type)) {
+                value_len = type & 0x0f;
+            } else if (type == NVS_TYPE_STR || type == NVS_TYPE_BLOB) {
+                if (pos + 2 > blob.size()) return false;
+                value_len = get_le(blob.substr(pos, 2));
+                pos += 2;
+            } else if (type != NamespaceTag) {
+                return false;
+            }
+            if (pos + value_len > blob.size()) return false;
+            if (!f(type, name, blob.substr(pos, value_len))) return false;
+            pos += value_len;
+        }
+        return true;
+    }
+
     NVStorage::NVStorage(const std::string & part_name) {
         this->initialized = false;
         esp_err_t err = nvs_flash_init_partition(part_name.c_str());
@@ -62,6 +244,19 @@ namespace eobsws::storage {
 
         return static_cast<ItemType>(info.type);
     }
+
+
+    std::map<std::string, ItemType> NVStorage::get_types(const std::string & ns) {
+        std::map<std::string, ItemType> types;
+        nvs_iterator_t it = nvs_entry_find(this->part_name.c_str(), ns.c_str(), NVS_TYPE_ANY);
+        nvs_entry_info_t info;
+        while (it != nullptr) {
+            nvs_entry_info(it, &info);
+            types[info.key] = static_cast<ItemType>(info.type);
+            it = nvs_entry_next(it);
+        }
+        return types;
+    }
     
 
     std::string NVStorage::get_string(const std::string & ns, const std::string & key) {
@@ -98,6 +293,52 @@ namespace eobsws::storage {
     }
 
 
+    bool NVStorage::write_item(NVSHandle & handle, const std::string & key, const std::string & value, ItemType type) {
+        esp_err_t ret;
+        if (type == ItemType::SZ || type == ItemType::BLOB_DATA || type == ItemType::BLOB) {
+            if (value.size() < 4000) {
+                ret = handle.set_string(key.c_str(), value.c_str());
+            } else if (value.size() < 508000) {
+                ret = handle.set_blob(key.c_str(), value.c_str(), value.size());
+            } else {
+                ESP_LOGI("NVStorage::write_item", "string too large.");
+                return false;
+            }
+        } else {
+            if (!is_numeric(value) || value.empty()) {
+                ESP_LOGE("NVStorage::write_item", "numeric type but value is not numeric.");
+                return false;
+            }
+            switch (type) {
+                case ItemType::U8:
+                    ret = handle.set_item<uint8_t>(key.c_str(), stoi(value)); break;
+                case ItemType::I8:
+                    ret = handle.set_item<int8_t>(key.c_str(), stoi(value)); break;
+                case ItemType::U16:
+                    ret = handle.set_item<uint16_t>(key.c_str(), stoi(value)); break;
+                case ItemType::I16:
+                    ret = handle.set_item<int16_t>(key.c_str(), stoi(value)); break;
+                case ItemType::U32:
+                    ret = handle.set_item<uint32_t>(key.c_str(), stoul(value)); break;
+                case ItemType::I32:
+                    ret = handle.set_item<int32_t>(key.c_str(), stol(value)); break;
+                case ItemType::U64:
+                    ret = handle.set_item<uint64_t>(key.c_str(), stoull(value)); break;
+                case ItemType::I64:
+                    ret = handle.set_item<int64_t>(key.c_str(), stoll(value)); break;
+                default:
+                    ESP_LOGE("NVStorage::write_item", "invalid type.");
+                    return false;
+            }
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGI("NVStorage::write_item", "cannot write to key '%s'. Error: 0x%x", key.c_str(), ret);
+            return false;
+        }
+        return true;
+    }
+
+
     bool NVStorage::set_string(const std::string & ns, const std::string & key, const std::string & value) {
         esp_err_t ret;
         std::unique_ptr<nvs::NVSHandle> nvs_handle = this->open_namespace(ns, NVS_READWRITE, ret);
@@ -105,18 +346,8 @@ namespace eobsws::storage {
             ESP_LOGI("NVStorage::set_string", "cannot access namespace '%s'. Error: 0x%x", ns.c_str(), ret);
             return false;
         }
-        if (value.size() < 4000) {
-            ret = nvs_handle->set_string(key.c_str(), value.c_str());
-        } else if (value.size() < 508000) {
-            ret = nvs_handle->set_blob(key.c_str(), value.c_str(), value.size());
-        } else {
-            ESP_LOGI("NVStorage::set_string", "string too large.");
+        if (!this->write_item(*nvs_handle, key, value, ItemType::SZ))
             return false;
-        }
-        if (ret != ESP_OK) {
-            ESP_LOGI("NVStorage::set_string", "cannot write to key '%s'. Error: 0x%x", key.c_str(), ret);
-            return false;
-        }
         
         ret = nvs_handle->commit();
         if (ret != ESP_OK) {
@@ -188,4 +419,120 @@ namespace eobsws::storage {
         return true;
     }
 
+
+    bool NVStorage::set_items(const std::string & ns, const std::vector<NVSRecord> & records) {
+        esp_err_t ret;
+        std::unique_ptr<nvs::NVSHandle> nvs_handle = this->open_namespace(ns, NVS_READWRITE, ret);
+        if (ret != ESP_OK) {
+            ESP_LOGI("NVStorage::set_items", "cannot access namespace '%s'. Error: 0x%x", ns.c_str(), ret);
+            return false;
+        }
+        bool success = true;
+        for (auto & record: records)
+            success &= this->write_item(*nvs_handle, record.key, record.value, record.type);
+
+        // keys written so far are committed even if some failed
+        ret = nvs_handle->commit();
+        if (ret != ESP_OK) {
+            ESP_LOGI("NVStorage::set_items", "Couldn't commit to flash. Error: 0x%x", ret);
+            return false;
+        }
+        return success;
+    }
+
+
+    bool NVStorage::dump(std::string & blob) {
+        blob.clear();
+        if (!this->initialized) return false;
+        std::string ns;
+        std::unique_ptr<NVSHandle> nvs_handle;
+        nvs_entry_info_t info;
+        // a single scan of all namespaces; values are read through a handle on current namespace
+        for (nvs_iterator_t it = nvs_entry_find(this->part_name.c_str(), nullptr, NVS_TYPE_ANY);
+             it != nullptr; it = nvs_entry_next(it)) {
+            nvs_entry_info(it, &info);
+            if (ns != info.namespace_name) {
+                esp_err_t ret;
+                ns = info.namespace_name;
+                nvs_handle = this->open_namespace(ns, NVS_READONLY, ret);
+                if (ret != ESP_OK) {
+                    ESP_LOGE("NVStorage::dump", "cannot access namespace '%s'. Error: 0x%x", ns.c_str(), ret);
+                    nvs_release_iterator(it);
+                    return false;
+                }
+                blob.push_back(static_cast<char>(NamespaceTag));
+                put_name(blob, ns);
+            }
+            blob.push_back(static_cast<char>(info.type));
+            put_name(blob, info.key);
+            // an incomplete blob would pass for a whole configuration
+            if (!dump_value(*nvs_handle, info.type, info.key, blob)) {
+                ESP_LOGE("NVStorage::dump", "cannot export key '%s' in namespace '%s'.", info.key, ns.c_str());
+                nvs_release_iterator(it);
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    bool NVStorage::load(std::string_view blob) {
+        if (!this->initialized) return false;
+        // nothing is written unless whole blob is valid, and keys come after a namespace
+        bool has_namespace = false;
+        if (!for_each_record(blob, [&has_namespace](uint8_t type, std::string_view, std::string_view) {
+            has_namespace |= type == NamespaceTag;
+            return has_namespace;
+        })) {
+            ESP_LOGE("NVStorage::load", "malformed configuration blob.");
+            return false;
+        }
+
+        // stored types, from a single scan, so that keys changing type are erased first
+        std::map< std::string, std::map<std::string, uint8_t> > stored;
+        nvs_entry_info_t info;
+        for (nvs_iterator_t it = nvs_entry_find(this->part_name.c_str(), nullptr, NVS_TYPE_ANY);
+             it != nullptr; it = nvs_entry_next(it)) {
+            nvs_entry_info(it, &info);
+            stored[info.namespace_name][info.key] = info.type;
+        }
+
+        std::unique_ptr<NVSHandle> nvs_handle;
+        std::map<std::string, uint8_t> * ns_types = nullptr;
+        bool success = true;
+        auto commit = [&nvs_handle, &success]() {
+            if (nvs_handle == nullptr) return;
+            esp_err_t ret = nvs_handle->commit();
+            if (ret != ESP_OK) {
+                ESP_LOGI("NVStorage::load", "Couldn't commit to flash. Error: 0x%x", ret);
+                success = false;
+            }
+        };
+        bool complete = for_each_record(blob, [&](uint8_t type, std::string_view name, std::string_view value) {
+            std::string key(name);
+            if (type == NamespaceTag) {
+                commit();
+                esp_err_t ret;
+                nvs_handle = this->open_namespace(key, NVS_READWRITE, ret);
+                if (ret != ESP_OK) {
+                    ESP_LOGI("NVStorage::load", "cannot access namespace '%s'. Error: 0x%x", key.c_str(), ret);
+                    nvs_handle = nullptr;
+                    return false;
+                }
+                ns_types = &stored[key];
+                return true;
+            }
+            if (auto it = ns_types->find(key); it != ns_types->end() && it->second != type)
+                nvs_handle->erase_item(key.c_str());
+            if (esp_err_t ret = load_value(*nvs_handle, type, key.c_str(), value); ret != ESP_OK) {
+                ESP_LOGI("NVStorage::load", "cannot write to key '%s'. Error: 0x%x", key.c_str(), ret);
+                success = false;
+            }
+            return true;
+        });
+        // keys written so far are committed even if some failed
+        commit();
+        return complete && success;
+    }
+
 }
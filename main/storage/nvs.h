@@ -10,6 +10,10 @@
 #include "esp_err.h"
 #include "esp_log.h"
 
+#include <map>
+#include <string_view>
+#include <vector>
+
 namespace eobsws::storage {
 
     /** \typedef ItemType
@@ -22,6 +26,15 @@ namespace eobsws::storage {
      */
     using NVSHandle = ::nvs::NVSHandle;
 
+    /** \struct NVSRecord
+     *  \brief Key to be written with NVStorage::set_items.
+     */
+    struct NVSRecord {
+        std::string key; ///< key name
+        ItemType type; ///< item type
+        std::string value; ///< value, as string
+    };
+
     /** \class NVStorage
      *  \brief Class providing access to a non-volatile storage partition.
      */
@@ -37,6 +50,16 @@ namespace eobsws::storage {
          */
         std::string part_name;
 
+        /** \fn bool write_item(NVSHandle & handle, const std::string & key, const std::string & value, ItemType type)
+         *  \brief Write value to given key of an open namespace, without committing.
+         *  \param handle: namespace handle.
+         *  \param key: key name.
+         *  \param value: value, as string.
+         *  \param type: item type.
+         *  \returns true if value could be written, false otherwise.
+         */
+        bool write_item(NVSHandle & handle, const std::string & key, const std::string & value, ItemType type);
+
     public:
         /** \fn NVStorage(const std::string & part_name)
          *  \brief Constructor.
@@ -72,6 +95,13 @@ namespace eobsws::storage {
          */
         ItemType get_type(const std::string & ns, const std::string & key);
 
+        /** \fn std::map<std::string, ItemType> get_types(const std::string & ns)
+         *  \brief Get types of all keys in given namespace, with a single scan.
+         *  \param ns: namespace.
+         *  \returns key types, by key name (empty if namespace doesn't exist).
+         */
+        std::map<std::string, ItemType> get_types(const std::string & ns);
+
         /** \fn std::string get_string(const std::string & ns, const std::string & key, const std::string & def)
          *  \brief Get string from given key in given namespace.
          *  \param ns: namespace.
@@ -197,6 +227,37 @@ namespace eobsws::storage {
          */
         bool erase_item(const std::string & ns, const std::string & key);
 
+        /** \fn bool set_items(const std::string & ns, const std::vector<NVSRecord> & records)
+         *  \brief Set several keys of given namespace, with a single commit.
+         *  Types must have been checked beforehand (see get_types).
+         *  \param ns: namespace.
+         *  \param records: keys to write.
+         *  \returns true if all keys could be set, false otherwise.
+         */
+        bool set_items(const std::string & ns, const std::vector<NVSRecord> & records);
+
+        /** \fn bool dump(std::string & blob)
+         *  \brief Export all keys of all namespaces as a TLV blob, built with a single scan
+         *  of the partition. Each record starts with a type byte (nvs_type_t) and a name
+         *  (length byte, then characters). Type NVS_TYPE_ANY marks a namespace, to which
+         *  following keys belong; integers follow their key as little-endian values, of the
+         *  size given by the low nibble of their type; strings and blobs follow as a 16-bit
+         *  little-endian length, then bytes (no terminating null).
+         *  \param blob: string receiving blob.
+         *  \returns true if all keys could be exported, false if partition isn't initialized,
+         *  or if a key can't be read or has a value too long for the format (over 65535 bytes).
+         */
+        bool dump(std::string & blob);
+
+        /** \fn bool load(std::string_view blob)
+         *  \brief Import keys from a blob made by dump, with one commit per namespace.
+         *  Blob is checked entirely before anything is written. Stored keys of another
+         *  type than imported ones are replaced; keys absent from blob are kept.
+         *  \param blob: blob to import.
+         *  \returns true if all keys could be written, false otherwise.
+         */
+        bool load(std::string_view blob);
+
     };
 }
 
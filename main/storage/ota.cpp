@@ -0,0 +1,111 @@
+/** \file ota.cpp
+ *  \brief Implementation file for firmware updates.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "ota.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace eobsws::storage {
+
+    bool OTAUpdater::begin(size_t size, std::string_view hash) {
+        this->abort();
+        if (hash.size() != 64) {
+            ESP_LOGE("OTAUpdater", "invalid image hash.");
+            return false;
+        }
+        auto partition = esp_ota_get_next_update_partition(nullptr);
+        if (partition == nullptr) {
+            ESP_LOGE("OTAUpdater", "no partition available for update.");
+            return false;
+        }
+        if (size == 0 || size > partition->size) {
+            ESP_LOGE("OTAUpdater", "image size %d doesn't fit in partition %s.", size, partition->label);
+            return false;
+        }
+        // sectors are erased as data comes, so that starting doesn't stall the link
+        auto err = esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &this->handle);
+        if (err != ESP_OK) {
+            ESP_LOGE("OTAUpdater", "cannot start update: %s.", esp_err_to_name(err));
+            return false;
+        }
+        ESP_LOGI("OTAUpdater", "writing %d bytes to partition %s.", size, partition->label);
+        this->partition = partition;
+        this->remaining_bytes = size;
+        this->expected_hash = hash;
+        mbedtls_sha256_init(&this->sha);
+        mbedtls_sha256_starts_ret(&this->sha, 0);
+        return true;
+    }
+
+    bool OTAUpdater::write(std::string_view data) {
+        if (!this->is_active() || data.size() > this->remaining_bytes) return false;
+        auto err = esp_ota_write(this->handle, data.data(), data.size());
+        if (err != ESP_OK) {
+            ESP_LOGE("OTAUpdater", "cannot write image: %s.", esp_err_to_name(err));
+            return false;
+        }
+        mbedtls_sha256_update_ret(&this->sha, reinterpret_cast<const unsigned char*>(data.data()), data.size());
+        this->remaining_bytes -= data.size();
+        return true;
+    }
+
+    bool OTAUpdater::finish() {
+        if (!this->is_active() || this->remaining_bytes > 0) return false;
+        unsigned char digest[32];
+        mbedtls_sha256_finish_ret(&this->sha, digest);
+        char hex[65];
+        for (size_t n=0; n<sizeof(digest); n++)
+            snprintf(hex + 2*n, 3, "%02x", digest[n]);
+        if (this->expected_hash != hex) {
+            ESP_LOGE("OTAUpdater", "image hash mismatch.");
+            this->abort();
+            return false;
+        }
+        // this also checks image structure and checksum
+        auto err = esp_ota_end(this->handle);
+        auto partition = this->partition;
+        this->handle = 0;
+        this->abort();
+        if (err == ESP_OK)
+            err = esp_ota_set_boot_partition(partition);
+        if (err != ESP_OK) {
+            ESP_LOGE("OTAUpdater", "cannot switch to new image: %s.", esp_err_to_name(err));
+            return false;
+        }
+        ESP_LOGI("OTAUpdater", "partition %s will boot at next reset.", partition->label);
+        return true;
+    }
+
+    void OTAUpdater::abort() {
+        if (!this->is_active()) return;
+        if (this->handle != 0)
+            esp_ota_abort(this->handle);
+        mbedtls_sha256_free(&this->sha);
+        this->handle = 0;
+        this->partition = nullptr;
+        this->remaining_bytes = 0;
+    }
+
+    void OTAUpdater::confirm_boot() {
+        esp_ota_img_states_t state;
+        if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) != ESP_OK) return;
+        if (state == ESP_OTA_IMG_PENDING_VERIFY) {
+            ESP_LOGI("OTAUpdater", "new firmware confirmed.");
+            esp_ota_mark_app_valid_cancel_rollback();
+        }
+    }
+
+    void OTAUpdater::restart(int delay_ms) {
+        auto frestart = [](void* arg) {
+            vTaskDelay(reinterpret_cast<intptr_t>(arg) / portTICK_PERIOD_MS);
+            esp_restart();
+        };
+        xTaskCreate(frestart, "restart_task", 2048, reinterpret_cast<void*>(static_cast<intptr_t>(delay_ms)), 5, nullptr);
+    }
+
+}
@@ -0,0 +1,100 @@
+/** \file ota.h
+ *  \brief Header file for firmware updates.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#pragma once
+
+#include "esp_ota_ops.h"
+#include "mbedtls/sha256.h"
+
+#include <string>
+#include <string_view>
+
+namespace eobsws::storage {
+
+    /** \class OTAUpdater
+     *  \brief Writes a firmware image to the inactive app partition as it arrives.
+     *  Image is checked against its SHA-256 hash before boot partition is switched.
+     *  New firmware must call confirm_boot once it runs properly; otherwise bootloader
+     *  goes back to previous firmware at next reset.
+     */
+    class OTAUpdater {
+    private:
+        /** \property const esp_partition_t * partition
+         *  \brief Partition receiving image (nullptr if no update is ongoing).
+         */
+        const esp_partition_t * partition = nullptr;
+
+        /** \property esp_ota_handle_t handle
+         *  \brief Handle of ongoing update.
+         */
+        esp_ota_handle_t handle = 0;
+
+        /** \property mbedtls_sha256_context sha
+         *  \brief Hash of data written so far.
+         */
+        mbedtls_sha256_context sha;
+
+        /** \property std::string expected_hash
+         *  \brief Expected SHA-256 hash of image, in hexadecimal form.
+         */
+        std::string expected_hash;
+
+        /** \property size_t remaining_bytes
+         *  \brief Number of image bytes still expected.
+         */
+        size_t remaining_bytes = 0;
+
+    public:
+        /** \fn ~OTAUpdater()
+         *  \brief Destructor. It aborts an unfinished update.
+         */
+        ~OTAUpdater() { this->abort(); }
+
+        /** \fn bool begin(size_t size, std::string_view hash)
+         *  \brief Start an update. This erases inactive app partition.
+         *  \param size: image size, in bytes.
+         *  \param hash: SHA-256 hash of image, in hexadecimal form.
+         *  \returns true if update could start, false otherwise.
+         */
+        bool begin(size_t size, std::string_view hash);
+
+        /** \fn bool write(std::string_view data)
+         *  \brief Write next chunk of image.
+         *  \param data: image chunk.
+         *  \returns true if chunk could be written, false otherwise.
+         */
+        bool write(std::string_view data);
+
+        /** \fn bool finish()
+         *  \brief Check image and make it boot at next reset.
+         *  \returns true if image is complete and valid, false otherwise.
+         */
+        bool finish();
+
+        /** \fn void abort()
+         *  \brief Abort ongoing update, if any. Running firmware stays the boot firmware.
+         */
+        void abort();
+
+        /** \fn bool is_active() const
+         *  \brief Tell if an update is ongoing.
+         *  \returns true if an update is ongoing, false otherwise.
+         */
+        bool is_active() const { return this->partition != nullptr; }
+
+        /** \fn static void confirm_boot()
+         *  \brief Mark running firmware as valid, if it was just installed; this cancels rollback.
+         */
+        static void confirm_boot();
+
+        /** \fn static void restart(int delay_ms)
+         *  \brief Restart device after a delay, leaving time to send pending replies.
+         *  \param delay_ms: delay in milliseconds.
+         */
+        static void restart(int delay_ms);
+    };
+
+}
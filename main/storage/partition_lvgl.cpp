@@ -0,0 +1,15 @@
+/** \file partition_lvgl.cpp
+ *  \brief Instantiation of LVGL binding for flash partition. No LVGL drive is registered
+ *  yet; instantiating the template here makes sure its callbacks are compiled.
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "partition_lvgl.h"
+#include "spi_flash.h"
+
+namespace eobsws::storage {
+
+    template class PartitionLVGL<SPIFlash>;
+
+}
@@ -5,6 +5,7 @@
  *  License: MIT
  */
 #pragma once
+#include "esp_log.h"
 #include "lvglpp/misc/fs.h"
 #include "partition.h"
 #include "file.h"
@@ -39,7 +40,7 @@ namespace eobsws::storage {
          *  \returns pointer to the file descriptor, or nullptr if failed.
          */
         void * open_cb(const char * path, lv_fs_mode_t mode) override {
-            ESP_LOGI("PartitionLVGL", "opening file %s", path.c_str());
+            ESP_LOGI("PartitionLVGL", "opening file %s", path);
             std::unique_ptr<File> f;
             auto str = std::string(path);
             switch (mode) {
@@ -82,14 +83,15 @@ namespace eobsws::storage {
          */
         lv_fs_res_t read_cb(void * file_p, void * buf, uint32_t btr, uint32_t * br) override {
             auto f = reinterpret_cast<File*>(file_p);
-            ESP_LOGI("PartitionLVGL", "reading %d bytes from file with descriptor 0x%x", btr, (int)f);
-            auto rd = f->read(btr);
-            if (rd.size() > 0) {
-                *br = rd.size();
-                std::copy(rd.begin(), rd.end(), reinterpret_cast<char*>(buf));
-                return LV_FS_RES_OK;
+            ESP_LOGD("PartitionLVGL", "reading %d bytes from file with descriptor 0x%x", btr, (int)f);
+            // data goes straight to LVGL's buffer; fewer bytes at end of file isn't an error
+            auto nread = f->read_into(buf, btr);
+            if (nread == static_cast<size_t>(-1)) {
+                *br = 0;
+                return LV_FS_RES_HW_ERR;
             }
-            return LV_FS_RES_UNKNOWN;
+            *br = nread;
+            return LV_FS_RES_OK;
         }
 
         /** \fn lv_fs_res_t write_cb(void * file_p, const void * buf, uint32_t btw, uint32_t * bw)
@@ -102,10 +104,15 @@ namespace eobsws::storage {
          */
         lv_fs_res_t write_cb(void * file_p, const void * buf, uint32_t btw, uint32_t * bw) override {
             auto f = reinterpret_cast<File*>(file_p);
-            ESP_LOGI("PartitionLVGL", "writing %d bytes to file with descriptor 0x%x", btw, (int)f);
-            *bw = f->write(std::string(reinterpret_cast<const char*>(buf), btw));
-            if (*bw == btw) return LV_FS_RES_OK;
-            return LV_FS_RES_UNKNOWN;
+            ESP_LOGD("PartitionLVGL", "writing %d bytes to file with descriptor 0x%x", btw, (int)f);
+            auto nwritten = f->write(buf, btw);
+            if (nwritten == static_cast<size_t>(-1)) {
+                *bw = 0;
+                return LV_FS_RES_HW_ERR;
+            }
+            *bw = nwritten;
+            if (nwritten == btw) return LV_FS_RES_OK;
+            return LV_FS_RES_FULL;
         }
 
         /** \fn lv_fs_res_t seek_cb(void * file_p, uint32_t pos, lv_fs_whence_t whence)
@@ -118,7 +125,7 @@ namespace eobsws::storage {
          */
         lv_fs_res_t seek_cb(void * file_p, uint32_t pos, lv_fs_whence_t whence) override {
             auto f = reinterpret_cast<File*>(file_p);
-            ESP_LOGI("PartitionLVGL", "moving to position %d in file with descriptor 0x%x", pos, (int)f);
+            ESP_LOGD("PartitionLVGL", "moving to position %d in file with descriptor 0x%x", pos, (int)f);
             if (f->seek(pos, static_cast<int>(whence))) return LV_FS_RES_OK;
             return LV_FS_RES_UNKNOWN;
         }
@@ -131,10 +138,11 @@ namespace eobsws::storage {
          */
         lv_fs_res_t tell_cb(void * file_p, uint32_t * pos_p) override {
             auto f = reinterpret_cast<File*>(file_p);
-            ESP_LOGI("PartitionLVGL", "getting position in file with descriptor 0x%x", (int)f);
-            *pos_p = f->get_pos();
-            if (*pos_p>=0) return LV_FS_RES_OK;
-            return LV_FS_RES_UNKNOWN;
+            ESP_LOGD("PartitionLVGL", "getting position in file with descriptor 0x%x", (int)f);
+            auto pos = f->get_pos();
+            if (pos < 0) return LV_FS_RES_UNKNOWN;
+            *pos_p = pos;
+            return LV_FS_RES_OK;
         }
 
         /** \fn void * dir_open_cb(const char * path)
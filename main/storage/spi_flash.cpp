@@ -11,6 +11,7 @@
 #include "vfs_fat_internal.h"
 
 #include "spi_flash.h"
+#include "block_cache.h"
 
 namespace eobsws::storage {
 
@@ -74,6 +75,10 @@ namespace eobsws::storage {
         esp_vfs_fat_spiflash_unmount(this->mount_path.c_str(), this->wl_handle);
     if (err == ESP_OK) {
       this->mounted = false;
+#if CONFIG_FILE_READ_CACHE
+      // partition may be formatted or replaced before next mount
+      BlockCache::shared().clear();
+#endif
       ESP_LOGI("SPIFlash", "unmounting %s succeeded", this->mount_path.c_str());
       return true;
     } else {
@@ -131,6 +136,9 @@ namespace eobsws::storage {
     }
     auto full_path = this->get_full_path(file_path);
     int result = ::remove(full_path.c_str());
+#if CONFIG_FILE_READ_CACHE
+    BlockCache::shared().invalidate(full_path);
+#endif
     return (result == 0);
   }
 
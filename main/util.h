@@ -3,46 +3,58 @@
  */
 #pragma once
 #include <string>
+#include <string_view>
+#include <charconv>
 #include <algorithm>
 #include <tuple>
 
 #include "esp_system.h"
 
-/** \fn static std::string trim_string(std::string str)
+/** \fn static std::string_view trim_string(std::string_view str)
  *  \brief Trims a string from white spaces in the beginning and end.
  *  \param str: input string.
- *  \returns trimmed string (trimmed copy of input).
+ *  \returns trimmed string (view on input, which must outlive it).
  */
-static std::string trim_string(std::string str) {
-    return str;
-    auto f = [](auto & c) -> bool { return isspace(c); };
-    // trim beginning
-    str.erase(str.begin(), std::find_if(str.begin(), str.end(), f));
-    // trim end
-    str.erase(std::find_if(str.rbegin(), str.rend(), f).base(), str.end());
-
+static std::string_view trim_string(std::string_view str) {
+    while (!str.empty() && isspace(static_cast<unsigned char>(str.front())))
+        str.remove_prefix(1);
+    while (!str.empty() && isspace(static_cast<unsigned char>(str.back())))
+        str.remove_suffix(1);
     return str;
 }
 
-/** \fn static bool is_numeric(const std::string & numstr)
+/** \fn static bool is_numeric(std::string_view numstr)
  *  \brief Tells if string represents a number.
  *  \param numstr: input string.
  *  \returns true if string represents a number, false otherwise.
  */
-static bool is_numeric(const std::string & numstr) {
-    const std::string nums = "-.0123456789";
-    return std::all_of(numstr.begin(), numstr.end(), [nums](const char & c) -> bool { return nums.find_first_of(c)!=std::string::npos;});
+static bool is_numeric(std::string_view numstr) {
+    const std::string_view nums = "-.0123456789";
+    return std::all_of(numstr.begin(), numstr.end(), [nums](const char & c) -> bool { return nums.find(c)!=std::string_view::npos;});
+}
+
+/** \fn template<typename T> static T to_int(std::string_view numstr)
+ *  \brief Converts a string to an integer, without allocating memory. Conversion stops
+ *  at the first character that isn't a digit.
+ *  \param numstr: input string.
+ *  \returns converted value, or 0 if string doesn't start with a number.
+ */
+template<typename T = int> static T to_int(std::string_view numstr) {
+    T value = 0;
+    std::from_chars(numstr.data(), numstr.data() + numstr.size(), value);
+    return value;
 }
 
-/** \fn static std::tuple<std::string, std::string> split_first(const std::string & str, std::string dlm)
+/** \fn static std::tuple<std::string_view, std::string_view> split_first(std::string_view str, std::string_view dlm)
  *  \brief Splits the string at the first found delimiter.
  *  \param str: input string.
  *  \param dlm: delimiter.
- *  \returns two strings, one contains the part of the string before delimiter, the other the part after.
+ *  \returns two strings, one contains the part of the string before delimiter, the other the part after;
+ *  both are views on input, which must outlive them.
  */
-static std::tuple<std::string, std::string> split_first(const std::string & str, std::string dlm) {
+static std::tuple<std::string_view, std::string_view> split_first(std::string_view str, std::string_view dlm) {
     auto p = str.find_first_of(dlm);
-    if (p==std::string::npos) return {"", ""};
+    if (p==std::string_view::npos) return {"", ""};
     return {str.substr(0,p), str.substr(p+1)};
 }
 
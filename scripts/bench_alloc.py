@@ -0,0 +1,79 @@
+#!python3
+'''This script measures memory allocations and round-trip time of serial commands.
+Each command is sent a number of times; after each, AT+GETALLOCS gives the number of
+heap allocations made while it was processed. Firmware must be built with allocation
+tracing (see README). Commands can be given on the command line; by default, a set of
+read-only commands is used:
+    - AT+GETBUFS, AT+GETFWVER, AT+GETSTATS
+    - AT+GETCONF on a string key and on a numeric key
+    - AT+LISTDIR on root folder, with pages of 8 entries
+Run the script with -h to see detailed usage instructions.
+'''
+from mcp2221 import find_devices
+from device import Device
+import sys, getopt
+import time
+
+err = False # set to True if and error occurs
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:],"hd:n:",["devidx=","repeat="])
+except getopt.GetoptError:
+    err = True
+
+# default values
+devidx = None # device index
+repeat = 20 # number of runs per command
+commands = ["AT+GETBUFS",
+            "AT+GETFWVER",
+            "AT+GETSTATS",
+            "AT+GETCONF=wifi,ssid",
+            "AT+GETCONF=screen,orientation",
+            "AT+LISTDIR=,8"]
+
+for opt, arg in opts:
+    try:
+        if opt in ("-d", "--devidx"):
+            devidx = int(arg)
+        elif opt in ("-n", "--repeat"):
+            repeat = int(arg)
+        elif opt == "-h":
+            err = True
+    except ValueError:
+        err = True
+
+if len(args) > 0:
+    commands = args
+
+if err:
+    print("Usage: {scrname} -d devidx -n repeat [command ...]".format(scrname=sys.argv[0]))
+    print("Optional arguments:")
+    print("  -h                           display help")
+    print("  -d devidx, --devidx=devidx   take device with index devidx")
+    print("  -n count, --repeat=count     number of runs per command (default: 20)")
+    print("  command ...                  commands to measure (default: a set of read-only commands)")
+    sys.exit(2)
+
+dev = Device(find_devices()[devidx]) if devidx is not None else Device()
+if dev._ser is None:
+    print("No device found.")
+    sys.exit(1)
+if dev.get_alloc_count() is None:
+    print("Firmware doesn't count allocations; enable it in menuconfig.")
+    sys.exit(1)
+
+print("{c:32s} {a:>8s} {m:>8s} {t:>10s}".format(c="command", a="allocs", m="max", t="rtt (ms)"))
+for cmd in commands:
+    allocs = []
+    times = []
+    for n in range(repeat):
+        t0 = time.perf_counter()
+        dev._serial_ask(cmd.encode("utf-8"))
+        times.append(time.perf_counter() - t0)
+        allocs.append(dev.get_alloc_count())
+        # multi-step commands are ended, so that each run starts from default state
+        dev._serial_ask(b"AT+ABORT")
+    # first run may allocate buffers kept for later runs
+    steady = allocs[1:] if len(allocs) > 1 else allocs
+    print("{c:32s} {a:8.1f} {m:8d} {t:10.2f}".format(
+        c=cmd, a=sum(steady)/len(steady), m=max(allocs), t=1000*sorted(times)[len(times)//2]))
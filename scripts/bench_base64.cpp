@@ -0,0 +1,115 @@
+/** \file bench_base64.cpp
+ *  \brief Host benchmark of firmware base64 codec against mbedtls.
+ *  It checks that both give the same results on random data of every length up to
+ *  a few blocks, then measures throughput on chunks of the size used by AT+PUTDATA
+ *  and AT+GETDATA. mbedtls is measured with direct calls, and with the allocations of
+ *  a vector and a string per chunk that firmware used to make around it.
+ *  Build and run from scripts folder (mbedtls development files required):
+ *      g++ -O2 -std=c++17 -I../main bench_base64.cpp ../main/comm/parser/base64.cpp -lmbedcrypto -o bench_base64
+ *      ./bench_base64 [total size in bytes] [chunk size in bytes]
+ *  Target throughput is measured end to end with bench_transfer.py (text mode).
+ *
+ *  Author: Vincent Paeder
+ *  License: MIT
+ */
+#include "comm/parser/base64.h"
+#include <mbedtls/base64.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace eobsws::comm::parser;
+
+/** \fn static double measure(size_t total, size_t chunk, F && run)
+ *  \brief Run a function on successive chunks and compute throughput.
+ *  \param total: number of bytes to process.
+ *  \param chunk: chunk size.
+ *  \param run: function processing chunk at given offset.
+ *  \returns throughput in MB/s.
+ */
+template<typename F> static double measure(size_t total, size_t chunk, F && run) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos + chunk <= total; pos += chunk)
+        run(pos);
+    std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+    return total/dt.count()/1e6;
+}
+
+int main(int argc, char ** argv) {
+    size_t total = argc > 1 ? strtoul(argv[1], nullptr, 10) : 64 << 20;
+    size_t chunk = argc > 2 ? strtoul(argv[2], nullptr, 10) : 756; // 1008 characters
+    chunk -= chunk % 3; // chunks of whole words, as firmware uses
+    std::mt19937 rng(42);
+    std::vector<uint8_t> data(total + 2*chunk);
+    for (auto & byte: data) byte = static_cast<uint8_t>(rng());
+
+    // check codec against mbedtls
+    std::vector<char> encoded(base64::encoded_size(data.size()) + 1);
+    std::vector<uint8_t> decoded(data.size());
+    std::vector<unsigned char> reference(encoded.size());
+    for (size_t len = 0; len < 3*chunk; len++) {
+        size_t ref_len, len_out;
+        auto n = base64::encode(data.data(), len, encoded.data());
+        mbedtls_base64_encode(reference.data(), reference.size(), &ref_len, data.data(), len);
+        if (n != ref_len || std::string(encoded.data(), n) != std::string(reference.begin(), reference.begin() + n)) {
+            printf("encoding mismatch at length %zu\n", len);
+            return 1;
+        }
+        if (!base64::decode(std::string_view(encoded.data(), n), decoded.data(), len_out)
+            || len_out != len || !std::equal(data.begin(), data.begin() + len, decoded.begin())) {
+            printf("decoding mismatch at length %zu\n", len);
+            return 1;
+        }
+    }
+    size_t len_out;
+    if (base64::decode("QUJD*A==", decoded.data(), len_out) || base64::decode("QUJ", decoded.data(), len_out)) {
+        printf("invalid input accepted\n");
+        return 1;
+    }
+
+    auto echunk = base64::encoded_size(chunk);
+    std::string text(encoded.data(), base64::encode(data.data(), total, encoded.data()));
+    printf("%zu bytes in chunks of %zu bytes (%zu characters)\n", total, chunk, echunk);
+    printf("%-24s %10s %10s\n", "codec", "encode", "decode");
+
+    auto enc = measure(total, chunk, [&](size_t pos) {
+        base64::encode(data.data() + pos, chunk, encoded.data());
+    });
+    auto dec = measure(total, chunk, [&](size_t pos) {
+        size_t len;
+        base64::decode(std::string_view(text).substr(pos/3*4, echunk), decoded.data(), len);
+    });
+    printf("%-24s %7.1f MB/s %7.1f MB/s\n", "firmware", enc, dec);
+
+    enc = measure(total, chunk, [&](size_t pos) {
+        size_t len;
+        mbedtls_base64_encode(reference.data(), echunk + 1, &len, data.data() + pos, chunk);
+    });
+    dec = measure(total, chunk, [&](size_t pos) {
+        size_t len;
+        mbedtls_base64_decode(decoded.data(), chunk, &len,
+                              reinterpret_cast<const unsigned char*>(text.data()) + pos/3*4, echunk);
+    });
+    printf("%-24s %7.1f MB/s %7.1f MB/s\n", "mbedtls", enc, dec);
+
+    enc = measure(total, chunk, [&](size_t pos) {
+        std::vector<unsigned char> out(echunk + 1);
+        size_t len;
+        mbedtls_base64_encode(out.data(), out.size(), &len, data.data() + pos, chunk);
+        volatile auto size = std::string(reinterpret_cast<char*>(out.data()), len).size();
+        (void)size;
+    });
+    dec = measure(total, chunk, [&](size_t pos) {
+        std::vector<unsigned char> out(chunk);
+        size_t len;
+        mbedtls_base64_decode(out.data(), out.size(), &len,
+                              reinterpret_cast<const unsigned char*>(text.data()) + pos/3*4, echunk);
+        volatile auto size = std::string(reinterpret_cast<char*>(out.data()), len).size();
+        (void)size;
+    });
+    printf("%-24s %7.1f MB/s %7.1f MB/s\n", "mbedtls + allocations", enc, dec);
+    return 0;
+}
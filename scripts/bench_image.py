@@ -0,0 +1,80 @@
+#!python3
+'''This script measures PNG image load time on device, with and without file block cache
+(AT+BENCHIMG). Each image is decoded several times in each mode: read directly from
+file system, read through an emptied cache (cold), and read through cache as left by
+previous load (warm). Besides load time, it reports number of file system reads, bytes
+read from file system, and cache hits and misses (cache blocks loaded from flash).
+Firmware must be built with image load benchmark (see README).
+Run the script with -h to see detailed usage instructions.
+'''
+from mcp2221 import find_devices
+from device import Device
+import sys, getopt
+
+err = False # set to True if and error occurs
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:],"hd:n:",["devidx=","count="])
+except getopt.GetoptError:
+    err = True
+
+# default values
+devidx = None # device index
+count = 10 # number of loads per image and mode
+# status icons, loaded at each start
+fpaths = ["images/wifi_{}.png".format(n) for n in range(4)] + ["images/battery_{}.png".format(n) for n in range(6)]
+
+for opt, arg in opts:
+    try:
+        if opt in ("-d", "--devidx"):
+            devidx = int(arg)
+        elif opt in ("-n", "--count"):
+            count = int(arg)
+        elif opt == "-h":
+            err = True
+    except ValueError:
+        err = True
+
+if len(args) > 0:
+    fpaths = args
+
+if err:
+    print("Usage: {scrname} -d devidx -n count [fpath ...]".format(scrname=sys.argv[0]))
+    print("Optional arguments:")
+    print("  -h                           display help")
+    print("  -d devidx, --devidx=devidx   take device with index devidx")
+    print("  -n count, --count=count      number of loads per image and mode (default: 10)")
+    print("  fpath ...                    image paths on device (default: status icons)")
+    sys.exit(2)
+
+dev = Device(find_devices()[devidx]) if devidx is not None else Device()
+if dev._ser is None:
+    print("No device found.")
+    sys.exit(1)
+
+
+def median(values:list) -> float:
+    """Gives median of a list of values."""
+    values = sorted(values)
+    return values[len(values)//2]
+
+
+modes = ((0, "direct"), (1, "cold cache"), (2, "warm cache"))
+print("{:<24} {:<10} {:>9} {:>9} {:>9} {:>7} {:>9} {:>6} {:>6}".format(
+    "image", "mode", "min (ms)", "median", "max", "reads", "bytes", "hits", "misses"))
+for fpath in fpaths:
+    for mode, name in modes:
+        results = []
+        for n in range(count):
+            res = dev.bench_image(fpath, mode)
+            if res is None: break
+            results.append(res)
+        if len(results) == 0:
+            # cache modes fail when firmware is built without cache
+            print("{:<24} {:<10} {:>9}".format(fpath, name, "-"))
+            continue
+        times = [r[0]/1000 for r in results]
+        # counters are the same at each load, except for first warm one
+        reads, nbytes, hits, misses = results[-1][1:]
+        print("{:<24} {:<10} {:9.2f} {:9.2f} {:9.2f} {:7d} {:9d} {:6d} {:6d}".format(
+            fpath, name, min(times), median(times), max(times), reads, nbytes, hits, misses))
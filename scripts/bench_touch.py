@@ -0,0 +1,186 @@
+#!python3
+'''This script measures input-to-OBS latency with synthetic input events (click storm).
+It runs a local obs-websocket stand-in, to which device must be configured to connect
+(websocket host set to this computer, no password), then injects touch events
+(AT+TOUCH) at a button position, or potentiometer values (AT+SETPOT) alternating
+between two values. For each event, it measures the time from injection command to
+arrival of the resulting request at the stand-in, and reads with AT+GETTRACE when the
+event reached each stage on device: input driver read, WebSocket queueing and WebSocket
+send. Buttons send their command when released, so touch delays include touch duration.
+Firmware must be built with input injection (see README).
+Run the script with -h to see detailed usage instructions.
+'''
+from mcp2221 import find_devices
+from device import Device
+from websocket_server import WebsocketServer
+import sys, getopt
+import json
+import threading
+import time
+
+err = False # set to True if and error occurs
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:],"hd:n:i:x:y:t:p:",
+                               ["devidx=","count=","interval=","x=","y=","duration=","pot=","host=","port="])
+except getopt.GetoptError:
+    err = True
+
+# default values
+devidx = None # device index
+count = 50 # number of events
+interval = 200 # minimum time between events, in ms
+x, y = 55, 54 # touch position (center of first button)
+duration = 50 # touch duration, in ms
+pot = None # potentiometer index; touch events are injected if None
+host = "0.0.0.0" # stand-in listening address
+port = 4455 # stand-in listening port
+timeout = 2.0 # time given to an event to reach stand-in, in s
+
+for opt, arg in opts:
+    try:
+        if opt in ("-d", "--devidx"):
+            devidx = int(arg)
+        elif opt in ("-n", "--count"):
+            count = int(arg)
+        elif opt in ("-i", "--interval"):
+            interval = int(arg)
+        elif opt in ("-x", "--x"):
+            x = int(arg)
+        elif opt in ("-y", "--y"):
+            y = int(arg)
+        elif opt in ("-t", "--duration"):
+            duration = int(arg)
+        elif opt in ("-p", "--pot"):
+            pot = int(arg)
+        elif opt == "--host":
+            host = arg
+        elif opt == "--port":
+            port = int(arg)
+        elif opt == "-h":
+            err = True
+    except ValueError:
+        err = True
+
+if err:
+    print("Usage: {scrname} -d devidx -n count -i interval (-x x -y y -t duration | -p pot)".format(scrname=sys.argv[0]))
+    print("Optional arguments:")
+    print("  -h                           display help")
+    print("  -d devidx, --devidx=devidx   take device with index devidx")
+    print("  -n count, --count=count      number of events (default: 50)")
+    print("  -i ms, --interval=ms         minimum time between events (default: 200)")
+    print("  -x x, --x=x                  touch X position (default: 55)")
+    print("  -y y, --y=y                  touch Y position (default: 54)")
+    print("  -t ms, --duration=ms         touch duration (default: 50)")
+    print("  -p idx, --pot=idx            inject values of potentiometer idx instead of touch events")
+    print("  --host=address               stand-in listening address (default: 0.0.0.0)")
+    print("  --port=port                  stand-in listening port (default: 4455)")
+    sys.exit(2)
+
+
+received = threading.Event() # set when a request reaches stand-in
+received_at = 0.0 # arrival time of last request
+
+def message_received(client, server, message):
+    """Stand-in callback: completes handshake, answers requests and records their arrival.
+
+    Parameters:
+        client: client instance
+        server: server instance
+        message: received message
+    """
+    global received_at
+    now = time.perf_counter()
+    try:
+        js = json.loads(message)
+    except ValueError:
+        return
+    if js.get("op") == 1: # Identify -> Identified
+        server.send_message(client, json.dumps({"op": 2, "d": {"negotiatedRpcVersion": 1}}))
+    elif js.get("op") in (6, 8): # Request or RequestBatch -> success
+        d = js.get("d", {})
+        req_id = d.get("requestId", "")
+        reply = {"op": 7 if js["op"] == 6 else 9,
+                 "d": {"requestType": d.get("requestType", ""), "requestId": req_id,
+                       "requestStatus": {"result": True, "code": 100}}}
+        server.send_message(client, json.dumps(reply))
+        # link probes aren't caused by injected events
+        if not req_id.startswith("eobsws-probe-"):
+            received_at = now
+            received.set()
+
+def new_client(client, server):
+    """Stand-in callback: sends Hello without authentication.
+
+    Parameters:
+        client: client instance
+        server: server instance
+    """
+    print("Device connected.")
+    server.send_message(client, json.dumps({"op": 0, "d": {"obsWebSocketVersion": "5.0.0", "rpcVersion": 1}}))
+
+server = WebsocketServer(host=host, port=port)
+server.set_fn_new_client(new_client)
+server.set_fn_message_received(message_received)
+server.run_forever(threaded=True)
+
+dev = Device(find_devices()[devidx]) if devidx is not None else Device()
+if dev._ser is None:
+    print("No device found.")
+    sys.exit(1)
+
+print("Waiting for device to connect on port {p}...".format(p=port))
+while len(server.clients) == 0:
+    time.sleep(0.1)
+time.sleep(1) # lets handshake complete
+
+
+def inject(n:int) -> bool:
+    """Injects event n."""
+    if pot is None:
+        return dev.touch(x, y, duration)
+    # alternates between values far enough apart to exceed pin tolerance
+    return dev.set_pot(pot, 100 if n % 2 else 900)
+
+
+def percentile(values:list, q:float) -> float:
+    """Gives percentile q of a list of values (nearest rank)."""
+    values = sorted(values)
+    return values[min(len(values) - 1, int(q*len(values)))]
+
+
+end_to_end = [] # host-measured latencies, in ms
+stages = ([], [], []) # device stage delays, in ms
+lost = 0
+for n in range(count):
+    received.clear()
+    t0 = time.perf_counter()
+    if not inject(n):
+        print("Event injection failed; is firmware built with input injection?")
+        break
+    if not received.wait(timeout):
+        lost += 1
+    else:
+        end_to_end.append((received_at - t0)*1000)
+        # send stage is stamped right after transmission; it may lag arrival slightly
+        for retry in range(10):
+            delays = dev.get_trace()
+            if delays is None or delays[-1] is not None: break
+            time.sleep(0.01)
+        if delays is not None:
+            for stage, d in zip(stages, delays):
+                if d is not None: stage.append(d/1000)
+    time.sleep(max(0, interval/1000 - (time.perf_counter() - t0)))
+
+if pot is not None:
+    dev.set_pot(pot)
+server.shutdown_gracefully()
+
+print("{n} events, {lost} lost".format(n=len(end_to_end) + lost, lost=lost))
+print("{:<24} {:>9} {:>9} {:>9} {:>9}".format("stage (ms)", "min", "median", "p95", "max"))
+for name, values in zip(("driver read", "WebSocket queued", "WebSocket sent", "host end to end"), stages + (end_to_end,)):
+    if len(values) == 0:
+        print("{:<24} {:>9}".format(name, "-"))
+        continue
+    print("{:<24} {:9.2f} {:9.2f} {:9.2f} {:9.2f}".format(name, min(values), percentile(values, 0.5),
+                                                          percentile(values, 0.95), max(values)))
@@ -0,0 +1,103 @@
+#!python3
+'''This script measures file transfer throughput between host and device.
+It uploads an image set (1 MB of generated data by default, or the files of a local
+directory) with each transfer mode, reads it back, checks content and prints throughput:
+    - text: base64 commands (AT+PUTFILE/AT+GETFILE)
+    - binary: binary frames, one at a time
+    - window=n: binary frames, with n frames in flight
+    - window=n,z: same, with data compressed when it helps (generated data doesn't compress)
+    - push: uploads as window=n, reads back with the device streaming files unasked
+Files are written to a temporary folder on device, which is deleted afterwards.
+Run the script with -h to see detailed usage instructions.
+'''
+from mcp2221 import find_devices
+from device import Device
+import os
+import sys, getopt
+import time
+
+err = False # set to True if and error occurs
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:],"hd:i:w:",["devidx=","idir=","windows=","size=","count="])
+except getopt.GetoptError:
+    err = True
+
+# default values
+devidx = None # device index
+idir = None # local directory with images
+windows = [2, 4, 8] # window sizes to test
+total_size = 1 << 20 # total size of generated image set
+count = 16 # number of generated files
+dev_dir = "bench" # temporary folder on device
+
+for opt, arg in opts:
+    try:
+        if opt in ("-d", "--devidx"):
+            devidx = int(arg)
+        elif opt in ("-i", "--idir"):
+            idir = arg
+        elif opt in ("-w", "--windows"):
+            windows = [int(w) for w in arg.split(",")]
+        elif opt == "--size":
+            total_size = int(arg)
+        elif opt == "--count":
+            count = int(arg)
+        elif opt == "-h":
+            err = True
+    except ValueError:
+        err = True
+
+if err:
+    print("Usage: {scrname} -d devidx -i idir -w windows".format(scrname=sys.argv[0]))
+    print("Optional arguments:")
+    print("  -h                           display help")
+    print("  -d devidx, --devidx=devidx   take device with index devidx")
+    print("  -i idir, --idir=idir         upload files of directory idir instead of generated data")
+    print("  -w list, --windows=list      comma-separated window sizes to test (default: 2,4,8)")
+    print("  --size=bytes                 total size of generated data (default: 1048576)")
+    print("  --count=n                    number of generated files (default: 16)")
+    sys.exit(2)
+
+dev = Device(find_devices()[devidx]) if devidx is not None else Device()
+if dev._ser is None:
+    print("No device found.")
+    sys.exit(1)
+dev._buf_size = dev._get_buffer_size() or dev._buf_size
+
+if idir is not None:
+    files = {}
+    for name in sorted(os.listdir(idir)):
+        path = os.path.join(idir, name)
+        if os.path.isfile(path):
+            with open(path, "rb") as f:
+                files[name] = f.read()
+else:
+    files = {"img{}.png".format(n): os.urandom(total_size//count) for n in range(count)}
+nbytes = sum(len(data) for data in files.values())
+print("{n} files, {b} bytes, serial buffer {s} bytes".format(n=len(files), b=nbytes, s=dev._buf_size))
+
+modes = [("text", dict(binary=False, compress=False)), ("binary", dict(window=0, compress=False, push=False))]
+modes += [("window={}".format(w), dict(window=w, compress=False, push=False)) for w in windows]
+# compression only applies to uploads, and only if data is compressible
+modes += [("window={},z".format(windows[-1]), dict(window=windows[-1], push=False))]
+# push mode only applies to downloads
+modes += [("push", dict(window=windows[-1], compress=False, push=True))]
+
+dev.make_dir(dev_dir)
+for name, kwargs in modes:
+    t0 = time.perf_counter()
+    put_kwargs = {k: v for k, v in kwargs.items() if k != "push"}
+    ok = all(dev.put_file(data, dev_dir + "/" + fname, **put_kwargs) for fname, data in files.items())
+    t_put = time.perf_counter() - t0
+    t0 = time.perf_counter()
+    get_kwargs = {k: v for k, v in kwargs.items() if k != "compress"}
+    same = all(dev.get_file(dev_dir + "/" + fname, **get_kwargs) == data for fname, data in files.items())
+    t_get = time.perf_counter() - t0
+    print("{m:10s}: put {p:7.1f} kB/s{pe}, get {g:7.1f} kB/s{ge}".format(
+        m=name, p=nbytes/t_put/1024, pe="" if ok else " (failed)",
+        g=nbytes/t_get/1024, ge="" if same else " (mismatch)"))
+
+for fname in files:
+    dev.delete(dev_dir + "/" + fname)
+dev.delete(dev_dir)
@@ -0,0 +1,65 @@
+#!python3
+'''This script saves the configuration of a device to a file, or writes it from a file,
+so that a setup can be backed up or cloned to other devices. All namespaces and keys
+go in one compact blob, transferred in a single exchange (AT+DUMPCONF/AT+LOADCONF).
+Image files referred to by configuration aren't included; use write_config.py for them.
+Run the script with -h to see detailed usage instructions.
+'''
+from mcp2221 import find_devices
+from device import Device
+import sys, getopt
+
+err = False # set to True if and error occurs
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:],"hd:o:i:",["devidx=","ofile=","ifile="])
+except getopt.GetoptError:
+    err = True
+
+# default values
+devidx = None # device index
+ofile = None # file receiving configuration
+ifile = None # file holding configuration to write
+
+for opt, arg in opts:
+    try:
+        if opt in ("-d", "--devidx"):
+            devidx = int(arg)
+        elif opt in ("-o", "--ofile"):
+            ofile = arg
+        elif opt in ("-i", "--ifile"):
+            ifile = arg
+        elif opt == "-h":
+            err = True
+    except ValueError:
+        err = True
+
+if err or (ofile is None) == (ifile is None):
+    print("Usage: {scrname} -d devidx (-o ofile | -i ifile)".format(scrname=sys.argv[0]))
+    print("Optional arguments:")
+    print("  -h                           display help")
+    print("  -d devidx, --devidx=devidx   take device with index devidx")
+    print("  -o fname, --ofile=fname      save device configuration to file fname")
+    print("  -i fname, --ifile=fname      write configuration saved in file fname to device")
+    sys.exit(2)
+
+dev = Device(find_devices()[devidx]) if devidx is not None else Device()
+if dev._ser is None:
+    print("No device found.")
+    sys.exit(1)
+
+if ofile is not None:
+    blob = dev.dump_conf()
+    if blob is None:
+        print("Couldn't read configuration.")
+        sys.exit(1)
+    with open(ofile, "wb") as f:
+        f.write(blob)
+    print("Saved {n} bytes of configuration to {f}.".format(n=len(blob), f=ofile))
+else:
+    with open(ifile, "rb") as f:
+        blob = f.read()
+    if not dev.load_conf(blob):
+        print("Couldn't write configuration.")
+        sys.exit(1)
+    print("Wrote {n} bytes of configuration to device.".format(n=len(blob)))
@@ -7,6 +7,9 @@ from mcp2221.enums import GPIODirection, GPIO1Function, GPIO3Function, MemoryTyp
 from serial.tools.list_ports import comports
 from serial import Serial
 import base64
+import hashlib
+import zlib
+import struct
 import enum
 
 __all__ = ["NVSType", "Device"]
@@ -30,18 +33,32 @@ class Device():
     
     Attributes:
         _termchar(byte): termination character for serial communication
+        _stx(byte): start byte of binary frames
         _buf_size(int): serial buffer size, in bytes
+        _max_retries(int): number of times a corrupted binary frame is sent again
+        _baud_rates(list): baud rates tried when opening device, fastest first
+        _baud_timeout(float): time after which device reverts an unconfirmed baud rate switch, in seconds
+        _inflate_window_bits(int): compression window bits (must not exceed device's decompression window)
+        _conf_batch(bool): True if configuration keys are being batched
     """
 
     _termchar = b'\r'
+    _stx = b'\x02'
     _buf_size = 1024
+    _max_retries = 3
+    _baud_rates = [921600, 460800]
+    _baud_timeout = 1.0
+    _inflate_window_bits = 12
+    _conf_batch = False
 
-    def __init__(self, desc:dict=None):
+    def __init__(self, desc:dict=None, baud_rates:list=None):
         """Constructor.
         
         Parameters:
             desc(dict): device descriptor (default:None). If None, first device found
                         will be opened.
+            baud_rates(list): baud rates to negotiate with device, fastest first
+                              (default: None, use _baud_rates); [] keeps 115200 baud.
         """
         if desc == None:
             try:
@@ -54,6 +71,7 @@ class Device():
         if ser_port is not None:
             self._ser = Serial(ser_port, 115200)
             self._ser.timeout = 0.5
+            self.negotiate_baud_rate(self._baud_rates if baud_rates is None else baud_rates)
         else:
             self._ser = None
 
@@ -78,6 +96,10 @@ class Device():
         self.dev.gpio3_function = GPIO3Function.GPIO
         self.dev.gpio3_direction = GPIODirection.Output
         self.dev.gpio3_value = False
+        # firmware restarts at default baud rate
+        if self._ser is not None:
+            self._ser.baudrate = 115200
+            self._ser.rtscts = False
     
     def enable_esp32(self) -> None:
         """Turns ESP32 on.
@@ -182,6 +204,146 @@ class Device():
             return self._serial_read(nbytes)
         return b""
 
+    def _encode_frame(self, payload:bytes) -> bytes:
+        """Packs data into a binary frame.
+        
+        Parameters:
+            payload(bytes): frame payload.
+        
+        Returns:
+            bytes: frame.
+        """
+        return self._stx + len(payload).to_bytes(2, "little") + payload \
+               + zlib.crc32(payload).to_bytes(4, "little")
+
+    def _serial_read_frame(self) -> bytes:
+        """Reads a binary frame from serial port. Bytes preceding the frame are skipped.
+        
+        Returns:
+            bytes: frame payload, or None if no valid frame was received.
+        """
+        if self._ser is None: return None
+        if not self._ser.read_until(self._stx).endswith(self._stx): return None
+        size = self._ser.read(2)
+        if len(size) != 2: return None
+        size = int.from_bytes(size, "little")
+        frame = self._ser.read(size + 4)
+        if len(frame) != size + 4: return None
+        payload = frame[:size]
+        if zlib.crc32(payload) != int.from_bytes(frame[size:], "little"): return None
+        return payload
+
+    def _serial_read_frames(self) -> bytes:
+        """Reads binary frames from serial port until an empty frame.
+        
+        Returns:
+            bytes: concatenated frame payloads, or None if a frame was lost or corrupted.
+        """
+        chunks = []
+        while True:
+            chunk = self._serial_read_frame()
+            if chunk is None: return None
+            if len(chunk)==0: return b"".join(chunks)
+            chunks.append(chunk)
+
+    def _abort_frames(self) -> None:
+        """Stops a stream of binary frames sent by device after a transfer error.
+        Device ends stream with an empty frame, then replies to AT+ABORT.
+        """
+        self._serial_write(b"AT+ABORT")
+        for n in range(self._max_retries):
+            chunk = self._serial_read_frame()
+            if chunk is not None and len(chunk)==0: break
+        self._serial_read_line()
+
+    def _serial_ask_frame(self, payload:bytes) -> bytes:
+        """Sends a binary frame and reads response.
+        
+        Parameters:
+            payload(bytes): frame payload.
+        
+        Returns:
+            bytes: response.
+        """
+        if self._ser is not None:
+            self._ser.write(self._encode_frame(payload))
+            self._ser.flushOutput()
+            return self._serial_read()
+        return b""
+
+    def _serial_read_line(self) -> bytes:
+        """Reads a reply line from serial port, dropping log output that may precede it.
+        
+        Returns:
+            bytes: reply, or None if nothing came before timeout.
+        """
+        if self._ser is None: return None
+        line = self._ser.read_until(self._termchar)
+        if not line.endswith(self._termchar): return None
+        return line.rsplit(b"\n", 1)[-1]
+
+    def _serial_ask_reply(self, cmd:bytes) -> bytes:
+        """Sends a serial command and waits for a reply (OK, ERROR or UNKN), skipping
+        any other output. Unlike _serial_ask, it gives up when nothing comes.
+        
+        Parameters:
+            cmd(bytes): command to write.
+        
+        Returns:
+            bytes: reply, or None if none came before timeout.
+        """
+        self._serial_write(cmd)
+        while True:
+            line = self._serial_read_line()
+            if line is None: return None
+            if line.startswith((b"OK", b"ERROR", b"UNKN")): return line
+
+    def set_baud_rate(self, baud_rate:int, flow_control:bool=False) -> bool:
+        """Switches serial link to another baud rate. Device replies at current rate,
+        switches, and waits for confirmation at new rate; if it doesn't come,
+        both sides go back to current rate.
+        
+        Parameters:
+            baud_rate(int): baud rate.
+            flow_control(bool): enable RTS/CTS flow control; device must have RTS
+                                and CTS pins connected (default: False).
+        
+        Returns:
+            bool: True if link runs at new baud rate, False otherwise.
+        """
+        if self._ser is None: return False
+        cmd = "AT+SETBAUD={rate},{flow}".format(rate=baud_rate, flow=int(flow_control)).encode("utf-8")
+        ret = self._serial_ask_reply(cmd)
+        if ret is None or ret.find(b"OK")!=0: return False
+        previous = (self._ser.baudrate, self._ser.rtscts)
+        self._ser.baudrate = baud_rate
+        self._ser.rtscts = flow_control
+        self._ser.reset_input_buffer()
+        # probe: reply comes at new rate only if both sides switched
+        ret = self._serial_ask_reply(b"AT+BAUDOK")
+        if ret is not None and ret.find(b"OK")==0:
+            return True
+        self._ser.baudrate, self._ser.rtscts = previous
+        sleep(self._baud_timeout) # let device revert
+        self._ser.reset_input_buffer()
+        return False
+
+    def negotiate_baud_rate(self, baud_rates:list, flow_control:bool=False) -> int:
+        """Switches serial link to the fastest baud rate that works.
+        
+        Parameters:
+            baud_rates(list): baud rates to try.
+            flow_control(bool): enable RTS/CTS flow control (default: False).
+        
+        Returns:
+            int: baud rate in use.
+        """
+        if self._ser is None: return 0
+        for baud_rate in sorted(baud_rates, reverse=True):
+            if baud_rate <= self._ser.baudrate: break
+            if self.set_baud_rate(baud_rate, flow_control): break
+        return self._ser.baudrate
+
     def _test_reply(self, resp:bytes) -> bool:
         """Tests if response is valid.
         
@@ -218,6 +380,10 @@ class Device():
         Returns:
             list[list]: a list of file and directory names.
         """
+        info = self.list_dir_info(dir_path)
+        if info is not None:
+            return [[name, ftype] for name, ftype, _, _ in info]
+        # firmware without paged listing
         cmd = "AT+LISTDIR={}".format(dir_path).encode("utf-8")
         nf_str = self._serial_ask(cmd)
         if nf_str.find(b"NUMFILES=")!=0:
@@ -232,15 +398,170 @@ class Device():
             numfiles-=1
         return files
     
-    def get_file(self, file_path:str) -> bytes:
+    def list_dir_info(self, dir_path: str) -> 'list[tuple]':
+        """Lists the content of a directory with file metadata. Device sends as many
+        entries per reply as fit in its serial buffer.
+        
+        Parameters:
+            dir_path(str): path to list content.
+        
+        Returns:
+            list[tuple]: (name, type, size, mtime) for each entry, with type=1 for files
+                         and 2 for directories, or None if directory doesn't exist or
+                         device doesn't support paged listing.
+        """
+        # requested page size is capped by device buffer size
+        cmd = "AT+LISTDIR={},255".format(dir_path).encode("utf-8")
+        ret = self._serial_ask(cmd, 1 << 16)
+        entries = []
+        while ret.find(b"FILES=")==0:
+            fields = ret.split(b"=",1)[-1].rstrip(b"\r\n").split(b"/")
+            for item in fields[1:]:
+                ftype, size, mtime, name = item.split(b",",3)
+                entries.append((name, int(ftype), int(size), int(mtime)))
+            if int(fields[0]) == 0:
+                return entries
+            ret = self._serial_ask(b"AT+NEXTFILE", 1 << 16)
+        return None
+    
+    def _get_file_bin(self, file_path:str, window:int=0) -> bytes:
+        """Gets a file from device with binary frames.
+        
+        Parameters:
+            file_path(str): path to file.
+            window(int): number of blocks requested ahead (default: 0, one at a time).
+        
+        Returns:
+            bytes: file content, or None if device doesn't support binary transfers.
+        """
+        cmd = "AT+GETBIN={}".format(file_path)
+        if window > 0:
+            cmd += ",{}".format(window)
+        nb_str = self._serial_ask(cmd.encode("utf-8"))
+        if nb_str.find(b"UNKN")==0:
+            return None
+        if nb_str.find(b"SIZE=")!=0:
+            return b""
+        nbytes = int(nb_str.split(b"=",1)[-1].strip())
+        if window > 0:
+            data = self._get_blocks_windowed(nbytes, window)
+        else:
+            data = self._get_blocks(nbytes)
+        if data is None:
+            self._serial_ask(b"AT+ABORT")
+            return b""
+        self._serial_ask(b"AT+GETBLK=0")
+        return data
+
+    def _get_blocks(self, nbytes:int) -> bytes:
+        """Gets blocks of file opened with AT+GETBIN, one at a time.
+        
+        Parameters:
+            nbytes(int): file size.
+        
+        Returns:
+            bytes: file content, or None if transfer failed.
+        """
+        data = b""
+        request = "AT+GETBLK={}".format(self._buf_size).encode("utf-8")
+        retries = 0
+        while len(data)<nbytes:
+            # corrupted or lost frames are requested again
+            self._serial_write(request if retries==0 else b"AT+GETBLK=R")
+            chunk = self._serial_read_frame()
+            if chunk is None:
+                retries += 1
+                if retries > self._max_retries: return None
+                continue
+            if len(chunk)==0: break # end of file
+            retries = 0
+            data += chunk
+        return data
+
+    def _get_blocks_windowed(self, nbytes:int, window:int) -> bytes:
+        """Gets blocks of file opened with AT+GETBIN in windowed mode. Up to *window*
+        requests are sent ahead; lost or corrupted blocks are requested again by
+        sequence number.
+        
+        Parameters:
+            nbytes(int): file size.
+            window(int): number of blocks requested ahead.
+        
+        Returns:
+            bytes: file content, or None if transfer failed.
+        """
+        bsize = self._buf_size - 2 # payload starts with sequence number
+        nblocks = (nbytes + bsize - 1)//bsize
+        request = "AT+GETBLK={}".format(bsize).encode("utf-8")
+        blocks = {}
+        requested = 0
+        missing = 0 # first block not received yet
+        retries = 0
+        while missing < nblocks:
+            # device only keeps the last *window* blocks for retransmission
+            while requested < nblocks and requested - missing < window:
+                self._serial_write(request)
+                requested += 1
+            payload = self._serial_read_frame()
+            if payload is None or len(payload) < 2:
+                retries += 1
+                if retries > self._max_retries: return None
+                self._serial_write("AT+GETBLK=R,{}".format(missing & 0xffff).encode("utf-8"))
+                continue
+            retries = 0
+            seq = int.from_bytes(payload[:2], "little")
+            blocks[missing + ((seq - missing) & 0xffff)] = payload[2:]
+            while missing in blocks:
+                missing += 1
+        return b"".join(blocks[n] for n in range(nblocks))
+
+    def _get_file_push(self, file_path:str) -> bytes:
+        """Gets a file from device in push mode: device streams it as binary frames,
+        ending with an empty frame. A transfer error stops the stream with AT+ABORT.
+        
+        Parameters:
+            file_path(str): path to file.
+        
+        Returns:
+            bytes: file content, or None if push mode failed or isn't supported.
+        """
+        self._serial_write("AT+GETFILE={},push".format(file_path).encode("utf-8"))
+        nb_str = self._serial_read_line()
+        if nb_str is None or nb_str.find(b"SIZE=")!=0:
+            return None
+        nbytes = int(nb_str.split(b"=",1)[-1].strip())
+        data = self._serial_read_frames()
+        if data is not None:
+            if len(data)==nbytes:
+                return data
+            # stream cut short by a read error, which device reports after empty frame
+            self._serial_read_line()
+            return None
+        self._abort_frames()
+        return None
+
+    def get_file(self, file_path:str, binary:bool=True, window:int=4, push:bool=True) -> bytes:
         """Gets a file from device.
         
         Parameters:
             file_path(str): path to file.
+            binary(bool): use binary frames if device supports them (default: True).
+            window(int): number of binary blocks requested ahead (default: 4);
+                         0 waits for each block before requesting the next one.
+            push(bool): let device stream file without requests, if it supports it
+                        (default: True).
         
         Returns:
             bytes: file content.
         """
+        if binary and push:
+            data = self._get_file_push(file_path)
+            if data is not None:
+                return data
+        if binary:
+            data = self._get_file_bin(file_path, window)
+            if data is not None:
+                return data
         # tries to open file; if ok, returns SIZE=n
         cmd = "AT+GETFILE={}".format(file_path).encode("utf-8")
         nb_str = self._serial_ask(cmd)
@@ -259,21 +580,170 @@ class Device():
                 data += chunk[5:-1] # removes DATA= prefix and \n suffix
         return base64.decodebytes(data)
     
-    def put_file(self, data:bytes, file_path:str) -> bool:
+    def _put_file_bin(self, data:bytes, file_path:str, window:int=0, window_bits:int=0, offset:int=None) -> bool:
+        """Puts a file on device with binary frames.
+        
+        Parameters:
+            data(bytes): file content.
+            file_path(str): target path.
+            window(int): number of frames sent ahead of acknowledgments
+                         (default: 0, one at a time).
+            window_bits(int): compression window bits if data is a raw deflate stream
+                              (default: 0, not compressed).
+            offset(int): position in existing file where data is written, up to file size
+                         (default: None, file is replaced).
+        
+        Returns:
+            bool: True if transfer succeeded, False otherwise, or None if device
+                  doesn't support binary transfers.
+        """
+        cmd = "AT+PUTBIN={path},{len}".format(path=file_path, len=len(data))
+        if window > 0:
+            cmd += ",{}".format(window)
+        if window_bits > 0:
+            cmd += ",z{}".format(window_bits)
+        if offset is not None:
+            cmd += ",@{}".format(offset)
+        ret = self._serial_ask(cmd.encode("utf-8"))
+        if ret.find(b"UNKN")==0:
+            return None
+        return self._send_blocks(ret, data)
+
+    def _send_blocks(self, ret:bytes, data:bytes) -> bool:
+        """Sends data as binary frames once device accepted a binary transfer.
+        
+        Parameters:
+            ret(bytes): device reply to transfer command.
+            data(bytes): data to send.
+        
+        Returns:
+            bool: True if device received and stored all data, False otherwise.
+        """
+        if ret.find(b"BINMODE")!=0:
+            return False
+        if ret.find(b"BINMODE=")==0:
+            # device may accept a smaller window
+            self._put_blocks_windowed(data, int(ret.split(b"=",1)[-1].strip()))
+        else:
+            self._put_blocks(data)
+        # an empty frame ends transfer; device replies OK only if all data was written
+        return self._serial_ask_frame(b"").find(b"OK")==0
+
+    def _put_blocks(self, data:bytes) -> None:
+        """Sends file content as binary frames, one at a time.
+        
+        Parameters:
+            data(bytes): file content.
+        """
+        n0 = 0
+        retries = 0
+        while n0 < len(data):
+            chunk = data[n0:n0+self._buf_size]
+            ret = self._serial_ask_frame(chunk)
+            if ret.find(b"CRCERR")==0 and retries < self._max_retries:
+                retries += 1
+                continue
+            if not self._test_reply(ret) or ret.find(b"CRCERR")==0:
+                break
+            retries = 0
+            n0 += len(chunk)
+
+    def _put_blocks_windowed(self, data:bytes, window:int) -> None:
+        """Sends file content as sequence-numbered binary frames, with up to *window*
+        frames awaiting acknowledgment. Device acknowledges cumulatively (ACK=n,
+        n being the next frame it expects) and requests a missing frame once (NAK=n).
+        
+        Parameters:
+            data(bytes): file content.
+            window(int): number of frames sent ahead of acknowledgments.
+        """
+        bsize = self._buf_size - 2 # payload starts with sequence number
+        blocks = [data[n:n+bsize] for n in range(0, len(data), bsize)]
+        frame = lambda n: self._encode_frame((n & 0xffff).to_bytes(2, "little") + blocks[n])
+        acked = 0 # first frame not acknowledged yet
+        sent = 0
+        retries = 0
+        while acked < len(blocks):
+            while sent < len(blocks) and sent - acked < window:
+                self._ser.write(frame(sent))
+                sent += 1
+            self._ser.flushOutput()
+            ret = self._serial_read_line()
+            if ret is None:
+                # nothing comes back: first unacknowledged frame was lost
+                retries += 1
+                if retries > self._max_retries: return
+                self._ser.write(frame(acked))
+                continue
+            if ret.find(b"ACK=")==0 or ret.find(b"NAK=")==0:
+                n = acked + ((int(ret[4:].strip()) - acked) & 0xffff)
+                if n > sent: continue # stale reply
+                if n > acked: retries = 0
+                acked = n
+                if ret.find(b"NAK=")==0 and acked < len(blocks):
+                    self._ser.write(frame(acked))
+            elif not self._test_reply(ret):
+                return
+            # CRCERR is ignored: device reports gap with next frame, or times out
+
+    def put_file(self, data:bytes, file_path:str, binary:bool=True, window:int=4, compress:bool=True,
+                 offset:int=None) -> bool:
         """Puts a file on device.
         
         Parameters:
             data(bytes): file content.
             file_path(str): target path.
+            binary(bool): use binary frames if device supports them (default: True).
+            window(int): number of binary frames sent ahead of acknowledgments
+                         (default: 4); 0 waits for each acknowledgment.
+            compress(bool): send data as raw deflate stream if it gets smaller;
+                            device decompresses it on the fly (default: True).
+            offset(int): position in existing file where data is written, up to file size
+                         (default: None, file is replaced).
         
         Returns:
             bool: True if transfer succeeded, False otherwise.
         """
+        if compress:
+            packer = zlib.compressobj(9, zlib.DEFLATED, -self._inflate_window_bits)
+            packed = packer.compress(data) + packer.flush()
+            # already compressed content (e.g. PNG images) is sent as is;
+            # firmware without decompression rejects compressed transfers
+            if len(packed) < len(data) and \
+               self._put_file(packed, file_path, binary, window, self._inflate_window_bits, offset):
+                return True
+        return self._put_file(data, file_path, binary, window, 0, offset)
+
+    def _put_file(self, data:bytes, file_path:str, binary:bool, window:int, window_bits:int=0,
+                  offset:int=None) -> bool:
+        """Puts a file on device.
+        
+        Parameters:
+            data(bytes): file content.
+            file_path(str): target path.
+            binary(bool): use binary frames if device supports them.
+            window(int): number of binary frames sent ahead of acknowledgments.
+            window_bits(int): compression window bits if data is a raw deflate stream
+                              (default: 0, not compressed).
+            offset(int): position in existing file where data is written, up to file size
+                         (default: None, file is replaced).
+        
+        Returns:
+            bool: True if transfer succeeded, False otherwise.
+        """
+        if binary:
+            success = self._put_file_bin(data, file_path, window, window_bits, offset)
+            if success is not None:
+                return success
         # tries to open file; if ok, returns OK, otherwise ERROR
         b64data = base64.standard_b64encode(data)
         nbytes = len(b64data)
-        cmd = "AT+PUTFILE={path},{len}".format(path=file_path, len=nbytes).encode("utf-8")
-        if not self._test_reply(self._serial_ask(cmd)): return False
+        cmd = "AT+PUTFILE={path},{len}".format(path=file_path, len=len(data))
+        if window_bits > 0:
+            cmd += ",z{}".format(window_bits)
+        if offset is not None:
+            cmd += ",@{}".format(offset)
+        if not self._test_reply(self._serial_ask(cmd.encode("utf-8"))): return False
         # transfers data
         n0 = 0
         while nbytes:
@@ -291,6 +761,93 @@ class Device():
             nbytes -= csize
         return True
 
+    def hash_file(self, file_path:str, block_size:int=0) -> tuple:
+        """Gets SHA-256 hash of a file on device.
+        
+        Parameters:
+            file_path(str): path to file.
+            block_size(int): if non-zero, also get hashes of blocks of this size (default: 0).
+        
+        Returns:
+            tuple: file size, file hash and list of block hashes (hexadecimal strings),
+                   or None if file doesn't exist or device doesn't support hashing.
+        """
+        cmd = "AT+HASHFILE={}".format(file_path)
+        if block_size > 0:
+            cmd += ",{}".format(block_size)
+        ret = self._serial_ask(cmd.encode("utf-8"))
+        if ret.find(b"HASH=")!=0:
+            return None
+        fields = ret.split(b"=",1)[-1].strip().decode("utf-8").split(",")
+        size, digest = int(fields[0]), fields[1]
+        blocks = []
+        if block_size > 0:
+            nblocks = int(fields[2])
+            # as many hashes per request as fit in a read
+            count = (1024 - len("HASH=")) // 65
+            while len(blocks) < nblocks:
+                ret = self._serial_ask("AT+NEXTHASH={}".format(count).encode("utf-8"))
+                if ret.find(b"HASH=")!=0:
+                    return None
+                blocks += ret.split(b"=",1)[-1].strip().decode("utf-8").split(",")
+        return size, digest, blocks
+
+    def sync_file(self, data:bytes, file_path:str, block_size:int=4096, **kwargs) -> bool:
+        """Puts a file on device only if its content differs. If file has the same size
+        on device, only the blocks that changed are sent.
+        
+        Parameters:
+            data(bytes): file content.
+            file_path(str): target path.
+            block_size(int): size of blocks compared for partial updates (default: 4096).
+            kwargs: transfer options passed to put_file.
+        
+        Returns:
+            bool: True if file is up to date, False otherwise.
+        """
+        remote = self.hash_file(file_path)
+        if remote is None or remote[0] != len(data):
+            return self.put_file(data, file_path, **kwargs)
+        if remote[1] == hashlib.sha256(data).hexdigest():
+            return True
+        if len(data) <= block_size:
+            return self.put_file(data, file_path, **kwargs)
+        remote = self.hash_file(file_path, block_size)
+        if remote is None:
+            return self.put_file(data, file_path, **kwargs)
+        # consecutive changed blocks are sent together
+        runs = []
+        for n, digest in enumerate(remote[2]):
+            block = data[n*block_size:(n+1)*block_size]
+            if hashlib.sha256(block).hexdigest() == digest: continue
+            if runs and runs[-1][1] == n*block_size:
+                runs[-1][1] += len(block)
+            else:
+                runs.append([n*block_size, n*block_size + len(block)])
+        return all(self.put_file(data[start:end], file_path, offset=start, **kwargs) for start, end in runs)
+
+    def update_firmware(self, image:bytes, window:int=4) -> bool:
+        """Writes a firmware image to the inactive app partition of device. If image
+        is complete and valid, device restarts on it; it goes back to previous firmware
+        if new one fails to start.
+        
+        Parameters:
+            image(bytes): firmware image (.bin file produced by build).
+            window(int): number of binary frames sent ahead of acknowledgments (default: 4).
+        
+        Returns:
+            bool: True if device accepted image, False otherwise.
+        """
+        cmd = "AT+OTA={size},{hash}".format(size=len(image), hash=hashlib.sha256(image).hexdigest())
+        if window > 0:
+            cmd += ",{}".format(window)
+        if not self._send_blocks(self._serial_ask(cmd.encode("utf-8")), image):
+            return False
+        # firmware restarts at default baud rate
+        self._ser.baudrate = 115200
+        self._ser.rtscts = False
+        return True
+
     def delete(self, path:str) -> bool:
         """Deletes a file or directory on device.
         
@@ -352,10 +909,33 @@ class Device():
         Returns:
             bool: True if operation succeeded, False otherwise.
         """
-        cmd = "AT+SETCONF={ns},{key},{val_type},{value}"\
-               .format(ns=ns, key=key, val_type=val_type, value=value).encode("utf-8")
+        cmd = "{cmd}={ns},{key},{val_type},{value}"\
+               .format(cmd="AT+SETCONFBATCH" if self._conf_batch else "AT+SETCONF",
+                       ns=ns, key=key, val_type=val_type, value=value).encode("utf-8")
         return self._serial_ask(cmd).find(b"OK")==0
 
+    def begin_conf_batch(self) -> bool:
+        """Starts a configuration batch: keys set with set_conf are checked by device
+        right away, but only written by commit_conf_batch, with one flash commit
+        per namespace.
+        
+        Returns:
+            bool: True if device supports batches, False otherwise (set_conf then
+                  writes keys immediately).
+        """
+        self._conf_batch = self._serial_ask(b"AT+SETCONFBATCH=BEGIN").find(b"OK")==0
+        return self._conf_batch
+
+    def commit_conf_batch(self) -> bool:
+        """Writes keys set since begin_conf_batch.
+        
+        Returns:
+            bool: True if all keys could be written (or no batch was started), False otherwise.
+        """
+        if not self._conf_batch: return True
+        self._conf_batch = False
+        return self._serial_ask(b"AT+SETCONFBATCH=COMMIT").find(b"OK")==0
+
     def del_conf(self, ns:str, key:str) -> bool:
         """Deletes configuration key from device.
         
@@ -369,6 +949,192 @@ class Device():
         cmd = "AT+DELCONF={ns},{key}".format(ns=ns, key=key).encode("utf-8")
         return self._serial_ask(cmd).find(b"OK")==0
     
+    def reload_conf(self) -> bool:
+        """Makes device apply configuration and image files again, e.g. after changes
+        made by other means than serial commands.
+        
+        Returns:
+            bool: True if successful, False otherwise.
+        """
+        return self._serial_ask(b"AT+RELOAD").find(b"OK")==0
+    
+    def dump_conf(self) -> bytes:
+        """Gets all configuration keys of device as one blob, which load_conf can write
+        back to this device or to another one.
+        
+        Returns:
+            bytes: configuration blob, or None if transfer failed.
+        """
+        self._serial_write(b"AT+DUMPCONF")
+        nb_str = self._serial_read_line()
+        if nb_str is None or nb_str.find(b"SIZE=")!=0:
+            return None
+        nbytes = int(nb_str.split(b"=",1)[-1].strip())
+        data = self._serial_read_frames()
+        if data is None or len(data)!=nbytes:
+            return None
+        return data
+
+    def load_conf(self, blob:bytes, window:int=4) -> bool:
+        """Writes configuration keys from a blob made by dump_conf. Keys absent from
+        blob are kept.
+        
+        Parameters:
+            blob(bytes): configuration blob.
+            window(int): number of binary frames sent ahead of acknowledgments (default: 4).
+        
+        Returns:
+            bool: True if all keys could be written, False otherwise.
+        """
+        cmd = "AT+LOADCONF={}".format(len(blob))
+        if window > 0:
+            cmd += ",{}".format(window)
+        return self._send_blocks(self._serial_ask(cmd.encode("utf-8")), blob)
+    
+    @staticmethod
+    def _decode_screen(data:bytes, width:int, height:int) -> bytearray:
+        """Decodes a screen snapshot coded row by row with runs: control byte c < 0x80
+        is followed by c+1 literal RGB pixels, c < 0xc0 repeats the pixel on the left
+        c-0x7f times, and c >= 0xc0 copies c-0xbf pixels from the row above.
+        
+        Parameters:
+            data(bytes): coded snapshot.
+            width(int): screen width.
+            height(int): screen height.
+        
+        Returns:
+            bytearray: RGB pixels, row by row, or None if data is malformed.
+        """
+        pixels = bytearray(3*width*height)
+        stride = 3*width
+        pos = 0 # position in data
+        n = 0 # position in pixels
+        while n < len(pixels):
+            if pos >= len(data): return None
+            c = data[pos]
+            pos += 1
+            if c < 0x80:
+                size = 3*(c + 1)
+                src = data[pos:pos+size]
+                pos += size
+            elif c < 0xc0:
+                if n % stride == 0: return None # nothing on the left
+                size = 3*(c - 0x7f)
+                src = pixels[n-3:n]*(c - 0x7f)
+            else:
+                if n < stride: return None # no row above
+                size = 3*(c - 0xbf)
+                src = pixels[n-stride:n-stride+size]
+            if len(src) != size or n + size > len(pixels): return None
+            pixels[n:n+size] = src
+            n += size
+        return pixels
+
+    @staticmethod
+    def _encode_png(pixels:bytes, width:int, height:int) -> bytes:
+        """Packs RGB pixels into a PNG image.
+        
+        Parameters:
+            pixels(bytes): RGB pixels, row by row.
+            width(int): image width.
+            height(int): image height.
+        
+        Returns:
+            bytes: PNG image.
+        """
+        def chunk(tag:bytes, body:bytes) -> bytes:
+            return struct.pack(">I", len(body)) + tag + body + struct.pack(">I", zlib.crc32(tag + body))
+        stride = 3*width
+        # each row is preceded by its filter type (0, none)
+        raw = b"".join(b"\x00" + pixels[y*stride:(y+1)*stride] for y in range(height))
+        return b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)) \
+               + chunk(b"IDAT", zlib.compress(raw, 9)) + chunk(b"IEND", b"")
+
+    def get_screenshot(self) -> bytes:
+        """Captures what device screen shows.
+        
+        Returns:
+            bytes: PNG image, or None if capture failed.
+        """
+        self._serial_write(b"AT+SCREENSHOT")
+        size_str = self._serial_read_line()
+        if size_str is None or size_str.find(b"SCREEN=")!=0:
+            return None
+        width, height = (int(v) for v in size_str.split(b"=",1)[-1].strip().split(b","))
+        data = self._serial_read_frames()
+        if data is None:
+            self._abort_frames()
+            return None
+        pixels = self._decode_screen(data, width, height)
+        if pixels is None:
+            return None
+        return self._encode_png(pixels, width, height)
+    
+    def touch(self, x:int, y:int, duration:int=100) -> bool:
+        """Injects a touch event, as if it came from touch panel. Firmware must be built
+        with input injection.
+        
+        Parameters:
+            x(int): X position, in screen coordinates.
+            y(int): Y position, in screen coordinates.
+            duration(int): press duration, in milliseconds.
+        
+        Returns:
+            bool: True if event was injected, False otherwise.
+        """
+        cmd = "AT+TOUCH={},{},{}".format(x, y, duration).encode("utf-8")
+        return self._serial_ask_reply(cmd) == b"OK" + self._termchar
+
+    def set_pot(self, idx:int, value:int=None) -> bool:
+        """Forces value of a potentiometer (0 or 1), as if its pin read it.
+        Firmware must be built with input injection.
+        
+        Parameters:
+            idx(int): potentiometer index.
+            value(int): raw value, or None to go back to measurements.
+        
+        Returns:
+            bool: True if value was set, False otherwise.
+        """
+        arg = str(idx) if value is None else "{},{}".format(idx, value)
+        return self._serial_ask_reply(b"AT+SETPOT=" + arg.encode("utf-8")) == b"OK" + self._termchar
+
+    def get_trace(self) -> tuple:
+        """Gets stage delays of last injected input event. Firmware must be built with
+        input injection.
+        
+        Returns:
+            tuple: delays until input driver read, WebSocket queueing and WebSocket send,
+            in microseconds (None for stages not reached yet), or None if nothing was traced.
+        """
+        self._serial_write(b"AT+GETTRACE")
+        while True:
+            line = self._serial_read_line()
+            if line is None or line.startswith((b"ERROR", b"UNKN")): return None
+            if line.startswith(b"TRACE="): break
+        delays = (int(v) for v in line.split(b"=",1)[-1].strip().split(b","))
+        return tuple(d if d >= 0 else None for d in delays)
+
+    def bench_image(self, fpath:str, mode:int=1) -> tuple:
+        """Decodes a PNG image on device and measures load time. Firmware must be built
+        with image load benchmark.
+        
+        Parameters:
+            fpath (str): image file path on device.
+            mode (int): 0 to read file directly, 1 through emptied block cache, 2 through
+            block cache as left by previous loads.
+        
+        Returns:
+            tuple: load time in microseconds, number of file system reads, bytes read from
+            file system, cache hits and cache misses, or None if image couldn't be loaded.
+        """
+        self._serial_write("AT+BENCHIMG={},{}".format(fpath, mode).encode("utf-8"))
+        while True:
+            line = self._serial_read_line()
+            if line is None or line.startswith((b"ERROR", b"UNKN")): return None
+            if line.startswith(b"BENCHIMG="): break
+        return tuple(int(v) for v in line.split(b"=",1)[-1].strip().split(b","))
+
     def get_firmware_version(self) -> str:
         """Gets device firmware version.
         
@@ -376,3 +1142,15 @@ class Device():
             str: firmware version string.
         """
         return self._serial_ask(b"AT+GETFWVER")
+
+    def get_alloc_count(self) -> int:
+        """Gets number of memory allocations made by previous command. Firmware must be
+        built with allocation tracing.
+        
+        Returns:
+            int: number of allocations, or None if firmware doesn't count them.
+        """
+        buf = self._serial_ask(b"AT+GETALLOCS")
+        if buf.find(b"ALLOCS=") != 0:
+            return None
+        return int(buf.split(b"=",1)[-1].strip())
@@ -0,0 +1,145 @@
+#!python3
+'''This script relays obs-websocket messages between the device, connected by USB,
+and OBS instances reachable from the host (typically on localhost).
+On the device, set key 'transport' to 1 in the 'websocket' namespace (or 'websocket_n'
+for connection n) so that this connection goes through the serial link.
+Messages travel on the serial link as lines '+OBS:n,message', with n the connection index;
+other lines (AT command replies, logs) are ignored.
+Run the script without arguments to see detailed usage instructions.
+'''
+from serial import Serial
+import websocket
+import sys, getopt
+import threading
+import time
+
+err = False # set to True if and error occurs
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:],"hp:o:",["port=","obs=","baud="])
+except getopt.GetoptError:
+    err = True
+
+# default values
+ser_port = None
+baud_rate = None # negotiated by Device if not given
+obs_urls = {} # connection index -> OBS URL
+
+for opt, arg in opts:
+    try:
+        if opt in ("-p", "--port"):
+            ser_port = arg
+        elif opt in ("-o", "--obs"):
+            idx, url = arg.split(":", 1) if arg[0].isdigit() else ("0", arg)
+            obs_urls[int(idx)] = url
+        elif opt == "--baud":
+            baud_rate = int(arg)
+        elif opt == "-h":
+            err = True
+    except ValueError:
+        err = True
+
+if err:
+    print("Usage: {scrname} -p port -o [n:]url".format(scrname=sys.argv[0]))
+    print("Optional arguments:")
+    print("  -h                        display help")
+    print("  -p port, --port=port      serial port of the device (default: first device found)")
+    print("  -o [n:]url, --obs=[n:]url OBS URL for connection n (default: 0:ws://localhost:4455); can be repeated")
+    print("  --baud=rate               serial baud rate (default: fastest supported, or 115200 with -p)")
+    sys.exit(2)
+
+if len(obs_urls) == 0:
+    obs_urls[0] = "ws://localhost:4455"
+
+prefix = b"+OBS:"
+termchar = b"\r"
+
+if ser_port is None:
+    from device import Device
+    ser = Device(baud_rates=None if baud_rate is None else [baud_rate])._ser
+    if ser is None:
+        print("No device found.")
+        sys.exit(1)
+else:
+    ser = Serial(ser_port, baud_rate or 115200)
+ser_lock = threading.Lock()
+
+
+def to_device(idx: int, message: str) -> None:
+    """Sends a message to the device as a tunnel frame.
+
+    Parameters:
+        idx(int): connection index
+        message(str): obs-websocket message
+    """
+    frame = prefix + str(idx).encode() + b"," + message.encode("utf-8") + termchar
+    with ser_lock:
+        ser.write(frame)
+
+
+class OBSLink():
+    """Connection to an OBS instance, reopened whenever it drops.
+
+    Attributes:
+        idx(int): connection index on device
+        url(str): OBS URL
+        ws(websocket.WebSocket): WebSocket connection (None if disconnected)
+    """
+
+    def __init__(self, idx: int, url: str):
+        """Constructor.
+
+        Parameters:
+            idx(int): connection index on device
+            url(str): OBS URL
+        """
+        self.idx = idx
+        self.url = url
+        self.ws = None
+        threading.Thread(target=self.run, daemon=True).start()
+
+    def run(self) -> None:
+        """Receives messages from OBS and forwards them to the device."""
+        while True:
+            try:
+                self.ws = websocket.create_connection(self.url)
+                print("Connection {i}: connected to {u}".format(i=self.idx, u=self.url))
+                # device answers obs-websocket Hello with Identify on its own
+                while True:
+                    to_device(self.idx, self.ws.recv())
+            except (OSError, websocket.WebSocketException) as e:
+                print("Connection {i}: {e}; retrying".format(i=self.idx, e=e))
+            self.ws = None
+            time.sleep(1)
+
+    def send(self, message: str) -> None:
+        """Sends a message to OBS.
+
+        Parameters:
+            message(str): obs-websocket message
+        """
+        if self.ws is None:
+            print("Connection {i}: not connected; message dropped".format(i=self.idx))
+            return
+        try:
+            self.ws.send(message)
+        except (OSError, websocket.WebSocketException):
+            pass
+
+
+links = {idx: OBSLink(idx, url) for idx, url in obs_urls.items()}
+
+buffer = b""
+while True:
+    buffer += ser.read(max(1, ser.in_waiting))
+    *lines, buffer = buffer.split(termchar)
+    for line in lines:
+        # log output may precede a frame on the same line
+        line = line.rsplit(b"\n", 1)[-1]
+        if not line.startswith(prefix):
+            continue
+        idx, _, message = line[len(prefix):].partition(b",")
+        try:
+            links[int(idx)].send(message.decode("utf-8"))
+        except (ValueError, KeyError):
+            print("Frame for unknown connection {}".format(idx))
@@ -0,0 +1,69 @@
+#!python3
+'''This script updates the ESP32 firmware over the serial link, without flash mode.
+The image is written to the inactive app partition while the current firmware runs;
+the device then restarts on it, and goes back to the previous firmware if the new one
+doesn't start properly. Use it with the image produced by the build:
+
+    ota_update.py -f build/esp_obs_cmd.bin
+
+Run the script with -h to see detailed usage instructions.
+'''
+from mcp2221 import find_devices
+from device import Device
+import sys, getopt
+import time
+
+err = False # set to True if and error occurs
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:],"hd:f:w:",["devidx=","file=","window="])
+except getopt.GetoptError:
+    err = True
+
+# default values
+devidx = None # device index
+fname = None # firmware image
+window = 4 # binary transfer window
+
+for opt, arg in opts:
+    try:
+        if opt in ("-d", "--devidx"):
+            devidx = int(arg)
+        elif opt in ("-f", "--file"):
+            fname = arg
+        elif opt in ("-w", "--window"):
+            window = int(arg)
+        elif opt == "-h":
+            err = True
+    except ValueError:
+        err = True
+
+if err or fname is None:
+    print("Usage: {scrname} -f file".format(scrname=sys.argv[0]))
+    print("Optional arguments:")
+    print("  -h                           display help")
+    print("  -d devidx, --devidx=devidx   take device with index devidx")
+    print("  -f file, --file=file         firmware image")
+    print("  -w window, --window=window   number of binary frames in flight (default: 4)")
+    sys.exit(2)
+
+try:
+    with open(fname, "rb") as f:
+        image = f.read()
+except IOError:
+    print("File {} couldn't be found.".format(fname))
+    sys.exit(1)
+
+dev = Device(find_devices()[devidx]) if devidx is not None else Device()
+if dev._ser is None:
+    print("No device found.")
+    sys.exit(1)
+dev._buf_size = dev._get_buffer_size() or dev._buf_size
+
+print("Current firmware: {}".format(dev.get_firmware_version().decode("utf-8", "replace").strip()))
+print("Sending {} bytes...".format(len(image)))
+t0 = time.perf_counter()
+if not dev.update_firmware(image, window):
+    print("Firmware update failed; device keeps current firmware.")
+    sys.exit(1)
+print("Image accepted in {:.1f} s; device restarts.".format(time.perf_counter() - t0))
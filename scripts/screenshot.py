@@ -0,0 +1,52 @@
+#!python3
+'''This script saves what the device screen shows as a PNG image (AT+SCREENSHOT).
+Run the script with -h to see detailed usage instructions.
+'''
+from mcp2221 import find_devices
+from device import Device
+import sys, getopt
+import time
+
+err = False # set to True if and error occurs
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:],"hd:o:",["devidx=","ofile="])
+except getopt.GetoptError:
+    err = True
+
+# default values
+devidx = None # device index
+ofile = "screenshot.png" # output file
+
+for opt, arg in opts:
+    try:
+        if opt in ("-d", "--devidx"):
+            devidx = int(arg)
+        elif opt in ("-o", "--ofile"):
+            ofile = arg
+        elif opt == "-h":
+            err = True
+    except ValueError:
+        err = True
+
+if err:
+    print("Usage: {scrname} -d devidx -o ofile".format(scrname=sys.argv[0]))
+    print("Optional arguments:")
+    print("  -h                           display help")
+    print("  -d devidx, --devidx=devidx   take device with index devidx")
+    print("  -o fname, --ofile=fname      output file (default: screenshot.png)")
+    sys.exit(2)
+
+dev = Device(find_devices()[devidx]) if devidx is not None else Device()
+if dev._ser is None:
+    print("No device found.")
+    sys.exit(1)
+
+t0 = time.perf_counter()
+png = dev.get_screenshot()
+if png is None:
+    print("Couldn't capture screen.")
+    sys.exit(1)
+with open(ofile, "wb") as f:
+    f.write(png)
+print("Saved screenshot to {f} in {t:.2f} s.".format(f=ofile, t=time.perf_counter() - t0))
@@ -0,0 +1,81 @@
+#!python3
+'''This script checks partial file updates (Device.sync_file) on a device. It writes a
+test file of several blocks, then changes blocks in various patterns (first block only,
+a middle block, last block, first and last blocks), syncs the file and reads it back;
+each case passes if the file read back matches the new content, size included.
+The test file is deleted at the end.
+Run the script with -h to see detailed usage instructions.
+'''
+from mcp2221 import find_devices
+from device import Device
+import sys, getopt
+import random
+
+err = False # set to True if and error occurs
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:],"hd:f:b:",["devidx=","fpath=","block="])
+except getopt.GetoptError:
+    err = True
+
+# default values
+devidx = None # device index
+fpath = "test_sync.bin" # test file path on device
+block_size = 4096 # compared block size
+nblocks = 4 # number of blocks in test file
+
+for opt, arg in opts:
+    try:
+        if opt in ("-d", "--devidx"):
+            devidx = int(arg)
+        elif opt in ("-f", "--fpath"):
+            fpath = arg
+        elif opt in ("-b", "--block"):
+            block_size = int(arg)
+        elif opt == "-h":
+            err = True
+    except ValueError:
+        err = True
+
+if err:
+    print("Usage: {scrname} -d devidx -f fpath -b block_size".format(scrname=sys.argv[0]))
+    print("Optional arguments:")
+    print("  -h                           display help")
+    print("  -d devidx, --devidx=devidx   take device with index devidx")
+    print("  -f fpath, --fpath=fpath      test file path on device (default: test_sync.bin)")
+    print("  -b size, --block=size        compared block size (default: 4096)")
+    sys.exit(2)
+
+dev = Device(find_devices()[devidx]) if devidx is not None else Device()
+if dev._ser is None:
+    print("No device found.")
+    sys.exit(1)
+
+
+def changed(data:bytes, blocks:tuple) -> bytes:
+    """Gives a copy of data with given blocks replaced by random bytes."""
+    data = bytearray(data)
+    for n in blocks:
+        data[n*block_size:(n+1)*block_size] = random.randbytes(len(data[n*block_size:(n+1)*block_size]))
+    return bytes(data)
+
+
+# last block is shorter, so that a truncated file can't pass for a full one
+size = nblocks*block_size - block_size//2
+cases = (("first block", (0,)), ("middle block", (nblocks//2,)),
+         ("last block", (nblocks - 1,)), ("first and last blocks", (0, nblocks - 1)))
+data = random.randbytes(size)
+if not dev.put_file(data, fpath, compress=False):
+    print("Couldn't write test file.")
+    sys.exit(1)
+failed = 0
+for name, blocks in cases:
+    data = changed(data, blocks)
+    ok = dev.sync_file(data, fpath, block_size, compress=False) and dev.get_file(fpath) == data
+    print("{:<24} {}".format(name, "passed" if ok else "FAILED"))
+    if not ok:
+        failed += 1
+        # next case starts from known content
+        dev.put_file(data, fpath, compress=False)
+dev.delete(fpath)
+sys.exit(1 if failed else 0)
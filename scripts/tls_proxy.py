@@ -0,0 +1,167 @@
+#!python3
+'''This script is a TLS-terminating stand-in for an obs-websocket server behind a TLS proxy.
+It accepts wss:// connections on given host:port and forwards decrypted traffic to
+a plain WebSocket server (OBS, or test_ws_server.py).
+With --bench, it instead connects repeatedly to a TLS server and measures handshake
+times with full handshakes and with session resumption.
+Run the script without arguments to see detailed usage instructions.
+A self-signed certificate can be generated with:
+  openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -nodes -days 3650 \\
+    -subj "/CN=host" -keyout key.pem -out cert.pem
+with host replaced by the host name or address set on device, which checks it.
+Upload cert.pem to the device and set its path in key 'cert' of the 'websocket' namespace.
+'''
+import socket
+import ssl
+import sys, getopt
+import threading
+import time
+import statistics
+
+err = False # set to True if and error occurs
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:],"h:p:",["host=","port=","cert=","key=","backend=","bench=","tls12"])
+except getopt.GetoptError:
+    err = True
+
+# default values
+host = None
+port = 4456
+cert = None
+key = None
+backend = ("127.0.0.1", 4455)
+bench = 0
+tls12 = False
+
+for opt, arg in opts:
+    try:
+        if opt in ("-h", "--host"):
+            host = arg
+        elif opt in ("-p", "--port"):
+            port = int(arg)
+        elif opt == "--cert":
+            cert = arg
+        elif opt == "--key":
+            key = arg
+        elif opt == "--backend":
+            bk_host, bk_port = arg.rsplit(":", 1)
+            backend = (bk_host, int(bk_port))
+        elif opt == "--bench":
+            bench = int(arg)
+        elif opt == "--tls12":
+            tls12 = True
+    except ValueError:
+        err = True
+
+if err or host is None or cert is None or (bench == 0 and key is None):
+    print("Usage: {scrname} -h host -p port --cert=cert.pem --key=key.pem".format(scrname=sys.argv[0]))
+    print("       {scrname} -h host -p port --cert=cert.pem --bench=count".format(scrname=sys.argv[0]))
+    print("Required arguments:")
+    print("  -h host, --host=host      host name on which to listen (proxy) or to connect to (bench)")
+    print("  --cert=cert.pem           server certificate (PEM)")
+    print("  --key=key.pem             server private key (PEM), for proxy mode")
+    print("Optional arguments:")
+    print("  -p port, --port=port      host port (numeric value, default 4456)")
+    print("  --backend=host:port       plain WebSocket server to forward to (default 127.0.0.1:4455)")
+    print("  --bench=count             measure count handshakes with and without session resumption")
+    print("  --tls12                   limit to TLS 1.2 (as negotiated by ESP-IDF 4.4 by default)")
+    sys.exit(2)
+
+
+def forward(src: socket.socket, dst: socket.socket):
+    """Copies data from a socket to another until either side closes.
+
+    Parameters:
+        src(socket.socket): socket to read from
+        dst(socket.socket): socket to write to
+    """
+    try:
+        while True:
+            data = src.recv(4096)
+            if not data:
+                break
+            dst.sendall(data)
+    except OSError:
+        pass
+    for s in (src, dst):
+        try:
+            s.shutdown(socket.SHUT_RDWR)
+        except OSError:
+            pass
+
+
+def serve():
+    """Accepts TLS connections and forwards them to backend server."""
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    ctx.load_cert_chain(cert, key)
+    if tls12:
+        ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+    with socket.create_server((host, port)) as srv:
+        print("Forwarding wss://{h}:{p} to ws://{bh}:{bp}".format(h=host, p=port, bh=backend[0], bp=backend[1]))
+        while True:
+            conn, addr = srv.accept()
+            t0 = time.perf_counter()
+            try:
+                tconn = ctx.wrap_socket(conn, server_side=True)
+            except (ssl.SSLError, OSError) as e:
+                print("{}: handshake failed ({})".format(addr[0], e))
+                conn.close()
+                continue
+            dt = (time.perf_counter() - t0)*1000
+            print("{a}: {v} handshake in {t:.1f}ms, resumed={r}".format(
+                a=addr[0], v=tconn.version(), t=dt, r=tconn.session_reused))
+            bconn = socket.create_connection(backend)
+            threading.Thread(target=forward, args=(tconn, bconn), daemon=True).start()
+            threading.Thread(target=forward, args=(bconn, tconn), daemon=True).start()
+
+
+def handshake(ctx: ssl.SSLContext, session: ssl.SSLSession = None) -> tuple:
+    """Opens a TLS connection, performs a WebSocket upgrade and closes it.
+
+    Parameters:
+        ctx(ssl.SSLContext): client context
+        session(ssl.SSLSession): session to resume (None for full handshake)
+
+    Returns:
+        tuple: handshake time in ms, session, True if session was resumed
+    """
+    sock = socket.create_connection((host, port))
+    t0 = time.perf_counter()
+    tsock = ctx.wrap_socket(sock, server_hostname=host, session=session)
+    dt = (time.perf_counter() - t0)*1000
+    # tickets are sent after handshake with TLS 1.3; exchange some data to get them
+    tsock.sendall("GET / HTTP/1.1\r\nHost: {h}\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                  "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n".format(h=host).encode())
+    tsock.recv(1024)
+    result = (dt, tsock.session, tsock.session_reused)
+    tsock.close()
+    return result
+
+
+def run_bench():
+    """Measures handshake times with and without session resumption."""
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    ctx.load_verify_locations(cert)
+    # only handshake time is measured; host name is checked on device
+    ctx.check_hostname = False
+    if tls12:
+        ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+    full = [handshake(ctx)[0] for n in range(bench)]
+    _, session, _ = handshake(ctx)
+    resumed = []
+    reused = 0
+    for n in range(bench):
+        dt, session, was_reused = handshake(ctx, session)
+        resumed.append(dt)
+        reused += was_reused
+    for name, values in (("full", full), ("resumed", resumed)):
+        print("{n:8s}: mean={m:.2f}ms median={md:.2f}ms min={mn:.2f}ms max={mx:.2f}ms".format(
+            n=name, m=statistics.mean(values), md=statistics.median(values), mn=min(values), mx=max(values)))
+    print("{r}/{c} handshakes resumed".format(r=reused, c=bench))
+
+
+if bench > 0:
+    run_bench()
+else:
+    serve()
@@ -105,6 +105,8 @@ if fname is not None:
         print("  {}".format(e))
         sys.exit(1)
 
+    # keys are written together at the end
+    dev.begin_conf_batch()
 
     # parse WiFi options
     if wifi_str in data:
@@ -118,20 +120,28 @@ if fname is not None:
         dev.set_conf(wifi_str, "password", data[wifi_str]["password"], NVSType.Str)
 
 
-    # parse WebSocket options
+    # parse WebSocket options; a list defines several connections,
+    # stored in namespaces websocket, websocket_1, websocket_2, ...
     if ws_str in data:
         print("Processing WebSocket options...")
-        if not has_keys(data[ws_str], ["host", "port"]):
-            print("WebSocket server - mandatory properties:")
-            print("  host: WebSocket host address")
-            print("  port: WebSocket host port")
-            print("Optional properties:")
-            print("  path: path on WebSocket host")
-            sys.exit(1)
-        dev.set_conf(ws_str, "host", data[ws_str]["host"], NVSType.Str)
-        dev.set_conf(ws_str, "port", data[ws_str]["port"], NVSType.U16)
-        if "path" in data[ws_str]:
-            dev.set_conf(ws_str, "path", data[ws_str]["path"], NVSType.Str)
+        ws_list = data[ws_str] if isinstance(data[ws_str], list) else [data[ws_str]]
+        for n, ws in enumerate(ws_list):
+            if not has_keys(ws, ["host", "port"]):
+                print("WebSocket server - mandatory properties:")
+                print("  host: WebSocket host address")
+                print("  port: WebSocket host port")
+                print("Optional properties:")
+                print("  path: path on WebSocket host")
+                print("  password: obs-websocket server password")
+                print("Several servers can be given as a list; commands are routed with 'targets'.")
+                sys.exit(1)
+            ws_idx = ws_str if n == 0 else "{ws}_{idx}".format(ws=ws_str, idx=n)
+            dev.set_conf(ws_idx, "host", ws["host"], NVSType.Str)
+            dev.set_conf(ws_idx, "port", ws["port"], NVSType.U16)
+            if "path" in ws:
+                dev.set_conf(ws_idx, "path", ws["path"], NVSType.Str)
+            if "password" in ws:
+                dev.set_conf(ws_idx, "password", ws["password"], NVSType.Str)
     
     
     # parse screen options
@@ -193,6 +203,8 @@ if fname is not None:
                 print("    filename: name of picture file on computer")
                 print("    target: target path on device")
                 print("  command_off: command issued when button is toggled off")
+                print("Optional properties:")
+                print("  targets: list of OBS connections receiving commands (default: [0])")
                 sys.exit(1)
             
             bt_idx = "{bt}_{idx}".format(bt=bt_str[:-1], idx=button["index"])
@@ -202,7 +214,7 @@ if fname is not None:
                 try:
                     print("  --> {}".format(img["filename"]))
                     with open(img["filename"], "rb") as f:
-                        if not dev.put_file(f.read(), img["target"]):
+                        if not dev.sync_file(f.read(), img["target"]):
                             print("File {fname} couldn't be transferred to {target}.".format(fname=img["filename"], target=img["target"]))
                             sys.exit(1)
                 except IOError:
@@ -223,6 +235,8 @@ if fname is not None:
                     sys.exit(1)
                 for cmp in ["r", "g", "b", "a"]:
                     dev.set_conf(bt_idx, "event_color_{}".format(cmp), button["event_color"][cmp], NVSType.U8)
+            if "targets" in button:
+                dev.set_conf(bt_idx, "targets", sum(1 << t for t in button["targets"]), NVSType.U8)
             
 
     # parse potentiometers options
@@ -239,6 +253,7 @@ if fname is not None:
                 print("  divider: divider for obs_min and obs_max values")
                 print("  bg_color: {r: red, g: green, b: blue, a: alpha}, background color; each component is 8-bit.")
                 print("  fg_color: {r: red, g: green, b: blue, a: alpha}, foreground color; each component is 8-bit.")
+                print("  targets: list of OBS connections receiving commands (default: [0])")
                 sys.exit(1)
         
             pot_idx = "{pot}_{idx}".format(pot=pot_str[:-1], idx=pot["index"])
@@ -247,6 +262,8 @@ if fname is not None:
             dev.set_conf(pot_idx, "command", pot["command"], NVSType.Str)
             if "divider" in pot:
                 dev.set_conf(pot_idx, "divider", pot["divider"], NVSType.U16)
+            if "targets" in pot:
+                dev.set_conf(pot_idx, "targets", sum(1 << t for t in pot["targets"]), NVSType.U8)
             for col_str in ["bg_color", "fg_color"]:
                 if col_str in pot:
                     if not has_keys(pot[col_str], ["r", "g", "b", "a"]):
@@ -258,6 +275,9 @@ if fname is not None:
                         dev.set_conf(pot_idx, "{col}_{cmp}".format(col=col_str, cmp=cmp), pot[col_str][cmp], NVSType.U8)
             
 
+    if not dev.commit_conf_batch():
+        print("Configuration keys couldn't be written.")
+        sys.exit(1)
 
 if with_icons:
     print("Uploading icons for battery and WiFi indicators...")
@@ -266,7 +286,7 @@ if with_icons:
             path = "{path}/{fname}.png".format(path=img_path, fname=fname)
             print("  --> {}".format(path))
             with open(path, "rb") as f:
-                if not dev.put_file(f.read(), path.replace("{}_".format(icons_color),"")):
+                if not dev.sync_file(f.read(), path.replace("{}_".format(icons_color),"")):
                     print("File {fname} couldn't be transferred.".format(fname=path))
                     sys.exit(1)
         except IOError: